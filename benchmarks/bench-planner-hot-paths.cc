@@ -0,0 +1,203 @@
+// Copyright (c) 2017, LAAS-CNRS
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+// Microbenchmarks of the planner hot paths:
+// - Edge::applyConstraints,
+// - Graph::chooseEdge,
+// - Roadmap::nearestNode,
+// - GraphPathValidation::validate,
+// and, when BENCHMARK_UR5 is set, an end-to-end
+// ManipulationPlanner::solve scenario on the UR5 robot used by the
+// tests.
+//
+// Each benchmark is run in batches calibrated to last around 10ms; the
+// reported ns/op is the median over the batches so that a stray
+// scheduler preemption does not skew the figure.
+
+#include <cstdio>
+#include <algorithm>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <hpp/core/path.hh>
+#include <hpp/core/path-vector.hh>
+#include <hpp/core/steering-method.hh>
+
+#include <hpp/manipulation/device.hh>
+#include <hpp/manipulation/problem.hh>
+#include <hpp/manipulation/roadmap.hh>
+#include <hpp/manipulation/roadmap-node.hh>
+#include <hpp/manipulation/connected-component.hh>
+#include <hpp/manipulation/graph-path-validation.hh>
+#include <hpp/manipulation/manipulation-planner.hh>
+#include <hpp/manipulation/graph/graph.hh>
+#include <hpp/manipulation/graph/state.hh>
+#include <hpp/manipulation/graph/state-selector.hh>
+#include <hpp/manipulation/graph/edge.hh>
+
+#ifdef BENCHMARK_UR5
+# include <hpp/pinocchio/urdf/util.hh>
+#endif
+
+using namespace hpp::manipulation;
+
+namespace {
+  DevicePtr_t robot;
+  ProblemPtr_t problem;
+  graph::GraphPtr_t graph_;
+  graph::StatePtr_t s1, s2;
+  graph::EdgePtr_t e12;
+  RoadmapPtr_t roadmap;
+  RoadmapNodePtr_t node;
+  ConnectedComponentPtr_t cc;
+  Configuration_t q1, q2, qProj;
+  ConfigurationPtr_t q1Ptr, q2Ptr;
+  hpp::core::PathPtr_t path;
+
+  void setup ()
+  {
+    robot = Device::create ("bench-robot");
+#ifdef BENCHMARK_UR5
+    hpp::pinocchio::urdf::loadRobotModel
+      (robot, "anchor", "ur_description", "ur5_robot", "", "");
+#endif
+    problem = new Problem (robot);
+
+    graph_ = graph::Graph::create ("bench-graph", robot, problem);
+    graph_->maxIterations (20);
+    graph_->errorThreshold (1e-4);
+    graph::StateSelectorPtr_t ss =
+      graph_->createStateSelector ("state-selector");
+    s1 = ss->createState ("state 1");
+    s2 = ss->createState ("state 2");
+    s1->linkTo ("edge 11", s1);
+    s2->linkTo ("edge 21", s1);
+    e12 = s1->linkTo ("edge 12", s2);
+    s2->linkTo ("edge 22", s2);
+    problem->constraintGraph (graph_);
+    graph_->initialize ();
+
+    q1 = Configuration_t::Zero (robot->configSize ());
+    q2 = Configuration_t::Zero (robot->configSize ());
+#ifdef BENCHMARK_UR5
+    q1 << 1,1,1,0,2.5,-1.9;
+    q2 << 2,0,1,0,2.5,-1.9;
+#endif
+    qProj = q1;
+    q1Ptr = ConfigurationPtr_t (new Configuration_t (q1));
+    q2Ptr = ConfigurationPtr_t (new Configuration_t (q2));
+
+    roadmap = Roadmap::create (problem->distance (), robot);
+    roadmap->constraintGraph (graph_);
+    node = static_cast <RoadmapNodePtr_t> (roadmap->addNode (q1Ptr));
+    cc = HPP_STATIC_PTR_CAST (ConnectedComponent,
+        node->connectedComponent ());
+
+    path = (*problem->steeringMethod ())
+      (ConfigurationIn_t (q1), ConfigurationIn_t (q2));
+  }
+
+  typedef void (*BenchFunc_t) (std::size_t);
+
+  double batchSeconds (BenchFunc_t f, std::size_t iterations)
+  {
+    const boost::posix_time::ptime start =
+      boost::posix_time::microsec_clock::universal_time ();
+    f (iterations);
+    return (double) (boost::posix_time::microsec_clock::universal_time ()
+        - start).total_microseconds () * 1e-6;
+  }
+
+  void report (const char* name, BenchFunc_t f)
+  {
+    // Calibrate the batch size to around 10ms.
+    std::size_t n = 1;
+    while (batchSeconds (f, n) < 0.01 && n < (std::size_t (1) << 24))
+      n *= 2;
+    // Median over the batches: robust against preemptions.
+    const std::size_t nbBatches = 20;
+    std::vector <double> nsPerOp (nbBatches);
+    for (std::size_t b = 0; b < nbBatches; ++b)
+      nsPerOp[b] = batchSeconds (f, n) * 1e9 / (double) n;
+    std::sort (nsPerOp.begin (), nsPerOp.end ());
+    const double median = nsPerOp[nbBatches / 2];
+    std::printf ("%-35s %14.1f ns/op %14.0f ops/s %10lu iter/batch\n",
+        name, median, 1e9 / median, (unsigned long) n);
+  }
+
+  void benchApplyConstraints (std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      qProj = q2;
+      e12->applyConstraints (q1, qProj);
+    }
+  }
+
+  void benchChooseEdge (std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+      graph_->chooseEdge (node);
+  }
+
+  void benchNearestNode (std::size_t n)
+  {
+    value_type distance;
+    for (std::size_t i = 0; i < n; ++i)
+      roadmap->nearestNode (q2Ptr, cc, s1, distance);
+  }
+
+  void benchValidatePath (std::size_t n)
+  {
+    hpp::core::PathPtr_t validPart;
+    PathValidationReportPtr_t report;
+    GraphPathValidationPtr_t pv = problem->pathValidation ();
+    for (std::size_t i = 0; i < n; ++i)
+      pv->validate (path, false, validPart, report);
+  }
+
+#ifdef BENCHMARK_UR5
+  void benchSolve (std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      RoadmapPtr_t r = Roadmap::create (problem->distance (), robot);
+      r->constraintGraph (graph_);
+      problem->initConfig (q1Ptr);
+      problem->resetGoalConfigs ();
+      problem->addGoalConfig (q2Ptr);
+      ManipulationPlannerPtr_t planner =
+        ManipulationPlanner::create (*problem, r);
+      planner->solve ();
+    }
+  }
+#endif
+}
+
+int main ()
+{
+  setup ();
+
+  report ("Edge::applyConstraints", benchApplyConstraints);
+  report ("Graph::chooseEdge", benchChooseEdge);
+  report ("Roadmap::nearestNode", benchNearestNode);
+  report ("GraphPathValidation::validate", benchValidatePath);
+#ifdef BENCHMARK_UR5
+  report ("ManipulationPlanner::solve", benchSolve);
+#else
+  std::printf ("ManipulationPlanner::solve skipped "
+      "(set BENCHMARK_UR5 in cmake to activate it).\n");
+#endif
+  return 0;
+}
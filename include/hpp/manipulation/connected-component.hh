@@ -19,6 +19,8 @@
 #ifndef HPP_MANIPULATION_CONNECTED_COMPONENT_HH
 #define HPP_MANIPULATION_CONNECTED_COMPONENT_HH
 
+#include <boost/unordered_map.hpp>
+
 #include <hpp/core/connected-component.hh>
 #include <hpp/manipulation/config.hh>
 #include <hpp/manipulation/fwd.hh>
@@ -32,8 +34,14 @@ namespace hpp {
 class HPP_MANIPULATION_DLLAPI ConnectedComponent : public core::ConnectedComponent 
 { 
   public:
-      /// Map of graph states within the connected component
-      typedef std::map <graph::StatePtr_t, RoadmapNodes_t> GraphStates_t;
+      /// Map of graph states within the connected component.
+      /// Hash storage: lookups do not pay tree rebalancing and merges
+      /// move buckets instead of re-sorting.
+      typedef boost::unordered_map <graph::StatePtr_t, RoadmapNodes_t>
+        GraphStates_t;
+      /// Map of nearest-neighbor indexes, one per graph state
+      typedef boost::unordered_map <graph::StatePtr_t,
+        NearestNeighborIndexPtr_t> GraphStateIndices_t;
      
       ConnectedComponent() {}
 
@@ -43,18 +51,46 @@ class HPP_MANIPULATION_DLLAPI ConnectedComponent : public core::ConnectedCompone
       /// Merge two connected components (extension of core::ConnectedComponent::merge)
       /// \param other manipulation connected component to merge into this one.
       /// \note other will be empty after calling this method.
-      void merge (const core::ConnectedComponentPtr_t& otherCC); 
+      /// The per-state maps of the smaller side are folded into the
+      /// larger side (union-by-size), so the cost is close to the size
+      /// of the smaller component whatever side merge is called on.
+      /// Define HPP_MANIPULATION_CHECK_CONNECTED_COMPONENTS to re-enable
+      /// the consistency check assertion after each merge and insertion;
+      /// it rebuilds two full node sets and is far too expensive for
+      /// production debug builds.
+      void merge (const core::ConnectedComponentPtr_t& otherCC);
          
       /// Add roadmap node to connected component
       /// \param roadmap node to be added
       void addNode (const core::NodePtr_t& node);
 
       const RoadmapNodes_t& getRoadmapNodes (const graph::StatePtr_t graphState) const;
-     
+
+      /// Get the node of the connected component lying in a graph state
+      /// that is the closest to a configuration.
+      /// The query goes through the nearest-neighbor index of the graph
+      /// state so its cost is sub-linear in the number of nodes.
+      /// \retval minDistance distance to the returned node, infinity when
+      ///         the graph state contains no node.
+      /// \return the closest node, NULL when the graph state contains no
+      ///         node.
+      RoadmapNodePtr_t nearestRoadmapNode (const graph::StatePtr_t graphState,
+          const Configuration_t& q, value_type& minDistance) const;
+
+      /// Get the nearest node of every graph state of the connected
+      /// component in a single traversal.
+      /// Only the states that contain at least one node are visited, so
+      /// the cost does not scale with the number of states of the graph.
+      /// \retval nearest filled with one (node, distance) pair per graph
+      ///         state containing at least one node.
+      void nearestRoadmapNodes (const Configuration_t& q,
+          NodesAndDistances_t& nearest) const;
+
   protected:
   private:
       bool check () const;
 	GraphStates_t graphStateMap_;
+	GraphStateIndices_t graphStateIndices_;
 	RoadmapPtr_t roadmap_;
         static RoadmapNodes_t empty_;
     }; // class ConnectedComponent
@@ -18,6 +18,8 @@
 #ifndef HPP_MANIPULATION_CONSTRAINT_SET_HH
 # define HPP_MANIPULATION_CONSTRAINT_SET_HH
 
+# include <typeinfo>
+
 # include <hpp/core/constraint-set.hh>
 
 # include <hpp/manipulation/fwd.hh>
@@ -42,6 +44,21 @@ namespace hpp {
       /// Return shared pointer to new object
       static ConstraintSetPtr_t createCopy (const ConstraintSetPtr_t& cs);
 
+      /// Downcast from the core type, or an empty pointer when the set
+      /// was not built by a graph edge.
+      ///
+      /// Path validation and optimization call this for every subpath;
+      /// the exact-type comparison is a vtable load and a pointer
+      /// compare where the dynamic_cast it replaces walks the class
+      /// lattice. Every set built by graph::Edge is exactly of this
+      /// type, so the exact check loses nothing.
+      static ConstraintSetPtr_t cast (const core::ConstraintSetPtr_t& set)
+      {
+	if (set && typeid (*set) == typeid (ConstraintSet))
+	  return boost::static_pointer_cast <ConstraintSet> (set);
+	return ConstraintSetPtr_t ();
+      }
+
       /// return shared pointer to copy
       virtual ConstraintPtr_t copy () const;
 
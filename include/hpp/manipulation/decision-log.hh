@@ -0,0 +1,143 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_DECISION_LOG_HH
+# define HPP_MANIPULATION_DECISION_LOG_HH
+
+# include <fstream>
+# include <string>
+# include <vector>
+
+# include <boost/thread/mutex.hpp>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+# include "hpp/manipulation/graph/fwd.hh"
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup path_planning
+    /// \{
+
+    /// Record the random decisions of a planner run.
+    ///
+    /// The behavior of ManipulationPlanner depends on two random
+    /// streams: the sampled configurations and the edge chosen for each
+    /// extension. Recording them during a run and replaying them later
+    /// makes two runs execute the same work, so changes to projection,
+    /// nearest neighbor structures or validation can be benchmarked
+    /// against each other on identical decision streams, and a
+    /// pathological production run can be reproduced offline.
+    ///
+    /// The log is a single binary file: a fixed header - magic, format
+    /// version, configuration size and record count - followed by
+    /// tagged records, a configuration as doubles or a chosen edge as
+    /// its id. The count is committed by commit(), typically once per
+    /// planner iteration, so a crash leaves the prefix described by the
+    /// last commit valid.
+    ///
+    /// Enable with the string parameter "ManipulationPlanner/RecordLog"
+    /// set to the log path. Records are written in decision order, so a
+    /// faithful log requires "ManipulationPlanner/NumberOfThreads" 1;
+    /// the writer is locked, so parallel runs produce a valid but
+    /// unordered log.
+    class HPP_MANIPULATION_DLLAPI DecisionLogWriter
+    {
+      public:
+        /// Open the log, truncating any previous content.
+        /// \param configSize size of the recorded configurations.
+        DecisionLogWriter (const std::string& path,
+            const size_type& configSize);
+
+        /// Append a sampled configuration.
+        void recordConfiguration (const Configuration_t& q);
+
+        /// Append a chosen edge, possibly empty.
+        void recordEdge (const graph::EdgePtr_t& edge);
+
+        /// Commit the records appended so far to the header.
+        void commit ();
+
+      private:
+        std::ofstream stream_;
+        size_type configSize_;
+        std::size_t nbRecords_;
+        boost::mutex mutex_;
+    }; // class DecisionLogWriter
+
+    /// Replay the random decisions of a recorded planner run.
+    ///
+    /// The whole log is loaded at construction. Each query pops the
+    /// next record; when the log is exhausted - or the next record is
+    /// not of the requested kind, which means the replayed code path
+    /// diverged from the recorded one - the planner falls back to its
+    /// random generators and the divergence is reported once in the
+    /// logs.
+    ///
+    /// Enable with the string parameter "ManipulationPlanner/ReplayLog"
+    /// set to the log path. The online projection reject model draws
+    /// from its own generator; set "ManipulationPlanner/ProjectionFloor"
+    /// to 0 when strict determinism is required.
+    /// \sa DecisionLogWriter
+    class HPP_MANIPULATION_DLLAPI DecisionLogReader
+    {
+      public:
+        /// Load a recorded log.
+        /// \throw std::runtime_error when the file cannot be read or is
+        ///        not a decision log.
+        DecisionLogReader (const std::string& path);
+
+        /// Pop the next recorded configuration.
+        /// \retval q the configuration, untouched on failure.
+        /// \return false when the log is exhausted or the next record
+        ///         is an edge.
+        bool nextConfiguration (Configuration_t& q);
+
+        /// Pop the next recorded edge choice.
+        /// \retval edge the edge looked up by id in \c graph, empty
+        ///         when the record holds no edge.
+        /// \return false when the log is exhausted, the next record is
+        ///         a configuration or the id is unknown to \c graph.
+        bool nextEdge (graph::EdgePtr_t& edge, const graph::GraphPtr_t& graph);
+
+        /// Whether every record has been consumed.
+        bool finished () const
+        {
+          return next_ >= records_.size ();
+        }
+
+        size_type configSize () const
+        {
+          return configSize_;
+        }
+
+      private:
+        struct Record_t {
+          int kind;
+          std::size_t edgeId;
+          vector_t configuration;
+        };
+        std::vector <Record_t> records_;
+        std::size_t next_;
+        size_type configSize_;
+        bool divergenceReported_;
+        boost::mutex mutex_;
+    }; // class DecisionLogReader
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_DECISION_LOG_HH
@@ -20,6 +20,9 @@
 #ifndef HPP_MANIPULATION_DEVICE_HH
 # define HPP_MANIPULATION_DEVICE_HH
 
+# include <map>
+# include <vector>
+
 # include <hpp/pinocchio/humanoid-robot.hh>
 
 # include <hpp/core/container.hh>
@@ -65,6 +68,48 @@ namespace hpp {
         /// Print object in a stream
         virtual std::ostream& print (std::ostream& os) const;
 
+        /// \name Interned element ids
+        ///
+        /// The name-keyed containers answer sparse queries well but graph
+        /// construction and per-query constraint creation resolve the
+        /// same few names over and over. These methods intern a name
+        /// into a small dense id - one name resolution ever - and code
+        /// keeping the id then fetches the element by vector indexing,
+        /// without string comparisons.
+        /// \{
+
+        /// Intern the name of a handle, registering it on first call.
+        std::size_t handleId (const std::string& name) const;
+
+        /// Handle interned by handleId
+        const HandlePtr_t& handle (const std::size_t id) const;
+
+        /// Intern the name of a gripper, registering it on first call.
+        std::size_t gripperId (const std::string& name) const;
+
+        /// Gripper interned by gripperId
+        const GripperPtr_t& gripper (const std::size_t id) const;
+
+        /// Intern the name of a frame index list, registering it on
+        /// first call.
+        std::size_t frameIndicesId (const std::string& name) const;
+
+        /// Frame indices interned by frameIndicesId
+        const FrameIndices_t& frameIndices (const std::size_t id) const;
+
+        /// \}
+
+        /// \name Element insertion
+        ///
+        /// These overloads keep the interned registries consistent when
+        /// an element is added again under an already interned name.
+        /// \{
+        using Containers_t::add;
+        void add (const std::string& name, const HandlePtr_t& element);
+        void add (const std::string& name, const GripperPtr_t& element);
+        void add (const std::string& name, const FrameIndices_t& element);
+        /// \}
+
         void setRobotRootPosition (const std::string& robotName,
                                    const Transform3f& positionWRTParentJoint);
 
@@ -104,9 +149,51 @@ namespace hpp {
         }
 
       private:
+        /// Dense registry of interned elements of one container.
+        template <typename Element> struct InternedRegistry {
+          typedef std::map <std::string, std::size_t> Ids_t;
+          Ids_t ids;
+          std::vector <Element> elements;
+        };
+
+        /// Return the id of name, interning it on first call.
+        /// \throw the same exception as get if no element is registered
+        ///        under this name.
+        template <typename Element>
+        std::size_t intern (InternedRegistry <Element>& registry,
+            const std::string& name) const
+        {
+          typename InternedRegistry <Element>::Ids_t::const_iterator it =
+            registry.ids.find (name);
+          if (it != registry.ids.end ()) return it->second;
+          const std::size_t id = registry.elements.size ();
+          registry.elements.push_back (get <Element> (name));
+          registry.ids.insert (std::make_pair (name, id));
+          return id;
+        }
+
+        /// Update the interned element when its name is already
+        /// registered, for instance when didInsertRobot completes the
+        /// frame index list of a robot inserted in several steps.
+        template <typename Element>
+        void refreshInterned (InternedRegistry <Element>& registry,
+            const std::string& name, const Element& element)
+        {
+          typename InternedRegistry <Element>::Ids_t::const_iterator it =
+            registry.ids.find (name);
+          if (it != registry.ids.end ())
+            registry.elements[it->second] = element;
+        }
+
         DeviceWkPtr_t self_;
 
         std::size_t frameCacheSize_;
+
+        /// The registries fill in lazily, on interning, so they are
+        /// mutable and the accessors stay const.
+        mutable InternedRegistry <HandlePtr_t> handleRegistry_;
+        mutable InternedRegistry <GripperPtr_t> gripperRegistry_;
+        mutable InternedRegistry <FrameIndices_t> frameIndicesRegistry_;
     }; // class Device
   } // namespace manipulation
 } // namespace hpp
@@ -0,0 +1,86 @@
+// Copyright (c) 2016, Joseph Mirabel
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_FLATTENED_PATH_HH
+# define HPP_MANIPULATION_FLATTENED_PATH_HH
+
+# include <vector>
+
+# include <hpp/manipulation/config.hh>
+# include <hpp/manipulation/fwd.hh>
+
+namespace hpp {
+  namespace manipulation {
+    using hpp::core::PathPtr_t;
+    using hpp::core::PathVectorPtr_t;
+
+    /// Flattened view over the recursive structure of a path vector.
+    ///
+    /// PathVector::flatten deep-copies every leaf into a fresh path
+    /// vector, and every later PathVector::pathAtRank call copies the
+    /// accessed subpath again. The optimizers only need rank-wise read
+    /// access to the leaves, so this view indexes the recursive
+    /// structure once - paying the single copy per leaf that the
+    /// PathVector interface imposes - and then shares the leaves: no
+    /// enclosing path vector is built and repeated accesses to the same
+    /// rank return the same object.
+    ///
+    /// Ranks may be substituted with replaceAtRank; only those ranks
+    /// diverge from the original path. The view does not modify the
+    /// path vector it was built from.
+    class HPP_MANIPULATION_DLLAPI FlattenedPath
+    {
+      public:
+        /// Build the index of the leaves of \c path, in order.
+        explicit FlattenedPath (const PathVectorPtr_t& path);
+
+        /// Number of leaf paths.
+        std::size_t numberPaths () const
+        {
+          return leaves_.size ();
+        }
+
+        /// The leaf path at \c rank. Unlike PathVector::pathAtRank, the
+        /// returned object is shared with the view: repeated calls do
+        /// not copy.
+        const PathPtr_t& pathAtRank (const std::size_t rank) const
+        {
+          return leaves_[rank];
+        }
+
+        /// Substitute the leaf at \c rank. Affects this view only.
+        void replaceAtRank (const std::size_t rank, const PathPtr_t& path)
+        {
+          leaves_[rank] = path;
+        }
+
+        /// Assemble the current leaves into a flat path vector, e.g. to
+        /// hand the - possibly partially replaced - path back to a
+        /// consumer expecting a PathVector.
+        PathVectorPtr_t assemble () const;
+
+      private:
+        /// Recursion of the constructor over nested path vectors.
+        void index (const PathVectorPtr_t& path);
+
+        std::vector <PathPtr_t> leaves_;
+        size_type outputSize_;
+        size_type outputDerivativeSize_;
+    }; // class FlattenedPath
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_FLATTENED_PATH_HH
@@ -20,6 +20,7 @@
 #ifndef HPP_MANIPULATION_FWD_HH
 # define HPP_MANIPULATION_FWD_HH
 
+# include <functional>
 # include <map>
 # include <hpp/core/fwd.hh>
 
@@ -58,13 +59,22 @@ namespace hpp {
     HPP_PREDEF_CLASS (RoadmapNode);
     typedef RoadmapNode* RoadmapNodePtr_t;
     typedef std::vector<RoadmapNodePtr_t> RoadmapNodes_t;
+    /// A roadmap node together with its distance to a query
+    /// configuration. \sa Roadmap::nearestNodes
+    typedef std::pair<RoadmapNodePtr_t, core::value_type> NodeAndDistance_t;
+    typedef std::vector<NodeAndDistance_t> NodesAndDistances_t;
     HPP_PREDEF_CLASS (ConnectedComponent);
-    typedef boost::shared_ptr<ConnectedComponent> ConnectedComponentPtr_t; 
+    typedef boost::shared_ptr<ConnectedComponent> ConnectedComponentPtr_t;
+    HPP_PREDEF_CLASS (NearestNeighborIndex);
+    typedef boost::shared_ptr<NearestNeighborIndex> NearestNeighborIndexPtr_t;
     HPP_PREDEF_CLASS (SymbolicComponent);
     typedef boost::shared_ptr<SymbolicComponent> SymbolicComponentPtr_t;
     typedef std::set<SymbolicComponentPtr_t> SymbolicComponents_t;
     HPP_PREDEF_CLASS (WeighedSymbolicComponent);
     typedef boost::shared_ptr<WeighedSymbolicComponent> WeighedSymbolicComponentPtr_t;
+    /// Weighed symbolic components ordered by decreasing weight.
+    typedef std::multimap <core::value_type, WeighedSymbolicComponentPtr_t,
+            std::greater <core::value_type> > WeighedSymbolicComponents_t;
     HPP_PREDEF_CLASS (WeighedDistance);
     typedef boost::shared_ptr<WeighedDistance> WeighedDistancePtr_t;
     typedef constraints::RelativeOrientation RelativeOrientation;
@@ -82,6 +92,12 @@ namespace hpp {
     typedef core::vectorOut_t vectorOut_t;
     HPP_PREDEF_CLASS (ManipulationPlanner);
     typedef boost::shared_ptr < ManipulationPlanner > ManipulationPlannerPtr_t;
+    HPP_PREDEF_CLASS (DecisionLogWriter);
+    typedef boost::shared_ptr <DecisionLogWriter> DecisionLogWriterPtr_t;
+    HPP_PREDEF_CLASS (DecisionLogReader);
+    typedef boost::shared_ptr <DecisionLogReader> DecisionLogReaderPtr_t;
+    HPP_PREDEF_CLASS (LeafDatabase);
+    typedef boost::shared_ptr <LeafDatabase> LeafDatabasePtr_t;
     HPP_PREDEF_CLASS (SymbolicPlanner);
     typedef boost::shared_ptr < SymbolicPlanner > SymbolicPlannerPtr_t;
     HPP_PREDEF_CLASS (GraphPathValidation);
@@ -18,6 +18,9 @@
 #ifndef HPP_MANIPULATION_GRAPHOPTIMIZER_HH
 # define HPP_MANIPULATION_GRAPHOPTIMIZER_HH
 
+# include <map>
+# include <vector>
+
 # include <hpp/core/path-optimizer.hh>
 # include <hpp/core/problem-solver.hh> // PathOptimizerBuilder_t
 
@@ -40,6 +43,13 @@ namespace hpp {
     /// This class encapsulates another path optimizer class. This optimizer
     /// calls the inner optimizer on every subpaths with the same set of
     /// constraints.
+    ///
+    /// The inner problem (steering method copy, constraints, path
+    /// validation) and the inner optimizer built for an edge are cached
+    /// and reused across groups and across calls to optimize, until the
+    /// edge is reinitialized. When GraphOptimizer/NumberOfThreads is
+    /// greater than 1, the independent groups are optimized concurrently
+    /// and concatenated in order.
     class HPP_MANIPULATION_DLLAPI GraphOptimizer : public PathOptimizer
     {
       public:
@@ -59,14 +69,47 @@ namespace hpp {
       protected:
         /// Constructor
         GraphOptimizer (const core::Problem& problem, PathOptimizerBuilder_t factory) :
-          PathOptimizer (problem), factory_ (factory), pathOptimizer_ ()
+          PathOptimizer (problem), factory_ (factory), pathOptimizer_ (),
+          nbThreads_ (problem.getParameter <size_type>
+              ("GraphOptimizer/NumberOfThreads", 1))
         {}
 
       private:
+        /// Inner problem and optimizer prepared for one edge. The
+        /// steering method of the edge at preparation time serves as a
+        /// fingerprint: Edge::initialize creates a new one, which
+        /// invalidates the entry.
+        struct PreparedProblem {
+          boost::shared_ptr <core::Problem> problem;
+          PathOptimizerPtr_t optimizer;
+          core::SteeringMethodPtr_t fingerprint;
+        };
+        typedef std::map <std::size_t, PreparedProblem> PreparedProblems_t;
+
+        /// Get the prepared problem of an edge, building or refreshing
+        /// it if needed.
+        PreparedProblem& prepared (const graph::EdgePtr_t& edge);
+
+        /// Optimize one group of consecutive same-state subpaths.
+        PathVectorPtr_t optimizeGroup (const PathVectorPtr_t& toOpt,
+            const graph::EdgePtr_t& edge);
+
+        /// Optimize the groups at the given indices, in order.
+        void optimizeGroupsWorker (const std::vector <std::size_t>& indices,
+            const std::vector <PathVectorPtr_t>& groups,
+            const std::vector <graph::EdgePtr_t>& edges,
+            std::vector <PathVectorPtr_t>& results);
+
         PathOptimizerBuilder_t factory_;
 
         /// The encapsulated PathOptimizer
         PathOptimizerPtr_t pathOptimizer_;
+
+        /// Prepared problems, keyed by edge id.
+        PreparedProblems_t preparedProblems_;
+
+        /// Number of threads optimizing groups concurrently.
+        size_type nbThreads_;
     };
     /// \}
 
@@ -18,6 +18,10 @@
 #ifndef HPP_MANIPULATION_GRAPHPATHVALIDATOR_HH
 # define HPP_MANIPULATION_GRAPHPATHVALIDATOR_HH
 
+# include <vector>
+
+# include <boost/thread/mutex.hpp>
+
 # include <hpp/core/path-validation.hh>
 
 # include <hpp/manipulation/fwd.hh>
@@ -84,6 +88,25 @@ namespace hpp {
           return constraintGraph_;
         }
 
+        /// Set the number of threads used to validate the subpaths of a
+        /// PathVector.
+        ///
+        /// When greater than 1, the ranks of a PathVector are validated
+        /// speculatively in parallel and the work above the lowest known
+        /// failure is cancelled; the valid part is then assembled as in
+        /// the sequential case. The inner path validations and the robot
+        /// model must support concurrent evaluation.
+        void numberOfThreads (const size_type& n)
+        {
+          nbThreads_ = (n < 1) ? 1 : n;
+        }
+
+        /// Get the number of threads used to validate subpaths.
+        size_type numberOfThreads () const
+        {
+          return nbThreads_;
+        }
+
         /// Create a new instance of this class.
         /// \param pathValidation a PathValidation that is responsible for collision
         //         checking.
@@ -118,13 +141,32 @@ namespace hpp {
         /// Do validation regarding the constraint graph for PathVector
         bool impl_validate (const PathVectorPtr_t& path, bool reverse,
             PathPtr_t& validPart, PathValidationReportPtr_t& report);
-        /// Do validation regarding the constraint graph for Path 
+        /// Do validation regarding the constraint graph for Path
         bool impl_validate (const PathPtr_t& path, bool reverse,
             PathPtr_t& validPart, PathValidationReportPtr_t& report);
+        /// Find the lowest rank of path whose inner validation fails, by
+        /// validating the ranks speculatively on nbThreads_ threads.
+        /// \return path->numberPaths() when every rank is valid.
+        std::size_t firstInvalidRank (const PathVectorPtr_t& path) const;
+        /// Validate the given ranks in increasing order, stopping as soon
+        /// as a failure below them is known.
+        void validateRanksWorker (const PathVectorPtr_t& path,
+            const std::vector <std::size_t>& ranks,
+            std::size_t& firstFailure, boost::mutex& mutex) const;
+        /// Inner validation of the subpath at one rank only.
+        bool validateRank (const PathPtr_t& subpath) const;
         /// The encapsulated PathValidation.
         PathValidationPtr_t pathValidation_;
         /// Pointer to the constraint graph.
         graph::GraphPtr_t constraintGraph_;
+        /// Number of threads validating subpaths, see numberOfThreads.
+        size_type nbThreads_;
+        /// Configuration buffer of impl_validate, kept across calls so
+        /// that a validation in steady state does not allocate it per
+        /// failing path. Only the calling thread evaluates it - the
+        /// speculative workers go through validateRank, which needs no
+        /// configuration - so no lock is required.
+        mutable Configuration_t qBuffer_;
     };
 
     template <typename T>
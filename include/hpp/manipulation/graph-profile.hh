@@ -0,0 +1,103 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_GRAPH_PROFILE_HH
+# define HPP_MANIPULATION_GRAPH_PROFILE_HH
+
+# include <fstream>
+# include <iosfwd>
+# include <string>
+# include <vector>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+# include "hpp/manipulation/graph/fwd.hh"
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup constraint_graph
+    /// \{
+
+    /// Streaming binary profile of a constraint graph.
+    ///
+    /// Where Graph::dotPrint renders the whole graph with tooltips in
+    /// one expensive pass, this writer dumps flat binary tables: the
+    /// immutable structure once, then one statistics frame per
+    /// checkpoint. A checkpoint writes a few kilobytes sequentially, so
+    /// it can run between two planner iterations without a noticeable
+    /// pause. Four files are written, derived from the profile name
+    /// \c path:
+    /// \li \c path: fixed-size header holding the counts,
+    /// \li \c path.structure: per state its id, then per edge its id,
+    ///     source and target state ids, containing state id, short-cut
+    ///     flag and weight, as 64-bit integers,
+    /// \li \c path.names: text table mapping ids to component names and
+    ///     reason indices to extension outcome labels,
+    /// \li \c path.stats: appended frames of per-edge extension outcome
+    ///     counters and histogram frequencies.
+    ///
+    /// The header is rewritten after each frame has been flushed, so a
+    /// crash mid-frame leaves the prefix described by the previous
+    /// header valid. Use exportDot or exportJSON to convert a profile
+    /// offline.
+    class HPP_MANIPULATION_DLLAPI GraphProfileWriter
+    {
+      public:
+        /// Open the profile files, truncating any previous content, and
+        /// write the structure tables.
+        /// \param graph an initialized graph: the dense component
+        ///        tables must have been built.
+        GraphProfileWriter (const std::string& path,
+            const graph::GraphPtr_t& graph);
+
+        /// Append one statistics frame: the extension outcome counters
+        /// of every edge read from \c planner, and the frequencies of
+        /// the graph histograms, then commit the new frame count to the
+        /// header.
+        ///
+        /// The counters are read without stopping the planner, so a
+        /// frame taken while workers run may mix slightly different
+        /// instants; for monitoring this is harmless.
+        void checkpoint (const ManipulationPlanner& planner);
+
+        /// Number of frames written so far.
+        std::size_t nbFrames () const
+        {
+          return nbFrames_;
+        }
+
+        /// Convert a profile to dot, labelling each edge with the
+        /// counters of the last frame.
+        static void exportDot (const std::string& path, std::ostream& os);
+
+        /// Convert a profile to JSON, with one entry per frame.
+        static void exportJSON (const std::string& path, std::ostream& os);
+
+      private:
+        void writeHeader ();
+
+        std::string path_;
+        graph::GraphPtr_t graph_;
+        std::ofstream stats_;
+        /// Edges in structure-table order, kept alive by the writer.
+        std::vector <graph::EdgePtr_t> edges_;
+        std::size_t nbStates_, nbReasons_, nbFrames_;
+    }; // class GraphProfileWriter
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_GRAPH_PROFILE_HH
@@ -17,6 +17,10 @@
 #ifndef HPP_MANIPULATION_GRAPH_EDGE_HH
 # define HPP_MANIPULATION_GRAPH_EDGE_HH
 
+#include <list>
+
+#include <boost/thread/mutex.hpp>
+
 #include <hpp/core/constraint-set.hh>
 #include <hpp/core/steering-method.hh>
 #include <hpp/core/relative-motion.hh>
@@ -90,6 +94,24 @@ namespace hpp {
 	  /// \sa hpp::core::ConfigProjector::rightHandSideFromConfig
           virtual bool applyConstraints (ConfigurationIn_t qoffset, ConfigurationOut_t q) const;
 
+	  /// Apply edge constraint to a block of seed configurations.
+	  ///
+	  /// The right hand side is computed from \c qoffset once and
+	  /// shared by all the solves, and the seeds are tried in column
+	  /// order, so one failing seed costs one solver run but none of
+	  /// the per-leaf setup.
+	  ///
+	  /// \param qoffset configuration defining the right hand side of
+	  ///        the edge constraint,
+	  /// \param[in,out] qs seed configurations, one per column. The
+	  ///                first convergent column is overwritten with the
+	  ///                projected configuration, the others are left
+	  ///                unspecified.
+	  /// \return the index of the first convergent column, or -1 when
+	  ///         no seed converges.
+          virtual size_type applyConstraintsWithSeeds (ConfigurationIn_t qoffset,
+              matrixOut_t qs) const;
+
           virtual bool canConnect (ConfigurationIn_t q1, ConfigurationIn_t q2) const;
 
           virtual bool build (core::PathPtr_t& path, ConfigurationIn_t q1,
@@ -152,6 +174,15 @@ namespace hpp {
             return isShort_;
           }
 
+          /// Mutex serializing the stateful objects of this edge - the
+          /// config projector, the steering method, the path validation
+          /// and the mutable caches - when several planner workers pick
+          /// the same edge. Single worker setups never take it.
+          boost::mutex& workerMutex () const
+          {
+            return workerMutex_;
+          }
+
         protected:
           /// Initialization of the object.
           void init (const EdgeWkPtr_t& weak, const GraphWkPtr_t& graph, const StateWkPtr_t& from,
@@ -183,6 +214,11 @@ namespace hpp {
           /// same leaf of to_ as the configuration used for initialization.
           ConstraintSetPtr_t configConstraints_;
 
+          /// Loose low-iteration copy of configConstraints_, first rung
+          /// of the projection ladder of applyConstraints. Empty unless
+          /// the parameter Edge/ProjectionLadder is set.
+          ConstraintSetPtr_t coarseConstraint_;
+
           /// The two ends of the transition.
           StateWkPtr_t from_, to_;
 
@@ -196,6 +232,79 @@ namespace hpp {
           mutable RelativeMotion::matrix_type relMotion_;
           core::PathValidationPtr_t pathValidation_;
 
+          /// \name Per-leaf projection cache
+          /// \{
+          /// The last successful projections, one per leaf of the foliation.
+          /// A leaf is identified by the right hand side of the config
+          /// constraints. When a projection fails, the solver is restarted
+          /// from the cached solution of the (nearby) leaf, which lies close
+          /// to the manifold and converges in few iterations. The cache is
+          /// a bounded list kept in least-recently-used order.
+          typedef std::pair <vector_t, Configuration_t> LeafProjection_t;
+          typedef std::list <LeafProjection_t> LeafProjections_t;
+
+          /// Get the cached projection of the leaf closest to rhs.
+          /// The returned entry is moved to the front of the list.
+          /// \return true iff a leaf matching rhs is in the cache.
+          bool warmStart (const vector_t& rhs, Configuration_t& q) const;
+          /// Record a successful projection on the leaf of rhs.
+          void storeProjection (const vector_t& rhs,
+              ConfigurationIn_t q) const;
+
+          mutable LeafProjections_t leafProjections_;
+          /// Protects leafProjections_ from concurrent planner workers.
+          mutable boost::mutex leafProjectionsMutex_;
+          static const std::size_t maxLeafProjections_;
+          /// \}
+
+          /// \name Explicit seeding
+          /// \{
+          /// Keep the explicit constraints of the configuration
+          /// constraint (typically the pose of a freeflying object
+          /// grasped or placed). Collected by buildConfigConstraint.
+          void collectExplicitConstraints
+            (const std::vector <GraphComponentPtr_t>& components);
+
+          /// Overwrite in q the configuration variables computed by the
+          /// explicit constraints, from the other variables of q. The
+          /// random sample then already lies on the leaf for those
+          /// degrees of freedom and the Newton solve of applyConstraints
+          /// starts much closer to the manifold. Constraints with
+          /// Equality rows are left to the solver: their right hand side
+          /// parametrizes the leaf.
+          void seedFromExplicitConstraints (ConfigurationOut_t q) const;
+
+          std::vector <ExplicitNumericalConstraintPtr_t>
+            explicitConstraints_;
+          /// Whether every numerical constraint of the edge is computed
+          /// by direct substitution. applyConstraints then accepts the
+          /// substituted configuration after one residual check instead
+          /// of a Newton solve - the common case for pick-and-place
+          /// with free-flying objects, whose grasps are explicit.
+          bool fullyExplicit_;
+          /// \}
+
+          /// \name Leaf parameter bounds
+          /// \{
+          /// Bounding box of the path constraint right hand sides seen
+          /// to connect through this edge. When the parameter
+          /// Edge/LeafBoundsPrefilter is set, canConnect rejects a leaf
+          /// outside the box with a handful of comparisons instead of
+          /// two full constraint evaluations. The filter may reject
+          /// leaves that were simply not crossed yet, so it is off by
+          /// default and meant for heuristic uses such as the
+          /// graph-aware distance.
+          bool insideLeafBounds (const vector_t& rhs) const;
+          void growLeafBounds (const vector_t& rhs) const;
+
+          bool leafBoundsPrefilter_;
+          mutable bool leafBoundsValid_;
+          mutable vector_t leafBoundsLower_, leafBoundsUpper_;
+          /// \}
+
+          /// See workerMutex.
+          mutable boost::mutex workerMutex_;
+
           /// Weak pointer to itself.
           EdgeWkPtr_t wkPtr_;
 
@@ -238,6 +347,11 @@ namespace hpp {
 
           virtual bool applyConstraints (ConfigurationIn_t qoffset, ConfigurationOut_t q) const;
 
+          /// The chained waypoint solves cannot be shared between seeds,
+          /// so each column runs the single seed version.
+          virtual size_type applyConstraintsWithSeeds (ConfigurationIn_t qoffset,
+              matrixOut_t qs) const;
+
           /// Return the index-th edge.
           const EdgePtr_t& waypoint (const std::size_t index) const;
 
@@ -259,7 +373,7 @@ namespace hpp {
         protected:
 	  WaypointEdge (const std::string& name) :
 	    Edge (name),
-            lastSucceeded_ (false)
+            validWaypoints_ (0)
 	    {
 	    }
           /// Initialization of the object.
@@ -273,8 +387,20 @@ namespace hpp {
           Edges_t edges_;
           States_t states_;
 
+          /// Cached waypoint solutions: column i+1 holds the last
+          /// solution of edge i. The first validWaypoints_ waypoints
+          /// are valid for the right hand sides stored in rhs_, i.e.
+          /// they still lie on the leaves identified by rhs_ and can be
+          /// reused instead of being solved again.
           mutable matrix_t configs_;
-          mutable bool lastSucceeded_;
+          mutable std::vector<vector_t> rhs_;
+          mutable size_type validWaypoints_;
+
+          /// Scratch buffer holding the sub-paths of the current build
+          /// attempt. Most attempts fail on an intermediate waypoint, so
+          /// the enclosing path vector is only allocated once the whole
+          /// chain has been built; this buffer is recycled in between.
+          mutable std::vector<core::PathPtr_t> subPaths_;
 
           WaypointEdgeWkPtr_t wkPtr_;
       }; // class WaypointEdge
@@ -295,6 +421,11 @@ namespace hpp {
 
           virtual bool applyConstraints (core::NodePtr_t n_offset, ConfigurationOut_t q) const;
 
+          /// The level set offset is drawn once and shared, then each
+          /// column runs the single seed version.
+          virtual size_type applyConstraintsWithSeeds (ConfigurationIn_t qoffset,
+              matrixOut_t qs) const;
+
           virtual ConstraintSetPtr_t buildConfigConstraint();
 
           void buildHistogram ();
@@ -17,7 +17,9 @@
 #ifndef HPP_MANIPULATION_GRAPH_GRAPH_HH
 # define HPP_MANIPULATION_GRAPH_GRAPH_HH
 
+# include <boost/thread/mutex.hpp>
 # include <boost/tuple/tuple.hpp>
+# include <hpp/core/relative-motion.hh>
 # include "hpp/manipulation/config.hh"
 # include "hpp/manipulation/fwd.hh"
 # include "hpp/manipulation/graph/fwd.hh"
@@ -102,6 +104,76 @@ namespace hpp {
           /// Get possible edges between two nodes.
           Edges_t getEdges (const StatePtr_t& from, const StatePtr_t& to) const;
 
+          /// Id of the ordered state pair (from, to) in the edge lookup
+          /// table built by initialize(). Callers doing repeated queries
+          /// between the same pair of states can cache this id and call
+          /// getEdges(std::size_t) directly.
+          std::size_t statePairId (const StatePtr_t& from,
+              const StatePtr_t& to) const;
+
+          /// Get the edges between the state pair identified by
+          /// statePairId, as an array load in the table built by
+          /// initialize().
+          const Edges_t& getEdges (const std::size_t& statePairId) const;
+
+          /// Minimal number of transitions to go from state \c from to
+          /// state \c to, following edge direction. Computed by
+          /// initialize() from the same connectivity as the edge lookup
+          /// table, it provides a cheap admissible bound on the number
+          /// of state changes along any roadmap path.
+          /// \return -1 when \c to cannot be reached from \c from.
+          size_type stateHops (const StatePtr_t& from, const StatePtr_t& to)
+            const;
+
+          /// \name Dense component tables
+          /// \{
+          /// Raw pointer tables indexed by component id, built by
+          /// initialize(). Planner inner loops resolve a component id
+          /// with one array load instead of locking weak pointers and
+          /// dynamic casting. The pointers stay valid as long as the
+          /// graph does, like the roadmap node pointers.
+
+          /// State of the given component id, NULL when the component is
+          /// not a state or the tables are not built.
+          State* stateByIndex (const std::size_t& id) const
+          {
+            if (id >= stateByIndex_.size ()) return NULL;
+            return stateByIndex_[id];
+          }
+
+          /// Edge of the given component id, NULL when the component is
+          /// not an edge or the tables are not built.
+          Edge* edgeByIndex (const std::size_t& id) const
+          {
+            if (id >= edgeByIndex_.size ()) return NULL;
+            return edgeByIndex_[id];
+          }
+
+          /// Contiguous metadata of one edge, see edgeInfo.
+          struct EdgeInfo_t {
+            Edge* edge;
+            /// Ids of the source and target states.
+            std::size_t fromId, toId;
+            /// Id of the state the edge path lies in.
+            std::size_t stateId;
+            bool isShort;
+            /// Selection weight in the neighbor list of the source
+            /// state, 0 for edges that are not direct neighbors
+            /// (waypoint sub-edges for instance).
+            Weight_t weight;
+            EdgeInfo_t () : edge (NULL), fromId (0), toId (0),
+              stateId (0), isShort (false), weight (0) {}
+          };
+
+          /// Metadata of the edge of given component id. The entry of a
+          /// component that is not an edge has a NULL edge field.
+          const EdgeInfo_t& edgeInfo (const std::size_t& id) const
+          {
+            assert (id < edgeInfos_.size ());
+            return edgeInfos_[id];
+          }
+          /// \}
+
           /// Select randomly outgoing edge of the given node.
           EdgePtr_t chooseEdge(RoadmapNodePtr_t node) const;
 
@@ -206,6 +278,85 @@ namespace hpp {
           /// \return The constraint.
           ConstraintSetPtr_t pathConstraint (const EdgePtr_t& edge) const;
 
+          /// Projector compiled for a constraint stack signature, or a
+          /// null pointer when none is registered yet.
+          ///
+          /// Edges whose constraint stacks are structurally identical -
+          /// same numerical constraints, passive dofs and locked joints -
+          /// share one ConfigProjector through this pool. Each edge
+          /// keeps its own ConstraintSet, which records the edge
+          /// identity, and sets the right hand side from a configuration
+          /// before solving, so only the compiled solver data is shared.
+          /// The pool is dropped by initialize().
+          ConfigProjectorPtr_t sharedConfigProjector
+            (const std::string& signature) const;
+
+          /// Register the projector compiled for a constraint stack
+          /// signature.
+          void addSharedConfigProjector (const std::string& signature,
+              const ConfigProjectorPtr_t& projector);
+
+          /// Relative motion matrix and filtered path validation
+          /// computed for a constraint stack signature.
+          ///
+          /// The relative motion matrix and the collision pairs it
+          /// disables only depend on the structure of the path
+          /// constraint, so edges with the same signature share them
+          /// instead of re-filtering the pairs one edge at a time on
+          /// every problem reset. The shared objects are treated as
+          /// immutable by the edges. The pool survives initialize():
+          /// an entry is invalidated only when the geometry epoch of
+          /// the problem has changed since it was built.
+          struct FilteredValidation_t {
+            core::RelativeMotion::matrix_type relativeMotion;
+            core::PathValidationPtr_t pathValidation;
+            /// Problem::geometryEpoch at construction time.
+            std::size_t geometryEpoch;
+          };
+
+          /// Shared validation data for a signature, or NULL when none
+          /// is registered yet or the registered entry was built at
+          /// another geometry epoch.
+          const FilteredValidation_t* sharedFilteredValidation
+            (const std::string& signature,
+             const std::size_t& geometryEpoch) const;
+
+          /// Register the validation data filtered for a signature.
+          const FilteredValidation_t& addSharedFilteredValidation
+            (const std::string& signature, const FilteredValidation_t& data);
+
+          /// Projector on the intersection of the constraints of the
+          /// ordered edge pair (edgeB, edgeA), or a null pointer when
+          /// none is registered yet.
+          ///
+          /// The set of adjacent edge pairs is small and fixed by the
+          /// graph, while config optimization rebuilds the intersection
+          /// on every run: callers cache the compiled projector here and
+          /// reset its right hand side per use. The pool is dropped by
+          /// initialize(), like the projector pool.
+          ConfigProjectorPtr_t sharedIntersectionProjector
+            (const EdgePtr_t& edgeB, const EdgePtr_t& edgeA) const;
+
+          /// Register the projector compiled for the ordered edge pair
+          /// (edgeB, edgeA).
+          void addSharedIntersectionProjector (const EdgePtr_t& edgeB,
+              const EdgePtr_t& edgeA, const ConfigProjectorPtr_t& projector);
+
+          /// Number of threads initialize() spreads the construction of
+          /// the state and edge constraint sets over. The constructions
+          /// are independent; the data they share - the projector and
+          /// validation pools, the histogram list - is mutex-guarded.
+          /// 1 (the default) keeps the sequential pass.
+          void initializationThreads (const size_type n)
+          {
+            initializationThreads_ = n;
+          }
+
+          size_type initializationThreads () const
+          {
+            return initializationThreads_;
+          }
+
           /// Set maximal number of iterations
           void maxIterations (size_type iterations);
 
@@ -227,6 +378,7 @@ namespace hpp {
           /// Register an histogram representing a foliation
           void insertHistogram (const graph::HistogramPtr_t& hist)
           {
+            boost::mutex::scoped_lock lock (sharedDataMutex_);
             hists_.push_back (hist);
           }
 
@@ -256,7 +408,8 @@ namespace hpp {
           /// Constructor
 	  /// \param sm a steering method to create paths from edges
           Graph (const std::string& name, const ProblemPtr_t& problem) :
-	    GraphComponent (name), problem_ (problem)
+	    GraphComponent (name), problem_ (problem), edgeTableDim_ (0),
+            initializationThreads_ (1)
           {}
 
           /// Print the object in a stream.
@@ -266,6 +419,23 @@ namespace hpp {
           /// The list of elements
           GraphComponents_t& components ();
 
+          /// Initialize the components of ranks congruent to \c rank
+          /// modulo \c nbThreads. The first failure is recorded in
+          /// \c error instead of escaping the worker thread.
+          void initializeWorker (const std::size_t rank,
+              const std::size_t nbThreads, std::string& error);
+
+          /// Fill edgeTable_ from the state neighbor lists.
+          void buildEdgeTable ();
+
+          /// Fill stateHopTable_ with a breadth first search from each
+          /// state over the adjacency stored in edgeTable_.
+          void buildStateHopTable ();
+
+          /// Fill stateByIndex_, edgeByIndex_ and edgeInfos_, paying
+          /// the weak pointer locks and dynamic casts once.
+          void buildComponentTables ();
+
           /// Keep track of the created components
           GraphComponents_t components_;
 
@@ -312,6 +482,48 @@ namespace hpp {
           typedef std::vector <ConstraintAndComplement_t>
             ConstraintsAndComplements_t;
           ConstraintsAndComplements_t constraintsAndComplements_;
+
+          /// Pool of projectors shared between edges with structurally
+          /// identical constraint stacks, keyed by signature.
+          /// \sa sharedConfigProjector
+          typedef std::map <std::string, ConfigProjectorPtr_t>
+            ConfigProjectorPool_t;
+          ConfigProjectorPool_t configProjectorPool_;
+
+          /// Pool of relative motion matrices and filtered path
+          /// validations, keyed like configProjectorPool_.
+          /// \sa sharedFilteredValidation
+          typedef std::map <std::string, FilteredValidation_t>
+            FilteredValidationPool_t;
+          FilteredValidationPool_t filteredValidationPool_;
+
+          /// Pool of intersection projectors, keyed by the ids of the
+          /// ordered edge pair. \sa sharedIntersectionProjector
+          typedef std::map <std::pair <std::size_t, std::size_t>,
+                  ConfigProjectorPtr_t> IntersectionProjectorPool_t;
+          IntersectionProjectorPool_t intersectionProjectorPool_;
+
+          /// Guards the shared pools above and the histogram list while
+          /// initialize() runs its workers; uncontended outside of the
+          /// parallel initialization pass.
+          mutable boost::mutex sharedDataMutex_;
+          /// See initializationThreads.
+          size_type initializationThreads_;
+
+          /// Dense (from state id, to state id) -> edge list table, built
+          /// by initialize() so that getEdges does not rescan the
+          /// neighbors of the source state on every steering attempt.
+          std::vector <Edges_t> edgeTable_;
+          std::size_t edgeTableDim_;
+
+          /// Shortest hop counts between states, indexed like
+          /// edgeTable_. -1 stands for unreachable.
+          std::vector <size_type> stateHopTable_;
+
+          /// Dense id-indexed component tables, see stateByIndex.
+          std::vector <State*> stateByIndex_;
+          std::vector <Edge*> edgeByIndex_;
+          std::vector <EdgeInfo_t> edgeInfos_;
           friend class GraphComponent;
       }; // Class Graph
 
@@ -17,6 +17,11 @@
 #ifndef HPP_MANIPULATION_GRAPH_GUIDED_STATE_SELECTOR_HH
 # define HPP_MANIPULATION_GRAPH_GUIDED_STATE_SELECTOR_HH
 
+#include <list>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
 #include "hpp/manipulation/fwd.hh"
 #include "hpp/manipulation/graph/fwd.hh"
 #include "hpp/manipulation/graph/state-selector.hh"
@@ -47,7 +52,8 @@ namespace hpp {
           /// Constructor
           GuidedStateSelector (const std::string& name,
               const core::RoadmapPtr_t roadmap) :
-            StateSelector (name), roadmap_ (roadmap)
+            StateSelector (name), roadmap_ (roadmap),
+            guideCacheRevision_ (0)
           {}
 
           /// Print the object in a stream.
@@ -60,6 +66,29 @@ namespace hpp {
           /// The roadmap
           core::RoadmapPtr_t roadmap_;
 
+          /// \name Guidance cache
+          /// \{
+          /// State sequence computed by the guidance A* for a roadmap
+          /// node, with the direction it was computed in. The sequence
+          /// only changes when the roadmap does, so chooseEdge caches it
+          /// per node and drops the whole cache when the roadmap
+          /// revision moves.
+          typedef std::list <StatePtr_t> GuideStates_t;
+          struct CachedGuide_t {
+            GuideStates_t states;
+            bool reverse;
+          };
+          typedef boost::unordered_map <RoadmapNodePtr_t, CachedGuide_t>
+            GuideCache_t;
+
+          mutable GuideCache_t guideCache_;
+          /// Roadmap revision the cache was filled at.
+          mutable std::size_t guideCacheRevision_;
+          /// Guards the cache when planner workers choose edges
+          /// concurrently. The A* searches themselves run unlocked.
+          mutable boost::mutex guideCacheMutex_;
+          /// \}
+
           /// Weak pointer to itself.
           GuidedStateSelectorWkPtr_t wkPtr_;
       }; // Class StateSelector
@@ -18,6 +18,7 @@
 # define HPP_MANIPULATION_GRAPH_STATE_HH
 
 # include <boost/function.hpp>
+# include <boost/thread/mutex.hpp>
 
 #include <hpp/core/locked-joint.hh>
 #include <hpp/core/constraint-set.hh>
@@ -71,6 +72,18 @@ namespace hpp {
           /// the constraints. Instead, use the class StateSelector.
           virtual bool contains (ConfigurationIn_t config) const;
 
+          /// Quick reject test for contains.
+          ///
+          /// Checks only the constraints specific to this state, not the
+          /// ones shared by the whole graph, so rejecting a candidate
+          /// state evaluates only the functions that distinguish it. The
+          /// error threshold is the one of the full constraint set and
+          /// the error of a subset is never larger than the error of the
+          /// whole set, hence
+          /// \code maybeContains(q) == false \endcode implies
+          /// \code contains(q) == false \endcode.
+          bool maybeContains (ConfigurationIn_t config) const;
+
           inline bool isWaypoint () const
           {
             return isWaypoint_;
@@ -99,6 +112,48 @@ namespace hpp {
             return neighbors_;
           }
 
+          /// \name Flat neighbor tables
+          ///
+          /// Parallel arrays over the outgoing edges: entry i of each
+          /// vector describes the same neighbor. They are rebuilt lazily
+          /// when an edge is inserted or a weight is changed through
+          /// updateWeight, so the edge selection loops stream through
+          /// contiguous memory instead of walking the distribution.
+          /// \{
+
+          /// Outgoing edges.
+          const std::vector <EdgePtr_t>& neighborEdges () const
+          {
+            if (neighborsDirty_) buildNeighborTables ();
+            return neighborEdges_;
+          }
+
+          /// Weight of each edge of neighborEdges ().
+          const vector_t& neighborWeights () const
+          {
+            if (neighborsDirty_) buildNeighborTables ();
+            return neighborWeights_;
+          }
+
+          /// Id of the destination state of each edge of
+          /// neighborEdges ().
+          const std::vector <std::size_t>& neighborStateIds () const
+          {
+            if (neighborsDirty_) buildNeighborTables ();
+            return neighborStateIds_;
+          }
+          /// \}
+
+          /// Sample an outgoing edge proportionally to the neighbor
+          /// weights, in constant time.
+          ///
+          /// The sampling uses a Walker alias table that is rebuilt
+          /// lazily when an edge is added or a weight is changed through
+          /// updateWeight, instead of accumulating the weights on every
+          /// call.
+          /// \return an empty shared pointer when the total weight is 0.
+          EdgePtr_t sampleNeighbor () const;
+
           void updateWeight (const EdgePtr_t&edge, const Weight_t& w);
 
           Weight_t getWeight (const EdgePtr_t&edge);
@@ -165,14 +220,54 @@ namespace hpp {
           virtual void initialize ();
 
         private:
+          /// Rebuild the alias table from the flat neighbor tables.
+          ///
+          /// Thread-safe: the rebuild is double-checked against
+          /// aliasDirty_ under tablesMutex_, so concurrent workers that
+          /// sample an edge of the same state serialize the first
+          /// rebuild instead of clearing the same vectors.
+          void buildAliasTable () const;
+
+          /// Rebuild the flat neighbor tables from neighbors_.
+          ///
+          /// Thread-safe, see buildAliasTable.
+          void buildNeighborTables () const;
+
+          /// Body of buildNeighborTables. tablesMutex_ must be held.
+          void fillNeighborTables () const;
+
           /// List of possible motions from this state (i.e. the outgoing
           /// vertices).
           Neighbors_t neighbors_;
           std::vector <EdgePtr_t> hiddenNeighbors_;
 
+          /// Flat neighbor tables, rebuilt on demand when
+          /// neighborsDirty_ is set. \sa neighborEdges
+          mutable std::vector <EdgePtr_t> neighborEdges_;
+          mutable vector_t neighborWeights_;
+          mutable std::vector <std::size_t> neighborStateIds_;
+          mutable bool neighborsDirty_;
+
+          /// Walker alias table over neighbors_, rebuilt on demand when
+          /// aliasDirty_ is set.
+          mutable std::vector <EdgePtr_t> aliasEdges_;
+          mutable std::vector <value_type> aliasProbabilities_;
+          mutable std::vector <std::size_t> aliases_;
+          mutable bool aliasDirty_;
+
+          /// Serializes the lazy rebuilds of the tables above: the first
+          /// access after an edge insertion or a weight update may come
+          /// from several planner workers at once.
+          mutable boost::mutex tablesMutex_;
+
           /// Set of constraints to be statisfied.
           ConstraintSetPtr_t configConstraints_;
 
+          /// Subset of configConstraints_ specific to this state, used
+          /// by maybeContains to discriminate between states without
+          /// re-evaluating the constraints shared by the whole graph.
+          ConstraintSetPtr_t discriminatingConstraints_;
+
           /// Stores the numerical constraints for path.
           NumericalConstraints_t numericalConstraintsForPath_;
           IntervalsContainer_t passiveDofsForPath_;
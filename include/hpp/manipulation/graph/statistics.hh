@@ -18,6 +18,8 @@
 #ifndef HPP_MANIPULATION_GRAPH_STATISTICS_HH
 # define HPP_MANIPULATION_GRAPH_STATISTICS_HH
 
+# include <boost/thread/mutex.hpp>
+
 # include <hpp/util/debug.hh>
 
 # include <hpp/statistics/bin.hh>
@@ -39,7 +41,8 @@ namespace hpp {
           typedef ::hpp::statistics::Bin Parent;
           typedef std::list <RoadmapNodePtr_t> RoadmapNodes_t;
 
-          LeafBin(const vector_t& v, value_type* threshold_);
+          LeafBin(const vector_t& v, value_type* threshold_,
+              const size_type* retention);
 
           void push_back(const RoadmapNodePtr_t& n);
 
@@ -62,6 +65,21 @@ namespace hpp {
 
           value_type* thr_;
 
+          /// Retention policy of the owning histogram, see
+          /// LeafHistogram::nodeRetention.
+          const size_type* retention_;
+
+          /// Number of observations, including those whose node was not
+          /// retained. Drives the reservoir sampling.
+          std::size_t seen_;
+
+          /// Hash of the parameter vector quantized with the threshold,
+          /// computed once at construction. Comparisons order bins by
+          /// hash first, so that lookups on the Roadmap::push_node path
+          /// cost integer compares instead of element-wise vector
+          /// compares; the vectors are only compared on equal hashes.
+          std::size_t hash_;
+
           std::ostream& printValue (std::ostream& os) const;
       };
 
@@ -71,7 +89,7 @@ namespace hpp {
       {
         public :
           typedef ::hpp::statistics::Bin Parent;
-          NodeBin(const StatePtr_t& n);
+          NodeBin(const StatePtr_t& n, const size_type* retention);
 
           void push_back(const RoadmapNodePtr_t& n);
 
@@ -89,6 +107,14 @@ namespace hpp {
           typedef std::list <RoadmapNodePtr_t> RoadmapNodes_t;
           RoadmapNodes_t roadmapNodes_;
 
+          /// Retention policy of the owning histogram, see
+          /// LeafHistogram::nodeRetention.
+          const size_type* retention_;
+
+          /// Number of observations, including those whose node was not
+          /// retained.
+          std::size_t seen_;
+
           std::ostream& printValue (std::ostream& os) const;
       };
 
@@ -119,6 +145,10 @@ namespace hpp {
           /// Whether the configuration is the submanifold $\mathcal{M}$
           vector_t parameter (ConfigurationIn_t q) const;
 
+          /// Same as parameter but writes into \c result, so that a
+          /// caller inserting many configurations can reuse one buffer.
+          void parameter (vector_t& result, ConfigurationIn_t q) const;
+
           void condition (const ConstraintSetPtr_t c);
           ConstraintSetPtr_t condition () const;
           void parametrizer (const ConstraintSetPtr_t p);
@@ -143,21 +173,69 @@ namespace hpp {
           /// Insert an occurence of a value in the histogram
           void add (const RoadmapNodePtr_t& n);
 
+          /// Insert a leaf observed in a previous run.
+          /// The bin of the parameter of \c n is created when needed,
+          /// its frequency raised by \c freq and the node retained as
+          /// representative of the leaf, so the sampling distributions
+          /// cover the leaf before the roadmap reaches it.
+          /// \sa LeafDatabase
+          void seed (const RoadmapNodePtr_t& n, const std::size_t freq);
+
           std::ostream& print (std::ostream& os) const;
 
           virtual HistogramPtr_t clone () const;
 
-          statistics::DiscreteDistribution < RoadmapNodePtr_t > getDistribOutOfConnectedComponent (
+          typedef statistics::DiscreteDistribution < RoadmapNodePtr_t >
+            NodeDistribution_t;
+          typedef boost::shared_ptr <NodeDistribution_t>
+            NodeDistributionPtr_t;
+
+          /// Distribution restricted to the observations out of the
+          /// given connected component. The weights depend on the
+          /// components, which merge without this histogram noticing,
+          /// so this distribution is rebuilt on every call.
+          NodeDistribution_t getDistribOutOfConnectedComponent (
               const core::ConnectedComponentPtr_t& cc) const;
 
-          statistics::DiscreteDistribution < RoadmapNodePtr_t > getDistrib () const;
+          /// Weighted distribution over the explored leaves.
+          ///
+          /// The distribution is cached and rebuilt only when the
+          /// histogram changed since the last call, so in steady state
+          /// a projection attempt samples a leaf in O(log bins) from
+          /// the shared snapshot instead of walking the bins. The
+          /// snapshot is never modified after it is built: callers may
+          /// keep it across further insertions.
+          NodeDistributionPtr_t getDistrib () const;
+
+          void clear ()
+          {
+            boost::mutex::scoped_lock lock (mutex_);
+            Parent::clear();
+            ++version_;
+            // The nodes the snapshot points to are being deleted.
+            distrib_.reset ();
+          }
 
-          void clear () { Parent::clear(); }
+          /// Retention policy of the roadmap nodes stored in the bins:
+          /// \li 0: keep the full list (default, previous behavior),
+          /// \li K > 0: keep a reservoir sample of K nodes per bin,
+          /// \li negative: keep counts only, no node.
+          /// Frequencies stay exact in every mode, only the node lists
+          /// are bounded. Applies to nodes added afterwards.
+          void nodeRetention (size_type n) { nodeRetention_ = n; }
+          size_type nodeRetention () const { return nodeRetention_; }
 
           const Foliation& foliation () const {
             return f_;
           }
 
+          /// Identifier of the foliation of this histogram, used to
+          /// index the parameter cache of the nodes. Unique per
+          /// foliation: a \ref clone shares the id of the original so
+          /// the cached parameters stay valid for both.
+          /// \sa RoadmapNode::cachedParameter
+          std::size_t id () const { return id_; }
+
         protected:
           /// Constructor
           /// \param state defines the submanifold containing the foliation.
@@ -168,8 +246,30 @@ namespace hpp {
         private:
           Foliation f_;
 
+          /// See id.
+          std::size_t id_;
+
           /// Threshold used for equality between offset values.
           value_type threshold_;
+
+          /// See nodeRetention. The bins point to this value, like they
+          /// point to threshold_.
+          size_type nodeRetention_;
+
+          /// Buffer for the foliation parameter of the inserted node,
+          /// preallocated so that add does not allocate per insertion.
+          mutable vector_t parameter_;
+
+          /// Incremented on every change of the histogram, compared to
+          /// distribVersion_ to rebuild the cached distribution only
+          /// when needed. Guarded by mutex_.
+          std::size_t version_;
+          /// See getDistrib.
+          mutable NodeDistributionPtr_t distrib_;
+          mutable std::size_t distribVersion_;
+
+          /// Makes add thread-safe when several planner workers run.
+          mutable boost::mutex mutex_;
       };
 
       class HPP_MANIPULATION_DLLLOCAL StateHistogram : public ::hpp::statistics::Statistics < NodeBin >
@@ -193,9 +293,20 @@ namespace hpp {
 
           void clear () { Parent::clear(); }
 
+          /// Retention policy of the roadmap nodes stored in the bins,
+          /// same convention as LeafHistogram::nodeRetention.
+          void nodeRetention (size_type n) { nodeRetention_ = n; }
+          size_type nodeRetention () const { return nodeRetention_; }
+
         private:
           /// The constraint graph
           graph::GraphPtr_t graph_;
+
+          /// See nodeRetention.
+          size_type nodeRetention_;
+
+          /// Makes add thread-safe when several planner workers run.
+          mutable boost::mutex mutex_;
       };
       typedef StateHistogram NodeHistogram HPP_MANIPULATION_DEPRECATED;
       typedef boost::shared_ptr <StateHistogram> NodeHistogramPtr_t;
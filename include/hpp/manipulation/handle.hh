@@ -20,6 +20,10 @@
 #ifndef HPP_MANIPULATION_HANDLE_HH
 # define HPP_MANIPULATION_HANDLE_HH
 
+# include <map>
+
+# include <boost/thread/mutex.hpp>
+
 # include <pinocchio/spatial/se3.hpp>
 
 # include <hpp/manipulation/fwd.hh>
@@ -131,6 +135,35 @@ namespace hpp {
       virtual NumericalConstraintPtr_t createPreGrasp
       (const GripperPtr_t& gripper, const value_type& shift, std::string name) const;
 
+      /// \name Shared grasp constraints
+      ///
+      /// Memoized variants of the creation methods above, keyed by
+      /// gripper. The first call delegates to the corresponding
+      /// virtual create method with the default name; subsequent calls
+      /// return the same shared instance. The graph construction
+      /// already shares one instance of each grasp constraint across
+      /// all the states and edges using it, so reusing them across
+      /// call sites is safe as long as nobody mutates them.
+      /// Thread-safe.
+      /// \{
+
+      /// Memoized createGrasp.
+      NumericalConstraintPtr_t grasp (const GripperPtr_t& gripper) const;
+
+      /// Memoized createGraspComplement.
+      NumericalConstraintPtr_t graspComplement (const GripperPtr_t& gripper)
+        const;
+
+      /// Memoized createGraspAndComplement.
+      NumericalConstraintPtr_t graspAndComplement (const GripperPtr_t& gripper)
+        const;
+
+      /// Memoized createPreGrasp, also keyed by the shift.
+      NumericalConstraintPtr_t pregrasp (const GripperPtr_t& gripper,
+          const value_type& shift) const;
+
+      /// \}
+
       /// Get the clearance
       ///
       /// The clearance is a distance, from the center of the gripper and along
@@ -168,9 +201,34 @@ namespace hpp {
 	weakPtr_ = weakPtr;
       }
 
+      /// Create the relative transformation function of a grasp task.
+      ///
+      /// Selects the compile-time specialized variant of
+      /// hpp::constraints matching the mask: when the mask only
+      /// constrains the position, resp. the orientation, the
+      /// position-only, resp. orientation-only, kernel is returned and
+      /// the unused half of the error and Jacobian is never computed
+      /// instead of being masked out afterwards. Mixed masks fall back
+      /// to the generic 6-DOF function.
+      static DifferentiableFunctionPtr_t maskedRelativeTransformation
+      (const std::string& name, const pinocchio::DevicePtr_t& robot,
+       const JointPtr_t& joint1, const JointPtr_t& joint2,
+       const Transform3f& frame1, const Transform3f& frame2,
+       const std::vector<bool>& mask);
+
       virtual std::ostream& print (std::ostream& os) const;
 
     private:
+      typedef std::map <std::string, NumericalConstraintPtr_t> GraspCache_t;
+
+      /// Return the cached constraint of key, empty when not there yet.
+      NumericalConstraintPtr_t cacheLookup (const std::string& key) const;
+
+      /// Insert the constraint under key unless another thread won the
+      /// race, and return the instance that ends up cached.
+      NumericalConstraintPtr_t cacheStore (const std::string& key,
+          const NumericalConstraintPtr_t& constraint) const;
+
       std::string name_;
       /// Position of the handle in the joint frame.
       Transform3f localPosition_;
@@ -180,6 +238,9 @@ namespace hpp {
       value_type clearance_;
       /// Mask
       std::vector<bool> mask_;
+      /// See grasp and its siblings. Filled lazily, so mutable.
+      mutable GraspCache_t graspCache_;
+      mutable boost::mutex graspCacheMutex_;
       /// Weak pointer to itself
       HandleWkPtr_t weakPtr_;
 
@@ -0,0 +1,101 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_LEAF_DATABASE_HH
+# define HPP_MANIPULATION_LEAF_DATABASE_HH
+
+# include <map>
+# include <string>
+# include <vector>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+# include "hpp/manipulation/graph/fwd.hh"
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup path_planning
+    /// \{
+
+    /// Persistent store of the leaves reached by LevelSetEdge sampling.
+    ///
+    /// The level-set histograms are accumulated per run, so every
+    /// process restart rediscovers the reachable leaves - grasp
+    /// offsets, placement positions - from zero while the workcell
+    /// barely changed. This database serializes, per LevelSetEdge, one
+    /// representative configuration and the observed frequency of each
+    /// leaf, keyed by a hash of the graph structure. preload() seeds
+    /// the freshly built histograms with the stored leaves, so
+    /// level-set sampling can jump between leaves from the first
+    /// iteration; save() folds the leaves observed by the current run
+    /// back into the store.
+    ///
+    /// A database recorded for a different graph - the structure hash
+    /// does not match - is ignored on load and overwritten on save.
+    ///
+    /// ManipulationPlanner drives the lifecycle when the string
+    /// parameter "LevelSetEdge/LeafDatabase" holds a path: preload at
+    /// construction, save at destruction.
+    class HPP_MANIPULATION_DLLAPI LeafDatabase
+    {
+      public:
+        /// Load the database when \c path exists and matches \c graph.
+        /// \param graph an initialized graph: the histograms of its
+        ///        level set edges must have been built.
+        LeafDatabase (const std::string& path,
+            const graph::GraphPtr_t& graph);
+
+        /// The seeded representative nodes are owned by the database.
+        ~LeafDatabase ();
+
+        /// Seed the histogram of every LevelSetEdge of the graph with
+        /// the stored leaves.
+        void preload ();
+
+        /// Fold the leaves observed by the current run into the store
+        /// and rewrite the file.
+        void save ();
+
+        /// Number of stored leaves, over all edges.
+        std::size_t nbLeaves () const;
+
+      private:
+        struct Leaf_t {
+          std::size_t freq;
+          vector_t configuration;
+        };
+        typedef std::vector <Leaf_t> Leaves_t;
+        /// Stored leaves, keyed by edge id.
+        typedef std::map <std::size_t, Leaves_t> Store_t;
+
+        void load ();
+        /// Merge the bins of the run-time histograms into store_.
+        void mergeHistograms ();
+
+        std::string path_;
+        graph::GraphWkPtr_t graph_;
+        /// Hash of the graph structure, see the class documentation.
+        std::size_t graphHash_;
+        Store_t store_;
+        /// Detached representative nodes created by preload, deleted
+        /// with the database.
+        std::vector <RoadmapNodePtr_t> seededNodes_;
+    }; // class LeafDatabase
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_LEAF_DATABASE_HH
@@ -17,6 +17,13 @@
 #ifndef HPP_MANIPULATION_MANIPULATION_PLANNER_HH
 # define HPP_MANIPULATION_MANIPULATION_PLANNER_HH
 
+#include <map>
+#include <set>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <hpp/core/path-planner.hh>
 
 #include <hpp/statistics/success-bin.hh>
@@ -27,6 +34,7 @@
 #include "hpp/manipulation/graph/fwd.hh"
 #include "hpp/manipulation/graph/graph.hh"
 #include "hpp/manipulation/fwd.hh"
+#include "hpp/manipulation/telemetry.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -48,8 +56,109 @@ namespace hpp {
         /// A set of constraints is chosen using the graph of constraints.
         /// A constraint extension is done using a chosen set.
         ///
+        /// The extension jobs - one per pair (connected component, graph
+        /// state) - are independent from each other. When
+        /// \ref numberOfThreads is greater than one, they are distributed
+        /// over a pool of worker threads and only the insertion of the
+        /// resulting edges in the roadmap is serialized.
         virtual void oneStep ();
 
+        /// Set the number of worker threads used by oneStep.
+        ///
+        /// \param n number of threads. 1 (the default) keeps the
+        ///        historical sequential behavior.
+        /// \warning when \c n is greater than 1, the steering method, path
+        ///          projector and path validation of the problem are called
+        ///          concurrently and must be reentrant.
+        void numberOfThreads (const size_type& n)
+        {
+          nbThreads_ = (n < 1 ? 1 : n);
+        }
+
+        /// Get the number of worker threads used by oneStep.
+        size_type numberOfThreads () const
+        {
+          return nbThreads_;
+        }
+
+        /// Set the projection success rate below which extensions are
+        /// pseudo-randomly skipped.
+        ///
+        /// The planner tracks the success rate of
+        /// graph::Edge::applyConstraints per (edge, leaf) pair. When the
+        /// rate of a pair drops below this floor, extend attempts it
+        /// only with probability rate / floor, reallocating the skipped
+        /// solver calls to productive pairs while keeping the model
+        /// able to recover.
+        /// \param rate in [0, 1]. 0 (the default) disables the model.
+        ///        Also set with the problem parameter
+        ///        ManipulationPlanner/ProjectionFloor.
+        void projectionFloor (const value_type& rate)
+        {
+          projectionFloor_ = (rate < 0 ? 0 : (rate > 1 ? 1 : rate));
+        }
+
+        value_type projectionFloor () const
+        {
+          return projectionFloor_;
+        }
+
+        /// \name Anytime planning
+        ///
+        /// solve() normally iterates until a solution is found. The two
+        /// budgets below bound one query: solve() still returns as soon
+        /// as the problem target reports a solution, but is interrupted
+        /// (and throws, as after a call to interrupt()) once the budget
+        /// is exhausted without one. continueInBackground() then keeps
+        /// growing the same roadmap on a spare core and re-extracts the
+        /// path between queries, so bestPath() returns an improving
+        /// solution over time.
+        /// \{
+
+        /// Set the time budget of one solve() call, in seconds.
+        /// 0 (the default) means no time limit. Also set with the
+        /// problem parameter ManipulationPlanner/TimeBudget.
+        void timeBudget (const value_type& seconds)
+        {
+          timeBudget_ = (seconds < 0 ? 0 : seconds);
+        }
+
+        value_type timeBudget () const
+        {
+          return timeBudget_;
+        }
+
+        /// Set the iteration budget of one solve() call.
+        /// 0 (the default) means no limit. Also set with the problem
+        /// parameter ManipulationPlanner/IterationBudget.
+        void iterationBudget (const size_type& n)
+        {
+          iterationBudget_ = (n < 0 ? 0 : n);
+        }
+
+        size_type iterationBudget () const
+        {
+          return iterationBudget_;
+        }
+
+        /// Keep planning on a background thread.
+        ///
+        /// The thread alternates between growing the roadmap of this
+        /// planner and re-extracting the path through it; each
+        /// extraction is subject to the budgets above. Call
+        /// stopBackground() before using the planner or its roadmap
+        /// directly again.
+        void continueInBackground ();
+
+        /// Get the best (shortest) path found so far.
+        /// Thread-safe with respect to the background thread.
+        core::PathVectorPtr_t bestPath () const;
+
+        /// Interrupt and join the background thread, if any.
+        void stopBackground ();
+
+        /// \}
+
         /// Extend configuration q_near toward q_rand.
         /// \param q_near the configuration to be extended.
         /// \param q_rand the configuration toward extension is performed.
@@ -69,21 +178,120 @@ namespace hpp {
         /// \sa ManipulationPlanner::getEdgeStat
         static StringList_t errorList ();
 
+        /// Telemetry accumulated by oneStep and extend. Unlike the HPP
+        /// time counters, it stays enabled in release builds; use
+        /// Telemetry::writeJSON or Telemetry::writeCSV to dump it.
+        Telemetry& telemetry ()
+        {
+          return telemetry_;
+        }
+
+        const Telemetry& telemetry () const
+        {
+          return telemetry_;
+        }
+
+        virtual ~ManipulationPlanner ();
+
       protected:
         /// Protected constructor
         ManipulationPlanner (const Problem& problem,
             const RoadmapPtr_t& roadmap);
 
+        /// Call the parent implementation and start the anytime budget
+        /// clock of the query.
+        virtual void startSolve ();
+
         /// Store weak pointer to itself
         void init (const ManipulationPlannerWkPtr_t& weak);
 
       private:
-        /// Try to connect nodes of the roadmap to other connected components.
+        /// An extension job: the node to extend and the configuration to
+        /// extend it toward.
+        typedef std::pair <RoadmapNodePtr_t, ConfigurationPtr_t>
+          ExtensionJob_t;
+        typedef std::vector <ExtensionJob_t> ExtensionJobs_t;
+
+        /// Reentrant implementation of \ref extend.
+        /// \param qProj buffer where the projected configuration is computed,
+        ///        owned by the calling worker.
+        /// \param rank rank of the calling worker, used to select the
+        ///        statistics shard outcomes are recorded in.
+        bool extend (RoadmapNodePtr_t n_near,
+            const ConfigurationPtr_t& q_rand, core::PathPtr_t& validPath,
+            Configuration_t& qProj, const std::size_t rank);
+
+        /// Run the extension jobs of rank \c rank modulo nbThreads_.
+        /// \retval paths one slot per job, left empty on failed extensions.
+        void extendWorker (const ExtensionJobs_t& jobs,
+            std::vector <core::PathPtr_t>& paths, const std::size_t rank);
+
+        /// A candidate connection between two connected components,
+        /// ordered by increasing distance.
+        struct ConnectionCandidate {
+          core::NodePtr_t n1, n2;
+          value_type distance;
+          ConnectionCandidate (const core::NodePtr_t& a,
+              const core::NodePtr_t& b, const value_type& d) :
+            n1 (a), n2 (b), distance (d) {}
+          bool operator< (const ConnectionCandidate& other) const
+          {
+            return distance < other.distance;
+          }
+        };
+        typedef std::vector <ConnectionCandidate> ConnectionCandidates_t;
+        /// Unordered node pairs already attempted, shared by
+        /// tryConnectNewNodes and tryConnectToRoadmap within one step.
+        typedef std::pair <core::NodePtr_t, core::NodePtr_t> NodePair_t;
+        typedef std::set <NodePair_t> NodePairs_t;
+
+        /// Attempt the candidate connections by increasing distance.
+        /// Pairs in \c attempted and pairs whose components have merged
+        /// since candidate generation are skipped.
         /// \return the number of connection made.
-        std::size_t tryConnectToRoadmap (const core::Nodes_t nodes);
+        std::size_t attemptConnections (ConnectionCandidates_t& candidates,
+            NodePairs_t& attempted);
+
+        /// Try to connect nodes of the roadmap to other connected
+        /// components, using the K nearest nodes of each component as
+        /// candidates.
+        /// \return the number of connection made.
+        std::size_t tryConnectToRoadmap (const core::Nodes_t nodes,
+            NodePairs_t& attempted);
         /// Try to connect nodes in a list between themselves.
         /// \return the number of connection made.
-        std::size_t tryConnectNewNodes (const core::Nodes_t nodes);
+        std::size_t tryConnectNewNodes (const core::Nodes_t nodes,
+            NodePairs_t& attempted);
+
+        /// Per-iteration memo of pairwise node distances: an open
+        /// addressing table with linear probing, keyed by the ordered
+        /// node pointer pair and cleared by oneStep. The connection
+        /// phases may propose the same pair several times within one
+        /// step; the memo makes sure the metric - the second largest
+        /// oneStep cost after projection - is evaluated at most once
+        /// per pair.
+        struct DistanceMemo {
+          struct Slot {
+            const core::Node* a;
+            const core::Node* b;
+            value_type d;
+            Slot () : a (NULL), b (NULL), d (0) {}
+          };
+          std::vector <Slot> slots;
+          std::size_t used;
+          DistanceMemo () : used (0) {}
+          /// Empty the table, sized for about \c n pairs.
+          void clear (const std::size_t n);
+          bool find (const core::Node* a, const core::Node* b,
+              value_type& d) const;
+          void store (const core::Node* a, const core::Node* b,
+              const value_type d);
+        };
+        DistanceMemo distanceMemo_;
+        /// Distance between two nodes, served from \ref distanceMemo_
+        /// when the pair was measured before in this iteration.
+        value_type memoizedDistance (const core::DistancePtr_t& distance,
+            const core::NodePtr_t& n1, const core::NodePtr_t& n2);
 
         /// Configuration shooter
         ConfigurationShooterPtr_t shooter_;
@@ -99,9 +307,128 @@ namespace hpp {
         typedef ::hpp::statistics::SuccessStatistics SuccessStatistics;
         typedef ::hpp::statistics::SuccessBin SuccessBin;
         typedef ::hpp::statistics::SuccessBin::Reason Reason;
-        SuccessStatistics& edgeStat (const graph::EdgePtr_t& edge);
-        std::vector<size_type> indexPerEdgeStatistics_;
-        std::vector<SuccessStatistics> perEdgeStatistics_;
+        /// Online success model of Edge::applyConstraints on one
+        /// (edge, leaf) pair, see \ref projectionFloor. The leaf is
+        /// identified by the symbolic component of the extended node.
+        struct ProjectionModel {
+          size_type nbObs, nbSuccess;
+          ProjectionModel () : nbObs (0), nbSuccess (0) {}
+          /// Laplace-smoothed success rate, so that fresh bins start
+          /// optimistic instead of at 0.
+          value_type successRate () const
+          {
+            return (value_type) (nbSuccess + 1) / (value_type) (nbObs + 2);
+          }
+        };
+        typedef std::pair <std::size_t, SymbolicComponentPtr_t>
+          ProjectionKey_t;
+        typedef std::map <ProjectionKey_t, ProjectionModel>
+          ProjectionModels_t;
+
+        /// Per-worker statistics shard. A worker thread only writes to
+        /// the shard of its own rank, so recording an extension outcome
+        /// never locks; getEdgeStat merges the shards on read.
+        struct StatisticsShard {
+          std::vector<size_type> indexPerEdge;
+          std::vector<SuccessStatistics> perEdge;
+          ProjectionModels_t projectionModels;
+        };
+        SuccessStatistics& edgeStat (const graph::EdgePtr_t& edge,
+            const std::size_t& rank);
+        std::vector<StatisticsShard> statisticsShards_;
+
+        /// Per-worker mutable scratch state. All the temporaries extend
+        /// writes live either here or in statisticsShards_, keyed by
+        /// worker rank, so extend itself is a pure function of
+        /// (node, target) and can run from several workers at once.
+        struct WorkerContext {
+          Configuration_t qProj;
+          /// Own validation instance of the worker, built by the
+          /// problem factory. GraphPathValidation is stateful, so the
+          /// ranks must not share the problem's instance.
+          GraphPathValidationPtr_t pathValidation;
+        };
+        mutable std::vector<WorkerContext> workerContexts_;
+        /// Grow the context and statistics pools to \c n workers. Must
+        /// only be called while no worker is running.
+        void growWorkerPools (const std::size_t n);
+
+        /// Attempt one graph edge from configuration \c q_from toward
+        /// the target stored in \c qProj.
+        /// On success \c qProj holds the reached configuration and
+        /// \c validPath the valid part of the edge path.
+        /// \param model projection reject model to feed, may be NULL.
+        /// \retval fullyValid whether the whole edge path is valid.
+        /// \retval trimmed whether validPath was cut by extendStep_.
+        bool extendAlongEdge (const graph::EdgePtr_t& edge,
+            ConfigurationIn_t q_from, Configuration_t& qProj,
+            const std::size_t rank, ProjectionModel* model,
+            core::PathPtr_t& validPath, bool& fullyValid, bool& trimmed);
+
+        /// Shoot a random configuration, or pop the next one from the
+        /// replay log when one is loaded. Shot configurations are
+        /// appended to the record log when one is open.
+        ConfigurationPtr_t shootConfiguration ();
+
+        /// Select a graph edge to extend \c n_near along.
+        /// The chosen edge goes through the record/replay logs like the
+        /// shot configurations.
+        /// Applies the projection reject model of \ref projectionFloor.
+        /// \retval model the reject model fed by the selection, NULL when
+        ///         the model is disabled.
+        /// \return an empty pointer when no edge is available or the
+        ///         attempt is skipped by the reject model.
+        graph::EdgePtr_t selectEdge (RoadmapNodePtr_t n_near,
+            const std::size_t rank, ProjectionModel*& model);
+
+        /// First stage of \ref extendAlongEdge: constraint projection,
+        /// steering and path projection. No collision checking happens
+        /// here.
+        /// \retval projPath the candidate path, to be validated.
+        /// \retval projShorter whether the path projector shortened it.
+        bool projectAndBuild (const graph::EdgePtr_t& edge,
+            ConfigurationIn_t q_from, Configuration_t& qProj,
+            const std::size_t rank, ProjectionModel* model,
+            core::PathPtr_t& projPath, bool& projShorter);
+
+        /// Second stage of \ref extendAlongEdge: path validation and
+        /// trimming of \c projPath, recording outcome statistics.
+        bool validateCandidate (const graph::EdgePtr_t& edge,
+            const core::PathPtr_t& projPath, const bool projShorter,
+            const std::size_t rank, core::PathPtr_t& validPath,
+            bool& fullyValid, bool& trimmed);
+
+        /// A candidate path produced by \ref projectAndBuild, waiting
+        /// for validation. An empty edge marks a failed production.
+        struct ValidationCandidate_t {
+          graph::EdgePtr_t edge;
+          core::PathPtr_t projPath;
+          bool projShorter;
+          ValidationCandidate_t () : projShorter (false) {}
+        };
+        typedef std::vector <ValidationCandidate_t> ValidationCandidates_t;
+
+        /// Run \ref projectAndBuild on the jobs of rank \c rank modulo
+        /// nbThreads_, filling the corresponding candidate slots.
+        void produceWorker (const ExtensionJobs_t& jobs,
+            ValidationCandidates_t& candidates, const std::size_t rank);
+
+        /// Run \ref validateCandidate on the candidates at the given
+        /// indices. oneStep assigns the candidates of one edge to the
+        /// same validator, so the stateful per-edge validation objects
+        /// are not contended between the ranks.
+        /// \retval paths one slot per candidate, left empty on failure.
+        void validateWorker (const ValidationCandidates_t& candidates,
+            const std::vector <std::size_t>& indices,
+            std::vector <core::PathPtr_t>& paths, const std::size_t rank);
+
+        /// Per-step scratch arrays of oneStep - the jobs, the candidate
+        /// slots of the validation pipeline and the result paths. They
+        /// are members so their storage is recycled from one call to the
+        /// next instead of being reallocated every iteration.
+        ExtensionJobs_t jobsBuffer_;
+        ValidationCandidates_t candidatesBuffer_;
+        std::vector <core::PathPtr_t> pathsBuffer_;
 
         /// A Reason is associated to each EdgePtr_t that generated a failure.
         enum TypeOfFailure {
@@ -116,9 +443,111 @@ namespace hpp {
         };
         static const std::vector<Reason> reasons_;
 
+        /// Record a failed extension in the edge statistics.
+        void addFailure (TypeOfFailure t, SuccessStatistics& es);
+        /// Record a successful extension, qualified by \c t.
+        void addSuccess (TypeOfFailure t, SuccessStatistics& es);
+
+        /// Body of the background planning thread, see
+        /// continueInBackground.
+        void backgroundWorker ();
+
         value_type extendStep_;
 
-        mutable Configuration_t qProj_;
+        /// Maximal number of graph edges chained within one extend call,
+        /// see the parameter ManipulationPlanner/GreedyDepth. 1 (the
+        /// default) reproduces the single edge extension.
+        size_type greedyDepth_;
+
+        /// Number of configurations shot per call to oneStep. Set with the
+        /// problem parameter ManipulationPlanner/BatchSize.
+        size_type batchSize_;
+        /// Number of worker threads running extension jobs in oneStep.
+        size_type nbThreads_;
+        /// Projection success rate below which extensions are skipped,
+        /// see projectionFloor.
+        value_type projectionFloor_;
+        /// When true and several workers are available, oneStep runs
+        /// projection/steering and path validation as two successive
+        /// stages over the whole batch instead of fused per-job. Set
+        /// with the problem parameter
+        /// ManipulationPlanner/PipelineValidation.
+        bool pipelineValidation_;
+        /// When true, this planner assumes other planner instances grow
+        /// the same roadmap concurrently: oneStep takes the roadmap
+        /// write mutex around its structural phases - statistics flush,
+        /// nearest neighbor collection, node and edge insertion - and
+        /// the extension work serializes per edge, since the planners
+        /// share the stateful edge objects. The extension work, which
+        /// dominates, otherwise runs unlocked. Set with the problem
+        /// parameter ManipulationPlanner/SharedRoadmap.
+        bool sharedRoadmap_;
+        /// Period, in oneStep iterations, of Roadmap::publish in shared
+        /// mode. Publishing snapshots the whole roadmap - O(nodes +
+        /// edges) under the write mutex - so doing it every iteration
+        /// would cost more than the iteration itself once the roadmap
+        /// grows. Set with ManipulationPlanner/PublishPeriod.
+        size_type publishPeriod_;
+        /// Iterations since the last publication.
+        size_type stepsSincePublish_;
+
+        /// Rewrite the edge sampling weights of the constraint graph
+        /// from the accumulated per-edge success statistics: each edge
+        /// gets its base weight scaled by its smoothed success rate,
+        /// kept above \ref weightFloor_ so unproductive edges are still
+        /// explored. Called from oneStep while no worker runs.
+        void adaptEdgeWeights ();
+        /// Period, in oneStep iterations, of \ref adaptEdgeWeights.
+        /// 0 (the default) leaves the graph weights untouched. Set with
+        /// the parameter ManipulationPlanner/AdaptWeightsPeriod.
+        /// Ignored - with a warning - in shared roadmap mode, where
+        /// other planner instances sample the weight tables
+        /// concurrently.
+        size_type adaptWeightsPeriod_;
+        /// Exploration floor of the adaptive weights: the fraction of
+        /// its base weight an edge keeps however unproductive it
+        /// proved. Set with the parameter
+        /// ManipulationPlanner/WeightFloor.
+        value_type weightFloor_;
+        /// Iterations since the last adaptEdgeWeights call.
+        size_type stepsSinceWeightUpdate_;
+        /// Base sampling weight per edge id, recorded before the first
+        /// rewrite so the adapted weights never drift from repeated
+        /// scaling.
+        std::map <std::size_t, value_type> baseWeights_;
+
+        /// Anytime budgets of one solve() call, see timeBudget and
+        /// iterationBudget.
+        value_type timeBudget_;
+        size_type iterationBudget_;
+        /// Budget clock and iteration count of the current query, reset
+        /// by startSolve.
+        boost::posix_time::ptime solveStart_;
+        size_type iterationsDone_;
+
+        /// Background continuation thread and the best path it found,
+        /// guarded by backgroundMutex_.
+        boost::thread* backgroundThread_;
+        bool stopBackground_;
+        core::PathVectorPtr_t bestPath_;
+        mutable boost::mutex backgroundMutex_;
+
+        /// Always-on counters, sharded per worker like
+        /// statisticsShards_. See telemetry().
+        Telemetry telemetry_;
+
+        /// Record and replay of the random decisions of a run, for
+        /// deterministic benchmarking. Null when disabled; set with the
+        /// parameters ManipulationPlanner/RecordLog and
+        /// ManipulationPlanner/ReplayLog. \sa DecisionLogWriter
+        DecisionLogWriterPtr_t recordLog_;
+        DecisionLogReaderPtr_t replayLog_;
+
+        /// Cross-run store of the leaves reached by level-set
+        /// sampling, preloaded at construction and saved at
+        /// destruction. Null when the parameter
+        /// LevelSetEdge/LeafDatabase is unset. \sa LeafDatabase
+        LeafDatabasePtr_t leafDatabase_;
     };
     /// \}
   } // namespace manipulation
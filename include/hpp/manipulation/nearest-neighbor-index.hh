@@ -0,0 +1,97 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_NEAREST_NEIGHBOR_INDEX_HH
+# define HPP_MANIPULATION_NEAREST_NEIGHBOR_INDEX_HH
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup roadmap
+    /// \{
+
+    /// Incremental metric index over a set of roadmap nodes.
+    ///
+    /// The index is a vantage-point tree built with the distance of the
+    /// problem only, so it supports any metric, in particular
+    /// WeighedDistance on non-Euclidean configuration spaces. One instance
+    /// is maintained per (graph state, connected component) bucket by
+    /// ConnectedComponent, which makes Roadmap::nearestNode sub-linear in
+    /// the roadmap size.
+    class HPP_MANIPULATION_DLLAPI NearestNeighborIndex
+    {
+      public:
+        NearestNeighborIndex (const core::DistancePtr_t& distance);
+
+        ~NearestNeighborIndex ();
+
+        /// Insert a node in the index.
+        void insert (const RoadmapNodePtr_t& node);
+
+        /// Get the node of the index closest to a configuration.
+        /// \retval minDistance distance to the returned node, infinity when
+        ///         the index is empty.
+        /// \return the closest node, NULL when the index is empty.
+        RoadmapNodePtr_t nearest (const Configuration_t& q,
+            value_type& minDistance) const;
+
+        /// Move the content of other into this index.
+        /// The nodes of the smaller of the two indexes are re-inserted in
+        /// the larger one. \c other is empty after calling this method.
+        void merge (const NearestNeighborIndexPtr_t& other);
+
+        /// Number of indexed nodes.
+        std::size_t size () const
+        {
+          return size_;
+        }
+
+        /// Remove every node from the index.
+        void clear ();
+
+      private:
+        /// A cell is either a leaf holding a small bucket of nodes with
+        /// their configurations packed contiguously, or a split cell
+        /// partitioning its subtree around a pivot node and a radius.
+        struct Cell;
+
+        /// Number of nodes a leaf can hold before being split. Leaf
+        /// configurations are stored column-major so the batched distance
+        /// kernel of WeighedDistance streams through them.
+        static const std::size_t bucketSize_ = 32;
+
+        void insert (Cell*& cell, const RoadmapNodePtr_t& node);
+        void append (Cell* cell, const RoadmapNodePtr_t& node);
+        void split (Cell* cell);
+        void search (const Cell* cell, const Configuration_t& q,
+            RoadmapNodePtr_t& closest, value_type& minDistance) const;
+        static void collect (Cell* cell, RoadmapNodes_t& nodes);
+        static void destroy (Cell* cell);
+
+        core::DistancePtr_t distance_;
+        /// Set when distance_ is a manipulation::WeighedDistance, in which
+        /// case leaf buckets are evaluated with the batched kernel.
+        WeighedDistancePtr_t weighedDistance_;
+        Cell* root_;
+        std::size_t size_;
+    }; // class NearestNeighborIndex
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_NEAREST_NEIGHBOR_INDEX_HH
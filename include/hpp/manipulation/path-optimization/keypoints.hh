@@ -17,6 +17,8 @@
 #ifndef HPP_MANIPULATION_PATHOPTIMIZATION_KEYPOINTS_HH
 #define HPP_MANIPULATION_PATHOPTIMIZATION_KEYPOINTS_HH
 
+# include <map>
+
 # include <hpp/core/path-optimizer.hh>
 # include <hpp/core/path-optimizer.hh>
 
@@ -59,6 +61,21 @@ namespace hpp {
           };
           typedef std::vector<InterKeypointPath> IKPvector_t;
 
+          /// Outcome of the validation of one shortcut segment.
+          /// The segment is identified by its end configurations and the
+          /// edge used to build it (NULL when it comes from the steering
+          /// method): projection being deterministic, the path only
+          /// depends on them. Entries are indexed by a hash of the key;
+          /// collisions are resolved by comparing the stored
+          /// configurations, so a hit is always exact.
+          struct ValidatedSegment {
+            graph::EdgePtr_t edge;
+            Configuration_t q1, q2;
+            bool valid;
+          };
+          typedef std::multimap<std::size_t, ValidatedSegment>
+            ValidationCache_t;
+
           IKPvector_t split (PathVectorPtr_t path) const;
 
           PathVectorPtr_t shorten (const IKPvector_t& paths,
@@ -67,6 +84,17 @@ namespace hpp {
           IKPvector_t replaceInPath(const IKPvector_t& input,
               const PathVectorPtr_t& shortcut,
               std::size_t i1, std::size_t i2) const;
+
+          /// Validate \c path, reusing the outcome of a previous
+          /// validation of the same segment when available.
+          bool validateWithCache (const PathPtr_t& path,
+              const graph::EdgePtr_t& edge,
+              const Configuration_t& q1, const Configuration_t& q2) const;
+
+          /// Validation outcomes of the segments tried so far. The cache
+          /// survives the path rewrites performed by replaceInPath, which
+          /// re-splits the whole path but leaves most segments unchanged.
+          mutable ValidationCache_t validationCache_;
       };
 
       /// \}
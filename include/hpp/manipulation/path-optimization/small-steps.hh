@@ -17,10 +17,13 @@
 #ifndef HPP_MANIPULATION_PATHOPTIMIZATION_SMALLSTEPS_HH
 #define HPP_MANIPULATION_PATHOPTIMIZATION_SMALLSTEPS_HH
 
+#include <vector>
+
 #include <hpp/manipulation/fwd.hh>
 #include <hpp/manipulation/config.hh>
 
 #include <hpp/core/path-optimizer.hh>
+#include <hpp/core/problem.hh>
 
 namespace hpp {
   namespace manipulation {
@@ -36,6 +39,15 @@ namespace hpp {
       /// Walking trajectory generator for paths created with the constraint graph
       ///
       /// This class encapsulates hpp::wholebodyStep::SmallSteps.
+      ///
+      /// When the problem parameter SmallSteps/Incremental is set, the
+      /// optimizer remembers the groups of subpaths it handed to the
+      /// walk generator and the timing solutions it got back. The next
+      /// call then reuses the solution of every group of the unchanged
+      /// prefix and only regenerates from the first divergent group,
+      /// which is what replanning produces: a shared prefix and a new
+      /// suffix. Off by default: each call is then independent as
+      /// before.
       class HPP_MANIPULATION_DLLAPI SmallSteps : public PathOptimizer
       {
         public:
@@ -50,8 +62,27 @@ namespace hpp {
         protected:
           /// Constructor
           SmallSteps (const core::Problem& problem) :
-            PathOptimizer (problem)
+            PathOptimizer (problem),
+            incremental_ (problem.getParameter ("SmallSteps/Incremental",
+                                                false))
         {}
+
+        private:
+          /// One group of flattened subpaths walked in a single call to
+          /// the generator, with the solution it returned. The inputs
+          /// are compared by pointer: replanning keeps the untouched
+          /// prefix subpaths alive, so pointer equality identifies an
+          /// unchanged group without comparing configurations.
+          struct CachedGroup_t {
+            std::vector <PathPtr_t> inputs;
+            PathVectorPtr_t output;
+          };
+          typedef std::vector <CachedGroup_t> GroupCache_t;
+
+          /// See class documentation.
+          bool incremental_;
+          /// Groups of the previous call, empty unless incremental.
+          GroupCache_t cache_;
       };
       /// \}
 
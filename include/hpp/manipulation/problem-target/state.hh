@@ -55,11 +55,19 @@ namespace hpp {
         protected:
           /// Constructor
           State (const core::ProblemPtr_t& problem)
-            : ProblemTarget (problem)
+            : ProblemTarget (problem), lastInitCC_ (NULL)
           {}
 
         private:
           graph::StatePtr_t state_;
+
+          /// Cached down-cast of the initial node's connected component.
+          /// The component object only changes when a merge absorbs the
+          /// initial node's component, so reached() refreshes the cast
+          /// only then and is otherwise a hash lookup in the per-state
+          /// node sets that the component maintains incrementally.
+          mutable core::ConnectedComponent* lastInitCC_;
+          mutable ConnectedComponentPtr_t initCC_;
       }; // class State
       /// \}
     } // namespace problemTarget
@@ -80,6 +80,18 @@ namespace hpp {
           pvTol_ = tol;
         }
 
+        /// Revision of the obstacle geometry.
+        ///
+        /// Path validations pool the obstacles at construction time;
+        /// the pooled instances are reused as long as this value is
+        /// unchanged and rebuilt otherwise. The revision is
+        /// approximated by the number of collision obstacles, which
+        /// only ever grows in practice.
+        std::size_t geometryEpoch () const
+        {
+          return collisionObstacles ().size ();
+        }
+
       private:
         /// The graph of constraints
         graph::GraphPtr_t graph_;
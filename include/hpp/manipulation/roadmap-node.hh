@@ -19,6 +19,11 @@
 #ifndef HPP_MANIPULATION_ROADMAP_NODE_HH
 # define HPP_MANIPULATION_ROADMAP_NODE_HH
 
+# include <cassert>
+# include <vector>
+
+# include <boost/functional/hash.hpp>
+
 # include <hpp/core/node.hh>
 
 # include <hpp/manipulation/fwd.hh>
@@ -35,6 +40,7 @@ namespace hpp {
         RoadmapNode (const ConfigurationPtr_t& configuration) :
           core::Node (configuration),
           cacheSystem_ (defaultCachingSystem),
+          configHash_ (hash (*configuration)),
           state_ ()
         {}
 
@@ -90,23 +96,118 @@ namespace hpp {
           if (cacheSystem_ != CACHE_DISABLED) cacheSystem_ = CACHE_UP_TO_DATE;
           state_ = state;
         }
+
+        /// Invalidate the cached graph::State.
+        /// To be called when the constraint graph changes after the node
+        /// was inserted, so that the state is looked up again on the next
+        /// access.
+        void invalidateGraphState ()
+        {
+          if (cacheSystem_ != CACHE_DISABLED) cacheSystem_ = CACHE_NEED_UPDATE;
+        }
         /// \}
 
-        void symbolicComponent (const SymbolicComponentPtr_t& sc)
+        /// \name Configuration hash
+        /// \{
+
+        /// Hash of a configuration, as used by the duplicate detection
+        /// index of the roadmap.
+        static std::size_t hash (ConfigurationIn_t q)
         {
-          symbolicCC_ = sc;
+          return boost::hash_range (q.data (), q.data () + q.size ());
         }
 
-        SymbolicComponentPtr_t symbolicComponent () const
+        /// Hash of the configuration of this node, computed once at
+        /// construction. \sa Roadmap::nodeWithConfiguration
+        std::size_t configurationHash () const
         {
-          return symbolicCC_;
+          return configHash_;
         }
+        /// \}
+
+        /// \name Pool allocation
+        /// \{
+
+        /// Nodes are allocated from a dedicated memory pool: roadmap
+        /// growth creates millions of small objects and the pool avoids
+        /// both allocator contention and fragmentation. Deletion returns
+        /// the storage to the pool; Roadmap::clear releases the unused
+        /// pool memory in bulk.
+        static void* operator new (std::size_t size);
+        static void operator delete (void* pointer);
+
+        /// Return the memory of pool blocks that contain no live node to
+        /// the system. Called by Roadmap::clear.
+        static void releasePoolMemory ();
+        /// \}
+
+        /// \name Foliation parameter cache
+        /// \{
+
+        /// Parameter of this node in the foliation identified by \c id,
+        /// NULL when it was not computed yet.
+        ///
+        /// The histograms and the leaf database evaluate the same
+        /// parametrization functions on the same configurations; the
+        /// cache makes each (node, foliation) evaluation happen at most
+        /// once. \sa graph::LeafHistogram::id
+        const vector_t* cachedParameter (const std::size_t id) const;
+
+        /// Store the parameter of this node in foliation \c id and
+        /// return the stored copy.
+        ///
+        /// \warning not thread-safe by itself: the insertion paths that
+        /// fill the cache are serialized by the roadmap, see
+        /// Roadmap::writeMutex.
+        const vector_t& cacheParameter (const std::size_t id,
+            const vector_t& value) const;
+        /// \}
+
+        /// Copy the lazily computed caches - graph state and foliation
+        /// parameters - from a node holding the same configuration.
+        ///
+        /// Used when importing the node of another roadmap: the source
+        /// roadmap already solved the state constraints and the
+        /// foliation parametrizations for this configuration, so the
+        /// copy avoids re-evaluating them. \sa Roadmap::merge
+        void copyCachesFrom (const RoadmapNode* other)
+        {
+          assert (*other->configuration () == *configuration ());
+          if (cacheSystem_ != CACHE_DISABLED &&
+              other->cacheSystem_ == CACHE_UP_TO_DATE) {
+            state_ = other->state_;
+            cacheSystem_ = CACHE_UP_TO_DATE;
+          }
+          foliationParameters_ = other->foliationParameters_;
+        }
+
+        void symbolicComponent (const SymbolicComponentPtr_t& sc)
+        {
+          symbolicCC_ = sc;
+        }
+
+        /// Get the symbolic component containing this node.
+        ///
+        /// The stored component may have been merged away since it was
+        /// set; the lookup resolves it to its representative and stores
+        /// the result, so chains of merges are followed at most once
+        /// per node.
+        SymbolicComponentPtr_t symbolicComponent () const;
 
       private:
         CachingSystem cacheSystem_;
 
+        /// See configurationHash().
+        std::size_t configHash_;
+
         graph::StateWkPtr_t state_;
-        SymbolicComponentPtr_t symbolicCC_;
+        mutable SymbolicComponentPtr_t symbolicCC_;
+
+        /// See cachedParameter. A node traverses few foliations so the
+        /// entries live in a small unsorted vector and lookup is a
+        /// linear scan over the ids.
+        typedef std::pair <std::size_t, vector_t> FoliationParameter_t;
+        mutable std::vector <FoliationParameter_t> foliationParameters_;
     };
   } // namespace manipulation
 } // namespace hpp
@@ -0,0 +1,146 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_ROADMAP_SNAPSHOT_HH
+# define HPP_MANIPULATION_ROADMAP_SNAPSHOT_HH
+
+# include <fstream>
+# include <map>
+# include <string>
+
+# include <boost/cstdint.hpp>
+
+# include "hpp/manipulation/config.hh"
+# include "hpp/manipulation/fwd.hh"
+
+namespace hpp {
+  namespace manipulation {
+    /// \addtogroup roadmap
+    /// \{
+
+    /// Incremental binary snapshot of a Roadmap.
+    ///
+    /// The snapshot is split into flat append-only arrays so that a
+    /// checkpoint only writes the nodes and edges added since the
+    /// previous one, and so that the reader can map the arrays directly
+    /// into memory. Four files are written, derived from the snapshot
+    /// name \c path:
+    /// \li \c path: fixed-size header holding the element counts,
+    /// \li \c path.nodes: node configurations, column-major doubles,
+    /// \li \c path.meta: per node, the graph state id, connected
+    ///     component id and symbolic component id, as 64-bit integers,
+    /// \li \c path.edges: per edge, the source and target node index.
+    ///
+    /// The header is rewritten after the arrays have been flushed, so a
+    /// crash in the middle of a checkpoint leaves the prefix described
+    /// by the previous header valid.
+    class HPP_MANIPULATION_DLLAPI RoadmapSnapshotWriter
+    {
+      public:
+        /// Open the snapshot files, truncating any previous content.
+        RoadmapSnapshotWriter (const std::string& path);
+
+        ~RoadmapSnapshotWriter ();
+
+        /// Append the nodes and edges of \c roadmap added since the last
+        /// call, then commit the new counts to the header.
+        void checkpoint (const RoadmapPtr_t& roadmap);
+
+        /// Number of nodes written so far.
+        std::size_t nbNodes () const
+        {
+          return nodeIndices_.size ();
+        }
+
+      private:
+        std::size_t componentId (const ConnectedComponentPtr_t& cc);
+        std::size_t componentId (const SymbolicComponentPtr_t& sc);
+        void writeHeader (const std::size_t nbEdges);
+
+        std::string path_;
+        std::ofstream nodes_, meta_, edges_;
+        /// Index of each node already written, in insertion order.
+        std::map <core::NodePtr_t, std::size_t> nodeIndices_;
+        std::map <ConnectedComponentPtr_t, std::size_t> ccIds_;
+        std::map <SymbolicComponentPtr_t, std::size_t> scIds_;
+        std::size_t nbEdges_;
+        size_type configSize_;
+    }; // class RoadmapSnapshotWriter
+
+    /// Memory-mapped view of a snapshot written by RoadmapSnapshotWriter.
+    ///
+    /// The node and edge arrays are mapped, not copied: opening a
+    /// snapshot costs a few system calls whatever the roadmap size, and
+    /// configurations() gives a view on the file pages. resume() then
+    /// rebuilds the roadmap from the view; the node and edge objects
+    /// themselves must be re-created since they form a pointer graph,
+    /// but no path is re-validated and no configuration is re-projected.
+    class HPP_MANIPULATION_DLLAPI RoadmapSnapshotReader
+    {
+      public:
+        typedef Eigen::Map <const matrix_t> ConstConfigurationBlock_t;
+
+        /// Map the snapshot files into memory.
+        /// \throw std::runtime_error if a file is missing or truncated
+        ///        with respect to the header counts.
+        RoadmapSnapshotReader (const std::string& path);
+
+        ~RoadmapSnapshotReader ();
+
+        std::size_t nbNodes () const
+        {
+          return nbNodes_;
+        }
+
+        std::size_t nbEdges () const
+        {
+          return nbEdges_;
+        }
+
+        size_type configSize () const
+        {
+          return configSize_;
+        }
+
+        /// View on the node configurations, one per column.
+        ConstConfigurationBlock_t configurations () const;
+
+        /// Graph state id of node \c index, as stored by the writer.
+        std::size_t stateId (const std::size_t index) const;
+
+        /// Insert the snapshot content into \c roadmap.
+        /// Edge paths are re-generated with \c sm; edges whose steering
+        /// fails are dropped with a warning. Connected and symbolic
+        /// components are recovered by the edge insertions themselves.
+        void resume (const RoadmapPtr_t& roadmap,
+            const core::SteeringMethodPtr_t& sm) const;
+
+      private:
+        const void* map (const std::string& file, const std::size_t size,
+            int& fd) const;
+
+        std::size_t nbNodes_, nbEdges_;
+        size_type configSize_;
+        int nodesFd_, metaFd_, edgesFd_;
+        const value_type* configs_;
+        const boost::int64_t* meta_;
+        const boost::int64_t* edges_;
+    }; // class RoadmapSnapshotReader
+    /// \}
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_ROADMAP_SNAPSHOT_HH
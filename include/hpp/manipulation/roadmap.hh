@@ -17,6 +17,9 @@
 #ifndef HPP_MANIPULATION_ROADMAP_HH
 # define HPP_MANIPULATION_ROADMAP_HH
 
+# include <boost/thread/mutex.hpp>
+# include <boost/unordered_map.hpp>
+
 # include <hpp/core/roadmap.hh>
 
 # include "hpp/manipulation/config.hh"
@@ -43,12 +46,40 @@ namespace hpp {
         /// it is also added to the histogram
         void insertHistogram (const graph::HistogramPtr_t hist);
 
+        /// Defer histogram updates.
+        ///
+        /// When set, push_node only queues the node and the histograms
+        /// are fed in batches by flushStatistics, keeping the constraint
+        /// evaluations of the leaf classification out of the insertion
+        /// critical path. Off by default: the histograms are then
+        /// updated synchronously as before.
+        void deferHistogramUpdates (bool defer)
+        {
+          deferHistogramUpdates_ = defer;
+        }
+
+        /// Feed the queued nodes to the registered histograms.
+        /// No-op when nothing is queued.
+        void flushStatistics ();
+
         /// Register the constraint graph to do statistics.
         void constraintGraph (const graph::GraphPtr_t& graph);
 
         /// Clear the histograms and call parent implementation.
         void clear ();
 
+        /// Keep the allocated capacity across clear() calls.
+        ///
+        /// When set, clear() empties the roadmap but leaves the node
+        /// pool blocks with the allocator instead of returning them to
+        /// the system, so a replanning query re-grows into warm memory
+        /// instead of freshly faulted pages. Off by default: one-shot
+        /// problems then release the memory as before.
+        void warmReset (bool warm)
+        {
+          warmReset_ = warm;
+        }
+
         /// Catch event 'New node added'
         void push_node (const core::NodePtr_t& n);
 
@@ -59,6 +90,15 @@ namespace hpp {
             const graph::StatePtr_t& state,
             value_type& minDistance) const;
 
+        /// Get the nearest neighbor of every graph::State of a
+        /// ConnectedComponent in a single traversal, instead of one
+        /// nearestNode query per state.
+        /// \retval nearest one (node, distance) pair per graph state of
+        ///         the component containing at least one node.
+        void nearestNodes (const ConfigurationPtr_t& configuration,
+            const ConnectedComponentPtr_t& connectedComponent,
+            NodesAndDistances_t& nearest) const;
+
 	/// Get graph state corresponding to given roadmap node
 	/// \deprecated use getState instead
 	graph::StatePtr_t getNode(RoadmapNodePtr_t node) HPP_MANIPULATION_DEPRECATED;
@@ -72,6 +112,140 @@ namespace hpp {
           return symbolicCCs_;
         }
 
+        /// Get the weighed symbolic components, ordered by decreasing
+        /// weight.
+        ///
+        /// The index is maintained incrementally when nodes are added,
+        /// components merge or \ref updateSymbolicComponent is called,
+        /// so iterating it never sorts.
+        const WeighedSymbolicComponents_t& weighedSymbolicComponents () const
+        {
+          return weighedSymbolicCCs_;
+        }
+
+        /// Reposition a symbolic component in the weight-ordered index.
+        /// To be called after its weight changed. O(log n).
+        void updateSymbolicComponent (const SymbolicComponentPtr_t& sc);
+
+        /// Monotonic counter incremented on every structural change of
+        /// the roadmap: node insertion, edge insertion - and thus the
+        /// connected component merges an edge may trigger - and clear.
+        /// Clients caching data derived from the roadmap detect
+        /// staleness with a single comparison.
+        std::size_t revision () const
+        {
+          return revision_;
+        }
+
+        /// Build a consistent copy of the roadmap for query serving.
+        ///
+        /// The copy owns its nodes, edges and connected components but
+        /// shares the immutable payloads - configurations and paths -
+        /// with this roadmap, so its cost is the structure only, not
+        /// the data. A query thread can run A* and path extraction on
+        /// the copy while the planner keeps growing this roadmap.
+        ///
+        /// Histograms are not copied: the snapshot serves queries, not
+        /// statistics.
+        ///
+        /// \warning the copy must be taken while no thread is inserting
+        ///          in this roadmap, typically between two calls to
+        ///          PathPlanner::oneStep.
+        RoadmapPtr_t snapshot () const;
+
+        /// Mutex serializing structural changes when several planners
+        /// grow this roadmap concurrently.
+        ///
+        /// The underlying containers - node and edge lists, connected
+        /// components - live in hpp::core::Roadmap and are not safe for
+        /// concurrent mutation, so writers must hold this mutex around
+        /// every insertion and around nearest neighbor queries against
+        /// the live structure. Single planner setups never take it.
+        boost::mutex& writeMutex () const
+        {
+          return writeMutex_;
+        }
+
+        /// Publish a consistent snapshot for query threads.
+        ///
+        /// Takes \ref writeMutex, builds a \ref snapshot of the current
+        /// structure and installs it - together with the current
+        /// \ref revision - as the published epoch. Readers that must not
+        /// block the writers, e.g. A* or path extraction running while
+        /// planners keep inserting, work on \ref publishedSnapshot
+        /// instead of the live roadmap.
+        void publish ();
+
+        /// The last snapshot installed by \ref publish, NULL when none
+        /// was published yet. The returned roadmap is immutable and can
+        /// be read without locking.
+        RoadmapPtr_t publishedSnapshot () const;
+
+        /// The \ref revision the published snapshot was taken at, 0
+        /// when none was published yet.
+        std::size_t publishedRevision () const;
+
+        /// \name Roadmap merging
+        /// \{
+
+        /// Nodes and edges inserted after a given point of the growth,
+        /// in insertion order. \sa delta
+        struct Delta {
+          RoadmapNodes_t nodes;
+          std::vector <core::EdgePtr_t> edges;
+          /// Total node and edge counts of the source roadmap once the
+          /// delta is applied, to be passed to the next \ref delta call.
+          std::size_t nodeCount, edgeCount;
+        };
+
+        /// Extract the nodes and edges inserted after the first
+        /// \c nodeCount nodes and \c edgeCount edges.
+        ///
+        /// Workers growing separate roadmaps for the same problem call
+        /// this periodically with the counts of the previous extraction
+        /// - 0 and 0 the first time - and ship the result to their
+        /// peers, so that each exchange carries the new structure only.
+        /// The counts restart from zero when the roadmap is cleared;
+        /// consumers detect this with \ref revision.
+        void delta (const std::size_t nodeCount,
+            const std::size_t edgeCount, Delta& delta) const;
+
+        /// Import the nodes and edges of a delta into this roadmap.
+        ///
+        /// Nodes whose configuration is already present - detected
+        /// through \ref nodeWithConfiguration - are skipped; the other
+        /// ones are inserted sharing the configuration of the source
+        /// node and copying its cached graph state and foliation
+        /// parameters, so the constraints the source roadmap solved are
+        /// not re-evaluated here. Edges are re-created between the
+        /// local counterparts of their endpoints, sharing the validated
+        /// path; edges whose endpoint is unknown here - an earlier
+        /// delta was skipped - are dropped with a warning.
+        ///
+        /// The connected and symbolic components rebuild themselves
+        /// through the usual insertion path, so only the connection
+        /// attempts between the two roadmaps remain to be run by the
+        /// planner, on the returned nodes.
+        ///
+        /// \retval imported the nodes actually inserted.
+        /// \warning like every structural change, to be called under
+        ///          \ref writeMutex when several planners run.
+        void merge (const Delta& delta, RoadmapNodes_t& imported);
+
+        /// Import a whole roadmap, equivalent to merging its full
+        /// \ref delta.
+        void merge (const RoadmapPtr_t& other, RoadmapNodes_t& imported);
+        /// \}
+
+        /// Node holding exactly the given configuration, NULL when the
+        /// roadmap contains none.
+        ///
+        /// The lookup goes through a hash index fed by push_node -
+        /// configurations are hashed once, when the node is inserted -
+        /// so duplicate detection costs one hash computation instead of
+        /// a scan of the nodes.
+        RoadmapNodePtr_t nodeWithConfiguration (ConfigurationIn_t q) const;
+
       protected:
         /// Register a new configuration.
         void statInsert (const RoadmapNodePtr_t& n);
@@ -90,13 +264,46 @@ namespace hpp {
         virtual void addEdge (const core::EdgePtr_t& edge);
 
       private:
+        /// Insert a component in the weight-ordered index if not there
+        /// yet, remove it from the index.
+        void indexSymbolicComponent (const SymbolicComponentPtr_t& sc);
+        void unindexSymbolicComponent (const SymbolicComponentPtr_t& sc);
+
         typedef graph::Histograms_t Histograms_t;
         /// Keep track of the leaf that are explored.
         /// There should be one histogram per foliation.
         Histograms_t histograms_;
+        /// See deferHistogramUpdates.
+        bool deferHistogramUpdates_;
+        /// See warmReset.
+        bool warmReset_;
+        /// Nodes not fed to the histograms yet. Nodes are inserted and
+        /// the queue is drained by the thread growing the roadmap, so no
+        /// lock is needed.
+        std::vector <RoadmapNodePtr_t> pendingStatNodes_;
+        /// See revision.
+        std::size_t revision_;
+        /// Hash index of the node configurations.
+        /// \sa nodeWithConfiguration
+        typedef boost::unordered_multimap <std::size_t, RoadmapNodePtr_t>
+          ConfigurationIndex_t;
+        ConfigurationIndex_t configIndex_;
+        /// See writeMutex.
+        mutable boost::mutex writeMutex_;
+        /// Published epoch, see publish. Guarded by publishMutex_ so
+        /// readers can take the shared pointer while a writer installs
+        /// the next snapshot.
+        RoadmapPtr_t published_;
+        std::size_t publishedRevision_;
+        mutable boost::mutex publishMutex_;
+        /// Kept so that snapshot can build a roadmap of the same robot.
+        core::DevicePtr_t robot_;
         graph::GraphPtr_t graph_;
         RoadmapWkPtr_t weak_;
         SymbolicComponents_t symbolicCCs_;
+        /// Weight-ordered view of symbolicCCs_, see
+        /// weighedSymbolicComponents.
+        WeighedSymbolicComponents_t weighedSymbolicCCs_;
     };
     /// \}
   } // namespace manipulation
@@ -42,8 +42,18 @@ namespace hpp {
         /// Merge two symbolic components
         /// \param other manipulation symbolic component to merge into this one.
         /// \note other will be empty after calling this method.
+        ///
+        /// The merge is a union-find union: other is pointed at this
+        /// component and its node list is concatenated lazily by
+        /// nodes(), so merging costs a pointer swing instead of a pass
+        /// over the nodes.
         virtual void merge (SymbolicComponentPtr_t otherCC);
 
+        /// Representative of this component in the union-find
+        /// structure, this component itself when it has not been merged
+        /// into another one. The parent chain is compressed on lookup.
+        SymbolicComponentPtr_t representative () const;
+
         bool canMerge (const SymbolicComponentPtr_t& otherCC) const;
 
         /// Add otherCC to the list of reachable components
@@ -63,14 +73,29 @@ namespace hpp {
           return nodes_.front()->connectedComponent();
         };
 
-        const RoadmapNodes_t& nodes() const
+        /// Number of nodes in this component, without concatenating the
+        /// node lists of merged components.
+        std::size_t size () const
+        {
+          return nbNodes_;
+        }
+
+        /// Get the nodes of this component. The node lists of merged
+        /// components are concatenated here, on first access, rather
+        /// than at merge time.
+        const RoadmapNodes_t& nodes() const;
+
+        /// Whether this is a WeighedSymbolicComponent, stored as a
+        /// flag so the selection loops check it with a load instead of
+        /// a dynamic_cast per element. \sa weighedComponent
+        bool weighed () const
         {
-          return nodes_;
+          return weighed_;
         }
 
       protected:
         SymbolicComponent(const RoadmapPtr_t& r)
-          : roadmap_(r) {}
+          : nbNodes_(0), weighed_(false), roadmap_(r) {}
 
         void init (const SymbolicComponentWkPtr_t& shPtr)
         {
@@ -78,11 +103,23 @@ namespace hpp {
         }
 
         graph::StatePtr_t state_;
-        RoadmapNodes_t nodes_;
+        /// Own nodes, completed lazily by nodes() with the lists of the
+        /// components in absorbed_.
+        mutable RoadmapNodes_t nodes_;
+        /// Number of nodes including the pending lists of absorbed_.
+        std::size_t nbNodes_;
+        /// Type tag, see weighed().
+        bool weighed_;
 
       private:
         RoadmapWkPtr_t roadmap_;
         SymbolicComponents_t to_, from_;
+        /// Components merged into this one whose node lists have not
+        /// been concatenated into nodes_ yet.
+        mutable std::vector<SymbolicComponentPtr_t> absorbed_;
+        /// Union-find parent, empty while this component is its own
+        /// representative. Compressed by representative().
+        mutable SymbolicComponentPtr_t parent_;
         SymbolicComponentWkPtr_t weak_;
     }; // class SymbolicComponent
 
@@ -109,12 +146,38 @@ namespace hpp {
         vector_t p_;
         std::vector<graph::EdgePtr_t> edges_;
 
+        /// \name Weight-ordered index bookkeeping
+        ///
+        /// Managed by hpp::manipulation::Roadmap, which keeps the
+        /// components in a multimap ordered by decreasing weight so that
+        /// the planner selects them without sorting. After changing
+        /// \ref weight_, call Roadmap::updateSymbolicComponent to
+        /// reposition the component.
+        /// \{
+        WeighedSymbolicComponents_t::iterator weightPosition_;
+        bool indexed_;
+        /// \}
+
       protected:
         WeighedSymbolicComponent(const RoadmapPtr_t& r)
-          : SymbolicComponent(r), weight_(1) {}
+          : SymbolicComponent(r), weight_(1), indexed_(false)
+        {
+          weighed_ = true;
+        }
 
       private:
     }; // class SymbolicComponent
+
+    /// Downcast a symbolic component, or an empty pointer when it is
+    /// not weighed. Checks the type tag, so it is safe in the loops
+    /// where a dynamic_cast per element would be measurable.
+    inline WeighedSymbolicComponentPtr_t weighedComponent
+    (const SymbolicComponentPtr_t& sc)
+    {
+      if (sc && sc->weighed ())
+        return boost::static_pointer_cast <WeighedSymbolicComponent> (sc);
+      return WeighedSymbolicComponentPtr_t ();
+    }
   } //   namespace manipulation
 } // namespace hpp
 #endif // HPP_MANIPULATION_SYMBOLIC_COMPONENT_HH
@@ -26,6 +26,7 @@
 #include "hpp/manipulation/fwd.hh"
 #include "hpp/manipulation/config.hh"
 #include "hpp/manipulation/graph/fwd.hh"
+#include "hpp/manipulation/telemetry.hh"
 
 namespace hpp {
   namespace manipulation {
@@ -75,6 +76,18 @@ namespace hpp {
         /// \sa ManipulationPlanner::getEdgeStat
         static StringList_t errorList ();
 
+        /// Telemetry accumulated by oneStep and extend, enabled in
+        /// release builds. \sa ManipulationPlanner::telemetry
+        Telemetry& telemetry ()
+        {
+          return telemetry_;
+        }
+
+        const Telemetry& telemetry () const
+        {
+          return telemetry_;
+        }
+
       protected:
         /// Protected constructor
         SymbolicPlanner (const Problem& problem,
@@ -146,7 +159,18 @@ namespace hpp {
 
         const value_type extendStep_;
 
+        /// Fraction of the way a targeted sample moves from its seed -
+        /// the configuration of a random member node of the selected
+        /// symbolic component - toward the uniform sample. 0 (the
+        /// default) keeps plain uniform sampling. Set with the
+        /// parameter SymbolicPlanner/TargetedSampling.
+        const value_type targetedSampling_;
+
         mutable Configuration_t qProj_;
+
+        /// Always-on counters, see telemetry(). This planner is
+        /// sequential so everything goes to shard 0.
+        Telemetry telemetry_;
     };
     /// \}
   } // namespace manipulation
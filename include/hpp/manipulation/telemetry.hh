@@ -0,0 +1,176 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HPP_MANIPULATION_TELEMETRY_HH
+# define HPP_MANIPULATION_TELEMETRY_HH
+
+# include <iosfwd>
+# include <ctime>
+# include <vector>
+
+# include <boost/array.hpp>
+
+# include <hpp/manipulation/config.hh>
+# include <hpp/manipulation/fwd.hh>
+
+namespace hpp {
+  namespace manipulation {
+    /// Always-on planner telemetry.
+    ///
+    /// The HPP time counters compile out of release builds, so the
+    /// planners carry no instrumentation exactly where performance is
+    /// measured: in deployment. This class keeps permanent per-phase
+    /// cycle counters and per-edge outcome counters, sharded per
+    /// worker. Each worker writes only its own shard, so recording an
+    /// event is a handful of additions without lock and the telemetry
+    /// can stay enabled. A small ring buffer of recent events per
+    /// shard supports post-mortem inspection.
+    ///
+    /// Readers merge the shards on the fly. The counters only grow, so
+    /// a read concurrent with recording is at worst a few events
+    /// stale, never corrupt beyond that.
+    class HPP_MANIPULATION_DLLAPI Telemetry
+    {
+      public:
+        /// Phases instrumented by the planners.
+        enum Phase {
+          ONE_STEP = 0,
+          EXTEND,
+          PROJECTION,
+          PATH_VALIDATION,
+          TRY_CONNECT,
+          NB_PHASES
+        };
+
+        typedef unsigned long long counter_t;
+
+        struct PhaseCounter {
+          counter_t events, cycles;
+          PhaseCounter () : events (0), cycles (0) {}
+        };
+
+        struct EdgeCounter {
+          counter_t successes, failures, cycles;
+          EdgeCounter () : successes (0), failures (0), cycles (0) {}
+        };
+
+        /// One recorded event, as kept in the ring buffers.
+        struct Event {
+          Phase phase;
+          /// Id of the graph edge, or -1 when the event is not tied to
+          /// an edge.
+          std::size_t edgeId;
+          bool success;
+          counter_t cycles;
+        };
+
+        /// Number of events each shard remembers.
+        static const std::size_t ringCapacity = 128;
+
+        /// Cheap monotonic counter: the processor time stamp counter
+        /// on x86, a monotonic clock in nanoseconds elsewhere.
+        static counter_t tick ()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+          unsigned int lo, hi;
+          __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+          return ((counter_t) hi << 32) | (counter_t) lo;
+#else
+          struct timespec ts;
+          clock_gettime (CLOCK_MONOTONIC, &ts);
+          return (counter_t) ts.tv_sec * 1000000000ull
+            + (counter_t) ts.tv_nsec;
+#endif
+        }
+
+        explicit Telemetry (const std::size_t nbWorkers = 1);
+
+        /// Grow the number of shards. Not lock-free: call while no
+        /// worker is recording.
+        void nbWorkers (const std::size_t nbWorkers);
+
+        /// Account cycles to a phase. Lock-free as long as each rank
+        /// is used by a single thread at a time.
+        void record (const std::size_t rank, const Phase phase,
+            const counter_t cycles);
+
+        /// Account one outcome and its cycles to a graph edge and to a
+        /// phase, and log the event in the shard ring buffer.
+        void recordEdge (const std::size_t rank, const Phase phase,
+            const std::size_t edgeId, const bool success,
+            const counter_t cycles);
+
+        /// \name Queries, merging the shards on read
+        /// \{
+        PhaseCounter phase (const Phase phase) const;
+        EdgeCounter edge (const std::size_t edgeId) const;
+        /// One more than the largest edge id seen so far.
+        std::size_t nbEdges () const;
+        /// The events remembered by the ring buffers, shard by shard,
+        /// oldest first within a shard.
+        void recentEvents (std::vector <Event>& events) const;
+        /// \}
+
+        /// Reset every counter and ring buffer.
+        void clear ();
+
+        static const char* phaseName (const Phase phase);
+
+        /// Dump the merged counters as one JSON object.
+        std::ostream& writeJSON (std::ostream& os) const;
+
+        /// Dump the merged counters as CSV: one "phase,..." line per
+        /// phase and one "edge,..." line per edge.
+        std::ostream& writeCSV (std::ostream& os) const;
+
+        /// Account the cycles spent in a scope to a phase.
+        class ScopedPhase
+        {
+          public:
+            ScopedPhase (Telemetry& telemetry, const std::size_t rank,
+                const Phase phase) :
+              telemetry_ (telemetry), rank_ (rank), phase_ (phase),
+              start_ (tick ())
+            {}
+
+            ~ScopedPhase ()
+            {
+              telemetry_.record (rank_, phase_, tick () - start_);
+            }
+
+          private:
+            Telemetry& telemetry_;
+            const std::size_t rank_;
+            const Phase phase_;
+            const counter_t start_;
+        }; // class ScopedPhase
+
+      private:
+        struct Shard {
+          boost::array <PhaseCounter, NB_PHASES> phases;
+          /// Indexed by edge id, grown on first event of an edge.
+          std::vector <EdgeCounter> edges;
+          boost::array <Event, ringCapacity> ring;
+          std::size_t ringHead, ringSize;
+          Shard () : ringHead (0), ringSize (0) {}
+        };
+        typedef std::vector <Shard> Shards_t;
+        Shards_t shards_;
+    }; // class Telemetry
+  } // namespace manipulation
+} // namespace hpp
+
+#endif // HPP_MANIPULATION_TELEMETRY_HH
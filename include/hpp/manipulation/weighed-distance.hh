@@ -53,6 +53,20 @@ namespace hpp {
         return graph_;
       }
 
+      /// Compute the distances from a block of configurations to one
+      /// configuration.
+      ///
+      /// The configurations are read column by column so the evaluation
+      /// streams through contiguous memory, and the per-pair computation
+      /// is bound at compile time instead of going through the virtual
+      /// operator() for every candidate.
+      /// \param qs configurations stored column-major,
+      /// \param nbCols number of configurations in qs,
+      /// \param q the query configuration,
+      /// \retval ds distances, must be of size at least nbCols.
+      void distances (matrixIn_t qs, const std::size_t nbCols,
+          ConfigurationIn_t q, vectorOut_t ds) const;
+
     protected:
       WeighedDistance (const DevicePtr_t& robot, const graph::GraphPtr_t graph);
 
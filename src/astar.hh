@@ -19,7 +19,9 @@
 #ifndef HPP_MANIPULATION_ASTAR_HH
 # define HPP_MANIPULATION_ASTAR_HH
 
+# include <algorithm>
 # include <limits>
+# include <vector>
 # include <hpp/core/distance.hh>
 # include <hpp/core/node.hh>
 # include <hpp/core/edge.hh>
@@ -34,33 +36,22 @@ namespace hpp {
     class Astar
     {
     public:
-      typedef std::map <RoadmapNodePtr_t, value_type> CostMap_t;
-      struct CostMapCompFunctor {
-	CostMap_t& cost_;
-	CostMapCompFunctor (CostMap_t& cost) : cost_ (cost) {}
-	bool operator () (const RoadmapNodePtr_t& n1, const RoadmapNodePtr_t& n2)
-	{ return cost_ [n1] < cost_ [n2]; }
-	bool operator () (const RoadmapNodePtr_t& n1, const value_type& val)
-	{ return cost_ [n1] < val; }
-      }; // struc CostMapCompFunctor
-
       typedef std::list <graph::StatePtr_t> States_t;
       typedef std::list <RoadmapNodePtr_t> RoadmapNodes_t;
       typedef std::list <core::EdgePtr_t> RoadmapEdges_t;
-      typedef std::map <RoadmapNodePtr_t, core::EdgePtr_t> Parent_t;
 
       Astar (const core::DistancePtr_t distance,
           const graph::StateSelectorPtr_t& stateSelector, RoadmapNodePtr_t from) :
 	distance_ (distance), selector_ (stateSelector),
         from_ (from)
       {
-        open_.push_back (from);
-        costFromStart_ [from] = 0;
+        records_[index (from)].costFromStart = 0;
       }
 
       States_t solution (RoadmapNodePtr_t to)
       {
-	if (parent_.find (to) != parent_.end () ||
+	Indices_t::const_iterator itTo = indices_.find (to);
+	if ((itTo != indices_.end () && records_[itTo->second].parent) ||
             findPath (to))
         {
           RoadmapNodePtr_t node = to;
@@ -68,9 +59,10 @@ namespace hpp {
 
           states.push_front (selector_->getState (to));
           while (node) {
-            Parent_t::const_iterator itNode = parent_.find (node);
-            if (itNode != parent_.end ()) {
-              node = static_cast <RoadmapNodePtr_t> (itNode->second->from ());
+            Indices_t::const_iterator itNode = indices_.find (node);
+            if (itNode != indices_.end () && records_[itNode->second].parent) {
+              node = static_cast <RoadmapNodePtr_t>
+                (records_[itNode->second].parent->from ());
               states.push_front (selector_->getState (node));
             }
             else node = RoadmapNodePtr_t (0);
@@ -85,47 +77,89 @@ namespace hpp {
       }
 
     private:
+      /// Per-node search data, stored contiguously and addressed through
+      /// a dense index assigned when the node is first reached.
+      struct Record {
+	RoadmapNodePtr_t node;
+	core::EdgePtr_t parent;
+	value_type costFromStart;
+	value_type estimatedCost;
+	bool closed;
+
+	Record (const RoadmapNodePtr_t& n) : node (n), parent (),
+	  costFromStart (std::numeric_limits <value_type>::max ()),
+	  estimatedCost (std::numeric_limits <value_type>::max ()),
+	  closed (false) {}
+      }; // struct Record
+      typedef std::map <RoadmapNodePtr_t, std::size_t> Indices_t;
+      typedef std::vector <Record> Records_t;
+      /// (estimated cost, record index), min-heap on the estimated cost.
+      typedef std::pair <value_type, std::size_t> HeapEntry_t;
+      struct HeapComp {
+	bool operator () (const HeapEntry_t& e1, const HeapEntry_t& e2) const
+	{ return e1.first > e2.first; }
+      }; // struct HeapComp
+      typedef std::vector <HeapEntry_t> Heap_t;
+
+      std::size_t index (const RoadmapNodePtr_t& node)
+      {
+	std::pair <Indices_t::iterator, bool> ins = indices_.insert
+	  (std::make_pair (node, records_.size ()));
+	if (ins.second) records_.push_back (Record (node));
+	return ins.first->second;
+      }
+
+      void push (const value_type& estimatedCost, const std::size_t& i)
+      {
+	heap_.push_back (HeapEntry_t (estimatedCost, i));
+	std::push_heap (heap_.begin (), heap_.end (), HeapComp ());
+      }
+
       bool findPath (RoadmapNodePtr_t to)
       {
-        // Recompute the estimated cost to goal
-        for (CostMap_t::iterator it = estimatedCostToGoal_.begin ();
-            it != estimatedCostToGoal_.end (); ++it) {
-          it->second = getCostFromStart (it->first) + heuristic (it->first, to);
+        // The heuristic depends on the goal so the open heap must be
+        // rebuilt from the records that are not closed yet.
+        heap_.clear ();
+        for (std::size_t i = 0; i < records_.size (); ++i) {
+          Record& r = records_[i];
+          if (r.closed ||
+              r.costFromStart == std::numeric_limits <value_type>::max ())
+            continue;
+          r.estimatedCost = r.costFromStart + heuristic (r.node, to);
+          push (r.estimatedCost, i);
         }
-        open_.sort (CostMapCompFunctor (estimatedCostToGoal_));
 
-	while (!open_.empty ()) {
-	  RoadmapNodes_t::iterator itv = open_.begin ();
-          RoadmapNodePtr_t current (*itv);
-	  if (current == to) {
+	while (!heap_.empty ()) {
+	  const HeapEntry_t entry = heap_.front ();
+	  std::pop_heap (heap_.begin (), heap_.end (), HeapComp ());
+	  heap_.pop_back ();
+	  Record& current = records_[entry.second];
+	  // Skip entries made stale by a cheaper path or a previous
+	  // expansion: records are never removed from the heap, they are
+	  // re-pushed with their improved cost.
+	  if (current.closed || entry.first != current.estimatedCost)
+	    continue;
+	  if (current.node == to) {
 	    return true;
 	  }
-	  open_.erase (itv);
-	  closed_.push_back (current);
-	  for (RoadmapEdges_t::const_iterator itEdge = current->outEdges ().begin ();
-	       itEdge != current->outEdges ().end (); ++itEdge) {
-            RoadmapNodePtr_t child = static_cast <RoadmapNodePtr_t> ((*itEdge)->to ());
-	    if (std::find (closed_.begin(), closed_.end(),
-                  child) == closed_.end ()) {
-	      // node is not in closed set
-              value_type transitionCost = edgeCost (*itEdge);
-              value_type tmpCost = getCostFromStart (current) + transitionCost;
-	      bool childNotInOpenSet = (std::find (open_.begin (),
-						   open_.end (),
-						   child) == open_.end ());
-	      if ((childNotInOpenSet) || (tmpCost < getCostFromStart (child))) {
-		parent_ [child] = *itEdge;
-		costFromStart_ [child] = tmpCost;
-                value_type estimatedCost = tmpCost + heuristic (child, to);
-                estimatedCostToGoal_ [child] = estimatedCost;
-                if (childNotInOpenSet) {
-                  // Find the first element not strictly smaller than child
-                  RoadmapNodes_t::iterator pos =
-                    std::lower_bound (open_.begin (), open_.end (),
-                        estimatedCost, CostMapCompFunctor (estimatedCostToGoal_));
-                  open_.insert (pos, child);
-                }
-	      }
+	  current.closed = true;
+	  const value_type costOfCurrent = current.costFromStart;
+	  const RoadmapEdges_t& outEdges = current.node->outEdges ();
+	  for (RoadmapEdges_t::const_iterator itEdge = outEdges.begin ();
+	       itEdge != outEdges.end (); ++itEdge) {
+            RoadmapNodePtr_t childNode = static_cast <RoadmapNodePtr_t> ((*itEdge)->to ());
+	    // Note: current may be invalidated by this call.
+	    const std::size_t childIndex = index (childNode);
+	    Record& child = records_[childIndex];
+	    if (child.closed) continue;
+	    // node is not in closed set
+	    value_type transitionCost = edgeCost (*itEdge);
+	    value_type tmpCost = costOfCurrent + transitionCost;
+	    if (tmpCost < child.costFromStart) {
+	      child.parent = *itEdge;
+	      child.costFromStart = tmpCost;
+	      child.estimatedCost = tmpCost + heuristic (childNode, to);
+	      push (child.estimatedCost, childIndex);
 	    }
 	  }
 	}
@@ -143,19 +177,9 @@ namespace hpp {
 	return edge->path ()->length ();
       }
 
-      value_type getCostFromStart (RoadmapNodePtr_t to) const
-      {
-        CostMap_t::const_iterator it = costFromStart_.find (to);
-        if (it == costFromStart_.end())
-          return std::numeric_limits <value_type>::max();
-        return it->second;
-      }
-
-      RoadmapNodes_t closed_;
-      RoadmapNodes_t open_;
-      std::map <RoadmapNodePtr_t, value_type> costFromStart_;
-      std::map <RoadmapNodePtr_t, value_type> estimatedCostToGoal_;
-      Parent_t parent_;
+      Indices_t indices_;
+      Records_t records_;
+      Heap_t heap_;
       core::DistancePtr_t distance_;
       graph::StateSelectorPtr_t selector_;
       RoadmapNodePtr_t from_;
@@ -51,7 +51,7 @@ namespace hpp {
       if (n.empty())
         n = "Transformation_(1,1,1,1,1,0)_" + name() + "_" + gripper->name();
       return NumericalConstraintPtr_t
-	(NumericalConstraint::create (RelativeTransformation::create
+	(NumericalConstraint::create (maskedRelativeTransformation
 				      (n,
 				       gripper->joint()->robot(),
 				       gripper->joint (), joint (),
@@ -67,7 +67,10 @@ namespace hpp {
         (true);
       if (n.empty())
         n = "Transformation_(0,0,0,0,0,1)_" + name() + "_" + gripper->name();
-      return NumericalConstraint::create (RelativeTransformation::create
+      // The mask only constrains the revolute degree of freedom: the
+      // helper returns the orientation-only kernel, which never
+      // evaluates the position part of the error.
+      return NumericalConstraint::create (maskedRelativeTransformation
           (n, gripper->joint()->robot(),
            gripper->joint (), joint (),
            gripper->objectPositionInJoint (),
@@ -85,7 +88,7 @@ namespace hpp {
       if (n.empty())
         n = "Transformation_(1,1,1,1,1,0)_" + name () + "_" + gripper->name ();
       return NumericalConstraintPtr_t
-	(NumericalConstraint::create (RelativeTransformation::create
+	(NumericalConstraint::create (maskedRelativeTransformation
 				      (n,
 				       gripper->joint()->robot(),
 				       gripper->joint (), joint (),
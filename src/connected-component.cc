@@ -18,6 +18,9 @@
 
 #include <hpp/manipulation/connected-component.hh>
 
+#include <limits>
+
+#include "hpp/manipulation/nearest-neighbor-index.hh"
 #include "hpp/manipulation/roadmap.hh"
 #include "hpp/manipulation/roadmap-node.hh"
 
@@ -60,30 +63,59 @@ namespace hpp {
     {
       core::ConnectedComponent::merge(otherCC);
       const ConnectedComponentPtr_t other = boost::static_pointer_cast <ConnectedComponent> (otherCC);
+      /// Union-by-size: keep the maps of the bigger side in this and
+      /// fold the smaller side into them, whatever side merge was called
+      /// on. Both maps are keyed per state and filled together by
+      /// addNode, so one size comparison is enough for the two of them.
+      if (other->graphStateMap_.size() > graphStateMap_.size()) {
+	graphStateMap_.swap(other->graphStateMap_);
+	graphStateIndices_.swap(other->graphStateIndices_);
+      }
       /// take all graph states in other->graphStateMap_ and put them in this->graphStateMap_
       /// if they already exist in this->graphStateMap_, append roadmap nodes from other graph state
-      /// to graph state in this. 
-      for (GraphStates_t::iterator otherIt = other->graphStateMap_.begin(); 
+      /// to graph state in this.
+      for (GraphStates_t::iterator otherIt = other->graphStateMap_.begin();
 	otherIt != other->graphStateMap_.end(); otherIt++)
       {
 	// find other graph state in this-graphStateMap_ -> merge their roadmap nodes
 	GraphStates_t::iterator mapIt = this->graphStateMap_.find(otherIt->first);
 	if (mapIt != this->graphStateMap_.end())	{
+	  // Append the shorter node vector to the longer one.
+	  if (otherIt->second.size() > mapIt->second.size())
+	    mapIt->second.swap(otherIt->second);
 	  mapIt->second.insert(mapIt->second.end(), otherIt->second.begin(), otherIt->second.end());
 	} else {
 	  this->graphStateMap_.insert(*otherIt);
 	}
       }
       other->graphStateMap_.clear();
+      // Merge the per-state nearest-neighbor indexes the same way; the
+      // index itself re-inserts the smaller tree into the larger one.
+      for (GraphStateIndices_t::iterator otherIt =
+	  other->graphStateIndices_.begin();
+	  otherIt != other->graphStateIndices_.end(); otherIt++)
+      {
+	GraphStateIndices_t::iterator mapIt =
+	  this->graphStateIndices_.find(otherIt->first);
+	if (mapIt != this->graphStateIndices_.end()) {
+	  mapIt->second->merge(otherIt->second);
+	} else {
+	  this->graphStateIndices_.insert(*otherIt);
+	}
+      }
+      other->graphStateIndices_.clear();
+#ifdef HPP_MANIPULATION_CHECK_CONNECTED_COMPONENTS
       assert (check ());
-    } 
+#endif
+    }
 
     void ConnectedComponent::addNode(const core::NodePtr_t& node)      
     {
       core::ConnectedComponent::addNode(node);
       // Find right graph state in map and add roadmap node to corresponding vector
       const RoadmapNodePtr_t& n = static_cast <const RoadmapNodePtr_t> (node);
-      GraphStates_t::iterator mapIt = graphStateMap_.find(roadmap_->getState(n));
+      const graph::StatePtr_t state = roadmap_->getState(n);
+      GraphStates_t::iterator mapIt = graphStateMap_.find(state);
       if (mapIt != graphStateMap_.end()) {
         mapIt->second.push_back(n);
       // if graph state not found, add new map element with one roadmap node
@@ -91,9 +123,21 @@ namespace hpp {
 	RoadmapNodes_t newRoadmapNodeVector;
 	newRoadmapNodeVector.push_back(n);
 	graphStateMap_.insert(std::pair<graph::StatePtr_t, RoadmapNodes_t>
-	  (roadmap_->getState(n), newRoadmapNodeVector));
+	  (state, newRoadmapNodeVector));
+      }
+      // Keep the per-state nearest-neighbor index in sync.
+      GraphStateIndices_t::iterator indexIt = graphStateIndices_.find(state);
+      if (indexIt == graphStateIndices_.end()) {
+	NearestNeighborIndexPtr_t index (new NearestNeighborIndex
+	    (roadmap_->distance()));
+	indexIt = graphStateIndices_.insert
+	  (std::pair<graph::StatePtr_t, NearestNeighborIndexPtr_t>
+	   (state, index)).first;
       }
+      indexIt->second->insert(n);
+#ifdef HPP_MANIPULATION_CHECK_CONNECTED_COMPONENTS
       assert (check ());
+#endif
     }
 
     const RoadmapNodes_t& ConnectedComponent::getRoadmapNodes (
@@ -105,6 +149,31 @@ namespace hpp {
       return empty_;
     }
 
+    RoadmapNodePtr_t ConnectedComponent::nearestRoadmapNode (
+        const graph::StatePtr_t graphState, const Configuration_t& q,
+        value_type& minDistance) const
+    {
+      GraphStateIndices_t::const_iterator indexIt =
+        graphStateIndices_.find(graphState);
+      if (indexIt != graphStateIndices_.end())
+        return indexIt->second->nearest(q, minDistance);
+      minDistance = std::numeric_limits <value_type>::infinity ();
+      return NULL;
+    }
+
+    void ConnectedComponent::nearestRoadmapNodes (const Configuration_t& q,
+        NodesAndDistances_t& nearest) const
+    {
+      nearest.clear ();
+      nearest.reserve (graphStateIndices_.size ());
+      value_type distance;
+      for (GraphStateIndices_t::const_iterator it =
+          graphStateIndices_.begin (); it != graphStateIndices_.end (); ++it) {
+        const RoadmapNodePtr_t n = it->second->nearest (q, distance);
+        if (n) nearest.push_back (NodeAndDistance_t (n, distance));
+      }
+    }
+
   } // namespace manipulation
 } // namespace hpp
 
@@ -0,0 +1,173 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/manipulation/decision-log.hh>
+
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/cstdint.hpp>
+
+#include <hpp/util/debug.hh>
+#include <hpp/util/pointer.hh>
+
+#include <hpp/manipulation/graph/graph.hh>
+#include <hpp/manipulation/graph/edge.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace {
+      const char magic_[8] = { 'h', 'p', 'p', 'd', 'r', 'e', 'c', '\0' };
+      const boost::int64_t version_ = 1;
+
+      /// Record tags. An edge record stores the edge id, -1 when the
+      /// recorded choice returned no edge.
+      enum { CONFIGURATION_RECORD = 0, EDGE_RECORD = 1 };
+
+      void write64 (std::ostream& os, const boost::int64_t v)
+      {
+        os.write (reinterpret_cast <const char*> (&v), sizeof (v));
+      }
+
+      boost::int64_t read64 (std::istream& is)
+      {
+        boost::int64_t v = 0;
+        is.read (reinterpret_cast <char*> (&v), sizeof (v));
+        return v;
+      }
+    }
+
+    DecisionLogWriter::DecisionLogWriter (const std::string& path,
+        const size_type& configSize) :
+      stream_ (path.c_str (), std::ios::binary | std::ios::trunc),
+      configSize_ (configSize), nbRecords_ (0)
+    {
+      if (!stream_)
+        throw std::runtime_error ("Cannot open decision log " + path);
+      stream_.write (magic_, sizeof (magic_));
+      write64 (stream_, version_);
+      write64 (stream_, (boost::int64_t) configSize_);
+      write64 (stream_, 0); // record count, rewritten by commit.
+    }
+
+    void DecisionLogWriter::recordConfiguration (const Configuration_t& q)
+    {
+      assert (q.size () == configSize_);
+      boost::mutex::scoped_lock lock (mutex_);
+      write64 (stream_, CONFIGURATION_RECORD);
+      stream_.write (reinterpret_cast <const char*> (q.data ()),
+          configSize_ * (size_type) sizeof (value_type));
+      ++nbRecords_;
+    }
+
+    void DecisionLogWriter::recordEdge (const graph::EdgePtr_t& edge)
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      write64 (stream_, EDGE_RECORD);
+      write64 (stream_, edge ? (boost::int64_t) edge->id () : -1);
+      ++nbRecords_;
+    }
+
+    void DecisionLogWriter::commit ()
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      stream_.flush ();
+      const std::ofstream::pos_type end = stream_.tellp ();
+      stream_.seekp (sizeof (magic_) + 2 * sizeof (boost::int64_t));
+      write64 (stream_, (boost::int64_t) nbRecords_);
+      stream_.seekp (end);
+      stream_.flush ();
+    }
+
+    DecisionLogReader::DecisionLogReader (const std::string& path) :
+      next_ (0), divergenceReported_ (false)
+    {
+      std::ifstream is (path.c_str (), std::ios::binary);
+      if (!is)
+        throw std::runtime_error ("Cannot open decision log " + path);
+      char magic [sizeof (magic_)];
+      is.read (magic, sizeof (magic));
+      if (!is || std::memcmp (magic, magic_, sizeof (magic_)) != 0)
+        throw std::runtime_error (path + " is not a decision log");
+      const boost::int64_t version = read64 (is);
+      if (version != version_)
+        throw std::runtime_error ("Unsupported decision log version");
+      configSize_ = (size_type) read64 (is);
+      const boost::int64_t nbRecords = read64 (is);
+      records_.reserve ((std::size_t) nbRecords);
+      for (boost::int64_t i = 0; i < nbRecords && is; ++i) {
+        Record_t record;
+        record.kind = (int) read64 (is);
+        record.edgeId = 0;
+        if (record.kind == CONFIGURATION_RECORD) {
+          record.configuration.resize (configSize_);
+          is.read (reinterpret_cast <char*> (record.configuration.data ()),
+              configSize_ * (size_type) sizeof (value_type));
+        } else {
+          record.edgeId = (std::size_t) read64 (is);
+        }
+        if (is) records_.push_back (record);
+      }
+    }
+
+    bool DecisionLogReader::nextConfiguration (Configuration_t& q)
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      if (next_ >= records_.size ()) return false;
+      if (records_[next_].kind != CONFIGURATION_RECORD) {
+        if (!divergenceReported_) {
+          divergenceReported_ = true;
+          hppDout (warning, "Decision log diverged at record " << next_
+              << ": expected a configuration. Falling back to random"
+              " decisions.");
+        }
+        return false;
+      }
+      q = records_[next_].configuration;
+      ++next_;
+      return true;
+    }
+
+    bool DecisionLogReader::nextEdge (graph::EdgePtr_t& edge,
+        const graph::GraphPtr_t& graph)
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      if (next_ >= records_.size ()) return false;
+      if (records_[next_].kind != EDGE_RECORD) {
+        if (!divergenceReported_) {
+          divergenceReported_ = true;
+          hppDout (warning, "Decision log diverged at record " << next_
+              << ": expected an edge. Falling back to random decisions.");
+        }
+        return false;
+      }
+      const std::size_t id = records_[next_].edgeId;
+      if (id == (std::size_t) -1) {
+        edge = graph::EdgePtr_t ();
+        ++next_;
+        return true;
+      }
+      edge = HPP_DYNAMIC_PTR_CAST (graph::Edge, graph->get (id).lock ());
+      if (!edge) {
+        hppDout (error, "Decision log edge id " << id
+            << " does not name an edge of this graph.");
+        return false;
+      }
+      ++next_;
+      return true;
+    }
+  } // namespace manipulation
+} // namespace hpp
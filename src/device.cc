@@ -102,6 +102,57 @@ namespace hpp {
       createGeomData();
     }
 
+    std::size_t Device::handleId (const std::string& name) const
+    {
+      return intern (handleRegistry_, name);
+    }
+
+    const HandlePtr_t& Device::handle (const std::size_t id) const
+    {
+      assert (id < handleRegistry_.elements.size ());
+      return handleRegistry_.elements[id];
+    }
+
+    std::size_t Device::gripperId (const std::string& name) const
+    {
+      return intern (gripperRegistry_, name);
+    }
+
+    const GripperPtr_t& Device::gripper (const std::size_t id) const
+    {
+      assert (id < gripperRegistry_.elements.size ());
+      return gripperRegistry_.elements[id];
+    }
+
+    std::size_t Device::frameIndicesId (const std::string& name) const
+    {
+      return intern (frameIndicesRegistry_, name);
+    }
+
+    const FrameIndices_t& Device::frameIndices (const std::size_t id) const
+    {
+      assert (id < frameIndicesRegistry_.elements.size ());
+      return frameIndicesRegistry_.elements[id];
+    }
+
+    void Device::add (const std::string& name, const HandlePtr_t& element)
+    {
+      Containers_t::add (name, element);
+      refreshInterned (handleRegistry_, name, element);
+    }
+
+    void Device::add (const std::string& name, const GripperPtr_t& element)
+    {
+      Containers_t::add (name, element);
+      refreshInterned (gripperRegistry_, name, element);
+    }
+
+    void Device::add (const std::string& name, const FrameIndices_t& element)
+    {
+      Containers_t::add (name, element);
+      refreshInterned (frameIndicesRegistry_, name, element);
+    }
+
     std::ostream& Device::print (std::ostream& os) const
     {
       Parent_t::print (os);
@@ -0,0 +1,57 @@
+// Copyright (c) 2016, Joseph Mirabel
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/manipulation/flattened-path.hh>
+
+#include <hpp/util/pointer.hh>
+
+#include <hpp/core/path.hh>
+#include <hpp/core/path-vector.hh>
+
+namespace hpp {
+  namespace manipulation {
+    FlattenedPath::FlattenedPath (const PathVectorPtr_t& path) :
+      leaves_ (),
+      outputSize_ (path->outputSize ()),
+      outputDerivativeSize_ (path->outputDerivativeSize ())
+    {
+      index (path);
+    }
+
+    void FlattenedPath::index (const PathVectorPtr_t& path)
+    {
+      for (std::size_t i = 0; i < path->numberPaths (); ++i) {
+        // PathVector::pathAtRank copies the subpath; this is the one
+        // copy per leaf the interface imposes, paid once at indexing
+        // time. Nested path vector nodes are shallow copies sharing
+        // their leaves, discarded after the recursion.
+        PathPtr_t sub = path->pathAtRank (i);
+        PathVectorPtr_t pv = HPP_DYNAMIC_PTR_CAST (core::PathVector, sub);
+        if (pv) index (pv);
+        else leaves_.push_back (sub);
+      }
+    }
+
+    PathVectorPtr_t FlattenedPath::assemble () const
+    {
+      PathVectorPtr_t pv = core::PathVector::create
+        (outputSize_, outputDerivativeSize_);
+      for (std::size_t i = 0; i < leaves_.size (); ++i)
+        pv->appendPath (leaves_[i]);
+      return pv;
+    }
+  } // namespace manipulation
+} // namespace hpp
@@ -16,42 +16,49 @@
 
 #include <hpp/manipulation/graph-optimizer.hh>
 
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <hpp/core/path.hh>
 #include <hpp/core/path-vector.hh>
 #include <hpp/core/problem.hh>
 #include <hpp/core/config-projector.hh>
 
 #include <hpp/manipulation/constraint-set.hh>
+#include <hpp/manipulation/flattened-path.hh>
 #include <hpp/manipulation/graph/edge.hh>
-#include <hpp/manipulation/graph-path-validation.hh>
 
 namespace hpp {
   namespace manipulation {
     PathVectorPtr_t GraphOptimizer::optimize (const PathVectorPtr_t& path)
     {
       PathVectorPtr_t opted = PathVector::create
-        (path->outputSize(), path->outputDerivativeSize()),
-        expanded = PathVector::create
-          (path->outputSize(), path->outputDerivativeSize()),
-        toConcat;
-      GraphPathValidationPtr_t gpv = HPP_DYNAMIC_PTR_CAST (GraphPathValidation,
-              this->problem().pathValidation ());
+        (path->outputSize(), path->outputDerivativeSize());
 
-      path->flatten (expanded);
+      // Non-owning flattened view: the leaves are indexed once instead
+      // of being copied into an intermediate path vector and copied
+      // again on every access.
+      FlattenedPath expanded (path);
+      // Split the path into groups of consecutive subpaths lying in the
+      // same graph state. The groups are independent of each other.
+      std::vector <PathVectorPtr_t> groups;
+      std::vector <graph::EdgePtr_t> edges;
       ConstraintSetPtr_t c;
-      for (std::size_t i_s = 0; i_s < expanded->numberPaths ();) {
+      for (std::size_t i_s = 0; i_s < expanded.numberPaths ();) {
         PathVectorPtr_t toOpt = PathVector::create (
-            path->outputSize(), path->outputDerivativeSize()); 
-        PathPtr_t current = expanded->pathAtRank (i_s);
+            path->outputSize(), path->outputDerivativeSize());
+        PathPtr_t current = expanded.pathAtRank (i_s);
         toOpt->appendPath (current);
         graph::EdgePtr_t edge;
-        c = HPP_DYNAMIC_PTR_CAST (ConstraintSet, current->constraints ());
+        c = ConstraintSet::cast (current->constraints ());
         if (c) edge = c->edge ();
         bool isShort = edge && edge->isShort();
         std::size_t i_e = i_s + 1;
-        for (; i_e < expanded->numberPaths (); ++i_e) {
-          current = expanded->pathAtRank (i_e);
-          c = HPP_DYNAMIC_PTR_CAST (ConstraintSet, current->constraints ());
+        for (; i_e < expanded.numberPaths (); ++i_e) {
+          current = expanded.pathAtRank (i_e);
+          c = ConstraintSet::cast (current->constraints ());
           if (!c && edge) {
             hppDout(info, "No manipulation::ConstraintSet");
             break;
@@ -62,28 +69,87 @@ namespace hpp {
           toOpt->appendPath (current);
         }
         hppDout(info, "Edge name: " << edge->name());
-        if (isShort)
-          toConcat = toOpt;
-        else {
-          core::Problem p (problem().robot());
-          p.distance(problem().distance());
-          // It should be ok to use the path validation of each edge because it
-          // corresponds to the global path validation minus the collision pairs
-          // disabled using the edge constraint.
-          // p.pathValidation(gpv->innerValidation());
-          p.pathProjector(problem().pathProjector());
-          p.steeringMethod(edge->steeringMethod()->copy());
-          p.constraints(p.steeringMethod()->constraints());
-          p.constraints()->configProjector()->rightHandSideFromConfig(toOpt->initial());
-          p.pathValidation(edge->pathValidation());
-          pathOptimizer_ = factory_ (p);
-          toConcat = pathOptimizer_->optimize (toOpt);
-        }
         i_s = i_e;
-        opted->concatenate (toConcat);
+        groups.push_back (toOpt);
+        // A null edge marks a group that is concatenated untouched.
+        edges.push_back (isShort ? graph::EdgePtr_t () : edge);
       }
+
+      std::vector <PathVectorPtr_t> results (groups.size ());
+      const std::size_t nbThreads = std::min ((std::size_t) nbThreads_,
+          groups.size ());
+      if (nbThreads <= 1) {
+        for (std::size_t i = 0; i < groups.size (); ++i) {
+          if (!edges[i]) { results[i] = groups[i]; continue; }
+          results[i] = optimizeGroup (groups[i], edges[i]);
+          pathOptimizer_ = prepared (edges[i]).optimizer;
+        }
+      } else {
+        // Groups sharing an edge use the same prepared problem, whose
+        // config projector is stateful: they are pinned to the same
+        // worker. The problems are prepared beforehand so the workers do
+        // not mutate the cache concurrently.
+        std::vector <std::vector <std::size_t> > indices (nbThreads);
+        for (std::size_t i = 0; i < groups.size (); ++i) {
+          if (!edges[i]) { results[i] = groups[i]; continue; }
+          prepared (edges[i]);
+          indices[edges[i]->id () % nbThreads].push_back (i);
+        }
+        boost::thread_group workers;
+        for (std::size_t rank = 0; rank < nbThreads; ++rank)
+          workers.create_thread (boost::bind
+              (&GraphOptimizer::optimizeGroupsWorker, this,
+               boost::cref (indices[rank]), boost::cref (groups),
+               boost::cref (edges), boost::ref (results)));
+        workers.join_all ();
+      }
+
+      for (std::size_t i = 0; i < results.size (); ++i)
+        opted->concatenate (results[i]);
       pathOptimizer_.reset ();
       return opted;
     }
+
+    GraphOptimizer::PreparedProblem& GraphOptimizer::prepared
+    (const graph::EdgePtr_t& edge)
+    {
+      PreparedProblem& pp = preparedProblems_[edge->id ()];
+      if (!pp.problem || pp.fingerprint != edge->steeringMethod ()) {
+        pp.fingerprint = edge->steeringMethod ();
+        pp.problem = boost::shared_ptr <core::Problem>
+          (new core::Problem (problem().robot()));
+        core::Problem& p = *pp.problem;
+        p.distance(problem().distance());
+        // It should be ok to use the path validation of each edge because it
+        // corresponds to the global path validation minus the collision pairs
+        // disabled using the edge constraint.
+        p.pathProjector(problem().pathProjector());
+        p.steeringMethod(edge->steeringMethod()->copy());
+        p.constraints(p.steeringMethod()->constraints());
+        p.pathValidation(edge->pathValidation());
+        pp.optimizer = factory_ (p);
+      }
+      return pp;
+    }
+
+    PathVectorPtr_t GraphOptimizer::optimizeGroup (const PathVectorPtr_t& toOpt,
+        const graph::EdgePtr_t& edge)
+    {
+      PreparedProblem& pp = prepared (edge);
+      pp.problem->constraints()->configProjector()->rightHandSideFromConfig
+        (toOpt->initial());
+      return pp.optimizer->optimize (toOpt);
+    }
+
+    void GraphOptimizer::optimizeGroupsWorker
+    (const std::vector <std::size_t>& indices,
+     const std::vector <PathVectorPtr_t>& groups,
+     const std::vector <graph::EdgePtr_t>& edges,
+     std::vector <PathVectorPtr_t>& results)
+    {
+      for (std::vector <std::size_t>::const_iterator it = indices.begin ();
+          it != indices.end (); ++it)
+        results[*it] = optimizeGroup (groups[*it], edges[*it]);
+    }
   } // namespace manipulation
 } // namespace hpp
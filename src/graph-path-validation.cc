@@ -16,6 +16,12 @@
 
 #include "hpp/manipulation/graph-path-validation.hh"
 
+#include <algorithm>
+#include <map>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <hpp/core/path.hh>
 #include <hpp/core/path-vector.hh>
 
@@ -36,7 +42,7 @@ namespace hpp {
     }
 
     GraphPathValidation::GraphPathValidation (const PathValidationPtr_t& pathValidation) :
-      pathValidation_ (pathValidation), constraintGraph_ ()
+      pathValidation_ (pathValidation), constraintGraph_ (), nbThreads_ (1)
     {}
 
     bool GraphPathValidation::validate (const PathPtr_t& path, bool reverse,
@@ -63,8 +69,10 @@ namespace hpp {
           if (!impl_validate (path->pathAtRank (i), true, validSubPart, report)) {
             PathVectorPtr_t p = PathVector::create
 	      (path->outputSize(), path->outputDerivativeSize());
+            // pathAtRank already returns a copy of the subpath, so the
+            // explicit copy would only duplicate it a second time.
             for (long int v = path->numberPaths () - 1; v > i; v--)
-              p->appendPath (path->pathAtRank(i)->copy());
+              p->appendPath (path->pathAtRank(i));
             // TODO: Make sure this subpart is generated by the steering method.
             p->appendPath (validSubPart);
             validPart = p;
@@ -72,13 +80,27 @@ namespace hpp {
           }
         }
       } else {
-        for (size_t i = 0; i != path->numberPaths (); i++) {
+        std::size_t start = 0;
+        if (nbThreads_ > 1 && path->numberPaths () > 1) {
+          // Speculatively validate every rank in parallel. The ranks
+          // below the lowest failure are known valid, so the sequential
+          // loop below only re-runs the failing rank, to build the valid
+          // part and the report exactly as in the sequential case.
+          start = firstInvalidRank (path);
+          if (start == path->numberPaths ()) {
+            validPart = path;
+            return true;
+          }
+        }
+        for (size_t i = start; i != path->numberPaths (); i++) {
           // We should stop at the first non valid subpath.
           if (!impl_validate (path->pathAtRank (i), false, validSubPart, report)) {
             PathVectorPtr_t p = PathVector::create
 	      (path->outputSize(), path->outputDerivativeSize());
+            // pathAtRank already returns a copy of the subpath, so the
+            // explicit copy would only duplicate it a second time.
             for (size_t v = 0; v < i; v++)
-              p->appendPath (path->pathAtRank(v)->copy());
+              p->appendPath (path->pathAtRank(v));
             // TODO: Make sure this subpart is generated by the steering method.
             p->appendPath (validSubPart);
             validPart = p;
@@ -91,6 +113,78 @@ namespace hpp {
       return true;
     }
 
+    std::size_t GraphPathValidation::firstInvalidRank
+    (const PathVectorPtr_t& path) const
+    {
+      const std::size_t n = path->numberPaths ();
+      const std::size_t nbThreads = std::min ((std::size_t) nbThreads_, n);
+      // A PathValidation instance is stateful, so the ranks whose
+      // subpaths share a validation object are assigned to the same
+      // worker, the other ones round-robin.
+      std::vector <std::vector <std::size_t> > ranks (nbThreads);
+      std::map <PathValidation*, std::size_t> workerOf;
+      std::size_t next = 0;
+      for (std::size_t i = 0; i < n; ++i) {
+        ConstraintSetPtr_t c = ConstraintSet::cast (path->pathAtRank (i)->constraints ());
+        PathValidationPtr_t validation (c
+            ? c->edge ()->pathValidation ()
+            : pathValidation_);
+        std::pair <std::map <PathValidation*, std::size_t>::iterator, bool>
+          res = workerOf.insert (std::make_pair (validation.get (), next));
+        if (res.second) next = (next + 1) % nbThreads;
+        ranks[res.first->second].push_back (i);
+      }
+      std::size_t firstFailure = n;
+      boost::mutex mutex;
+      boost::thread_group workers;
+      for (std::size_t rank = 0; rank < nbThreads; ++rank)
+        workers.create_thread (boost::bind
+            (&GraphPathValidation::validateRanksWorker, this,
+             boost::cref (path), boost::cref (ranks[rank]),
+             boost::ref (firstFailure), boost::ref (mutex)));
+      workers.join_all ();
+      return firstFailure;
+    }
+
+    void GraphPathValidation::validateRanksWorker (const PathVectorPtr_t& path,
+        const std::vector <std::size_t>& ranks, std::size_t& firstFailure,
+        boost::mutex& mutex) const
+    {
+      for (std::vector <std::size_t>::const_iterator it = ranks.begin ();
+          it != ranks.end (); ++it) {
+        {
+          boost::mutex::scoped_lock lock (mutex);
+          // The ranks are increasing: every remaining one is above the
+          // lowest known failure, so the outstanding work is cancelled.
+          if (*it >= firstFailure) return;
+        }
+        if (!validateRank (path->pathAtRank (*it))) {
+          boost::mutex::scoped_lock lock (mutex);
+          if (*it < firstFailure) firstFailure = *it;
+          return;
+        }
+      }
+    }
+
+    bool GraphPathValidation::validateRank (const PathPtr_t& subpath) const
+    {
+      // Nested path vectors are validated recursively, as impl_validate
+      // does.
+      PathVectorPtr_t pathVector = HPP_DYNAMIC_PTR_CAST(PathVector, subpath);
+      if (pathVector) {
+        for (std::size_t i = 0; i < pathVector->numberPaths (); ++i)
+          if (!validateRank (pathVector->pathAtRank (i))) return false;
+        return true;
+      }
+      ConstraintSetPtr_t c = ConstraintSet::cast (subpath->constraints());
+      PathValidationPtr_t validation (c
+          ? c->edge()->pathValidation()
+          : pathValidation_);
+      PathPtr_t pathNoCollision;
+      PathValidationReportPtr_t report;
+      return validation->validate (subpath, false, pathNoCollision, report);
+    }
+
     bool GraphPathValidation::impl_validate (const PathPtr_t& path,
         bool reverse, PathPtr_t& validPart, PathValidationReportPtr_t& report)
     {
@@ -99,7 +193,7 @@ namespace hpp {
         return impl_validate (pathVector, reverse, validPart, report);
 
       PathPtr_t pathNoCollision;
-      ConstraintSetPtr_t c = HPP_DYNAMIC_PTR_CAST(ConstraintSet, path->constraints());
+      ConstraintSetPtr_t c = ConstraintSet::cast (path->constraints());
       hppDout(info, (c?"Using edge path validation":"Using default path validation"));
       PathValidationPtr_t validation (c
           ? c->edge()->pathValidation()
@@ -113,7 +207,9 @@ namespace hpp {
       const Path& oldPath (*path);
       const core::interval_t& newTR = newPath.timeRange (),
                               oldTR = oldPath.timeRange ();
-      Configuration_t q (newPath.outputSize());
+      // Reused across calls, see qBuffer_.
+      Configuration_t& q = qBuffer_;
+      if (q.size () != newPath.outputSize ()) q.resize (newPath.outputSize ());
       if (!newPath (q, newTR.first))
         throw std::logic_error ("Initial configuration of the valid part cannot be projected.");
       const graph::StatePtr_t& origState = constraintGraph_->getState (q);
@@ -138,7 +234,7 @@ namespace hpp {
       try {
         destState = constraintGraph_->getState (q);
       } catch (const std::logic_error& e) {
-        ConstraintSetPtr_t c = HPP_DYNAMIC_PTR_CAST(ConstraintSet, path->constraints());
+        ConstraintSetPtr_t c = ConstraintSet::cast (path->constraints());
         hppDout (error, "Edge " << c->edge()->name()
             << " generated an error: " << e.what());
         hppDout (error, "Likely, the constraints for paths are relaxed. If "
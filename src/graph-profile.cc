@@ -0,0 +1,331 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/manipulation/graph-profile.hh>
+
+#include <cstring>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/cstdint.hpp>
+
+#include <hpp/util/pointer.hh>
+
+#include <hpp/manipulation/manipulation-planner.hh>
+#include <hpp/manipulation/graph/graph.hh>
+#include <hpp/manipulation/graph/state.hh>
+#include <hpp/manipulation/graph/edge.hh>
+#include <hpp/manipulation/graph/statistics.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace {
+      const char magic_[8] = { 'h', 'p', 'p', 'g', 'p', 'r', 'f', '\0' };
+      const boost::int64_t version_ = 1;
+
+      void write64 (std::ostream& os, const boost::int64_t v)
+      {
+        os.write (reinterpret_cast <const char*> (&v), sizeof (v));
+      }
+
+      boost::int64_t read64 (std::istream& is)
+      {
+        boost::int64_t v = 0;
+        is.read (reinterpret_cast <char*> (&v), sizeof (v));
+        return v;
+      }
+
+      /// Append the bin frequencies of hist to freqs, or nothing when
+      /// the histogram is of an unknown kind.
+      void histogramFreqs (const graph::HistogramPtr_t& hist,
+          std::vector <boost::int64_t>& freqs)
+      {
+        graph::LeafHistogramPtr_t lh =
+          HPP_DYNAMIC_PTR_CAST (graph::LeafHistogram, hist);
+        if (lh) {
+          for (graph::LeafHistogram::const_iterator bin = lh->begin ();
+              bin != lh->end (); ++bin)
+            freqs.push_back ((boost::int64_t) bin->freq ());
+          return;
+        }
+        graph::StateHistogramPtr_t sh =
+          HPP_DYNAMIC_PTR_CAST (graph::StateHistogram, hist);
+        if (sh) {
+          for (graph::StateHistogram::const_iterator bin = sh->begin ();
+              bin != sh->end (); ++bin)
+            freqs.push_back ((boost::int64_t) bin->freq ());
+        }
+      }
+
+      /// Tables of one profile, loaded sequentially by the converters.
+      struct Profile_t {
+        std::size_t nbStates, nbEdges, nbReasons, nbFrames;
+        /// Per state: id. Per edge: id, from, to, state, short, weight.
+        std::vector <boost::int64_t> states, edges;
+        std::map <boost::int64_t, std::string> names;
+        std::vector <std::string> reasons;
+        /// Per frame: nbEdges * nbReasons counters, then the histogram
+        /// frequencies prefixed by the histogram count and bin counts.
+        std::vector <std::vector <boost::int64_t> > counters, histograms;
+      };
+
+      void loadProfile (const std::string& path, Profile_t& p)
+      {
+        std::ifstream header (path.c_str (), std::ios::binary);
+        if (!header)
+          throw std::runtime_error ("Could not open graph profile " + path);
+        char magic[8];
+        header.read (magic, sizeof (magic));
+        const boost::int64_t version = read64 (header);
+        p.nbStates = (std::size_t) read64 (header);
+        p.nbEdges = (std::size_t) read64 (header);
+        p.nbReasons = (std::size_t) read64 (header);
+        p.nbFrames = (std::size_t) read64 (header);
+        if (!header || std::memcmp (magic, magic_, sizeof (magic)) != 0
+            || version != version_)
+          throw std::runtime_error (path + " is not a graph profile");
+
+        std::ifstream structure ((path + ".structure").c_str (),
+            std::ios::binary);
+        if (!structure)
+          throw std::runtime_error ("Could not open " + path + ".structure");
+        p.states.resize (p.nbStates);
+        for (std::size_t i = 0; i < p.nbStates; ++i)
+          p.states[i] = read64 (structure);
+        p.edges.resize (6 * p.nbEdges);
+        for (std::size_t i = 0; i < 6 * p.nbEdges; ++i)
+          p.edges[i] = read64 (structure);
+
+        std::ifstream names ((path + ".names").c_str ());
+        if (!names)
+          throw std::runtime_error ("Could not open " + path + ".names");
+        std::string line;
+        while (std::getline (names, line)) {
+          std::istringstream iss (line);
+          std::string kind;
+          boost::int64_t id;
+          if (!(iss >> kind >> id)) continue;
+          std::string name;
+          std::getline (iss, name);
+          if (!name.empty () && name[0] == ' ') name.erase (0, 1);
+          if (kind == "R") {
+            if ((std::size_t) id >= p.reasons.size ())
+              p.reasons.resize ((std::size_t) id + 1);
+            p.reasons[(std::size_t) id] = name;
+          } else
+            p.names[id] = name;
+        }
+
+        std::ifstream stats ((path + ".stats").c_str (), std::ios::binary);
+        if (!stats)
+          throw std::runtime_error ("Could not open " + path + ".stats");
+        p.counters.resize (p.nbFrames);
+        p.histograms.resize (p.nbFrames);
+        for (std::size_t f = 0; f < p.nbFrames; ++f) {
+          p.counters[f].resize (p.nbEdges * p.nbReasons);
+          for (std::size_t i = 0; i < p.counters[f].size (); ++i)
+            p.counters[f][i] = read64 (stats);
+          const boost::int64_t nbHists = read64 (stats);
+          std::vector <boost::int64_t>& h = p.histograms[f];
+          h.push_back (nbHists);
+          for (boost::int64_t j = 0; j < nbHists; ++j) {
+            const boost::int64_t nbBins = read64 (stats);
+            h.push_back (nbBins);
+            for (boost::int64_t b = 0; b < nbBins; ++b)
+              h.push_back (read64 (stats));
+          }
+          if (!stats)
+            throw std::runtime_error (path + ".stats is truncated");
+        }
+      }
+    } // namespace
+
+    GraphProfileWriter::GraphProfileWriter (const std::string& path,
+        const graph::GraphPtr_t& graph) :
+      path_ (path), graph_ (graph),
+      stats_ ((path + ".stats").c_str (),
+          std::ios::binary | std::ios::trunc),
+      nbStates_ (0),
+      nbReasons_ (ManipulationPlanner::errorList ().size ()),
+      nbFrames_ (0)
+    {
+      std::ofstream structure ((path + ".structure").c_str (),
+          std::ios::binary | std::ios::trunc);
+      std::ofstream names ((path + ".names").c_str (), std::ios::trunc);
+      if (!structure || !names || !stats_)
+        throw std::runtime_error ("Could not open graph profile " + path);
+
+      // States first, then edges, walking the dense component tables of
+      // the initialized graph once.
+      for (std::size_t id = 0; id < graph->nbComponents (); ++id) {
+        graph::State* state = graph->stateByIndex (id);
+        if (!state) continue;
+        write64 (structure, (boost::int64_t) id);
+        names << "S " << id << " " << state->name () << "\n";
+        ++nbStates_;
+      }
+      for (std::size_t id = 0; id < graph->nbComponents (); ++id) {
+        const graph::Graph::EdgeInfo_t& info = graph->edgeInfo (id);
+        if (!info.edge) continue;
+        write64 (structure, (boost::int64_t) id);
+        write64 (structure, (boost::int64_t) info.fromId);
+        write64 (structure, (boost::int64_t) info.toId);
+        write64 (structure, (boost::int64_t) info.stateId);
+        write64 (structure, info.isShort ? 1 : 0);
+        write64 (structure, (boost::int64_t) info.weight);
+        names << "E " << id << " " << info.edge->name () << "\n";
+        graph::EdgePtr_t edge = HPP_DYNAMIC_PTR_CAST (graph::Edge,
+            graph->get (id).lock ());
+        assert (edge);
+        edges_.push_back (edge);
+      }
+      const StringList_t reasons = ManipulationPlanner::errorList ();
+      std::size_t r = 0;
+      for (StringList_t::const_iterator it = reasons.begin ();
+          it != reasons.end (); ++it, ++r)
+        names << "R " << r << " " << *it << "\n";
+
+      structure.flush ();
+      names.flush ();
+      if (!structure || !names)
+        throw std::runtime_error ("Could not write graph profile " + path);
+      writeHeader ();
+    }
+
+    void GraphProfileWriter::checkpoint (const ManipulationPlanner& planner)
+    {
+      for (std::size_t i = 0; i < edges_.size (); ++i) {
+        const ManipulationPlanner::ErrorFreqs_t freqs =
+          planner.getEdgeStat (edges_[i]);
+        std::size_t written = 0;
+        for (ManipulationPlanner::ErrorFreqs_t::const_iterator it =
+            freqs.begin ();
+            it != freqs.end () && written < nbReasons_; ++it, ++written)
+          write64 (stats_, (boost::int64_t) *it);
+        // Edges never extended report fewer counters; pad with zeros so
+        // the frame stays rectangular.
+        for (; written < nbReasons_; ++written) write64 (stats_, 0);
+      }
+      const graph::Histograms_t& hists = graph_->histograms ();
+      write64 (stats_, (boost::int64_t) hists.size ());
+      for (graph::Histograms_t::const_iterator it = hists.begin ();
+          it != hists.end (); ++it) {
+        std::vector <boost::int64_t> freqs;
+        histogramFreqs (*it, freqs);
+        write64 (stats_, (boost::int64_t) freqs.size ());
+        for (std::size_t b = 0; b < freqs.size (); ++b)
+          write64 (stats_, freqs[b]);
+      }
+      // Flush the frame before committing the new count, so that the
+      // header never describes data that did not reach the file system.
+      stats_.flush ();
+      ++nbFrames_;
+      writeHeader ();
+    }
+
+    void GraphProfileWriter::writeHeader ()
+    {
+      std::ofstream header (path_.c_str (),
+          std::ios::binary | std::ios::trunc);
+      if (!header)
+        throw std::runtime_error ("Could not write graph profile header "
+            + path_);
+      header.write (magic_, sizeof (magic_));
+      write64 (header, version_);
+      write64 (header, (boost::int64_t) nbStates_);
+      write64 (header, (boost::int64_t) edges_.size ());
+      write64 (header, (boost::int64_t) nbReasons_);
+      write64 (header, (boost::int64_t) nbFrames_);
+      header.flush ();
+    }
+
+    void GraphProfileWriter::exportDot (const std::string& path,
+        std::ostream& os)
+    {
+      Profile_t p;
+      loadProfile (path, p);
+      os << "digraph G {\n";
+      for (std::size_t i = 0; i < p.nbStates; ++i)
+        os << "  n" << p.states[i] << " [label=\"" << p.names[p.states[i]]
+           << "\"];\n";
+      for (std::size_t i = 0; i < p.nbEdges; ++i) {
+        const boost::int64_t* e = &p.edges[6 * i];
+        os << "  n" << e[1] << " -> n" << e[2] << " [label=\""
+           << p.names[e[0]];
+        if (p.nbFrames > 0) {
+          const std::vector <boost::int64_t>& last = p.counters.back ();
+          os << "\\n";
+          for (std::size_t r = 0; r < p.nbReasons; ++r) {
+            if (r) os << " ";
+            os << last[i * p.nbReasons + r];
+          }
+        }
+        os << "\"";
+        if (e[4]) os << ", style=dashed";
+        os << "];\n";
+      }
+      os << "}\n";
+    }
+
+    void GraphProfileWriter::exportJSON (const std::string& path,
+        std::ostream& os)
+    {
+      Profile_t p;
+      loadProfile (path, p);
+      os << "{\n  \"reasons\": [";
+      for (std::size_t r = 0; r < p.reasons.size (); ++r)
+        os << (r ? ", " : "") << "\"" << p.reasons[r] << "\"";
+      os << "],\n  \"states\": [";
+      for (std::size_t i = 0; i < p.nbStates; ++i) {
+        os << (i ? ", " : "") << "{\"id\": " << p.states[i]
+           << ", \"name\": \"" << p.names[p.states[i]] << "\"}";
+      }
+      os << "],\n  \"edges\": [";
+      for (std::size_t i = 0; i < p.nbEdges; ++i) {
+        const boost::int64_t* e = &p.edges[6 * i];
+        os << (i ? ", " : "") << "{\"id\": " << e[0]
+           << ", \"name\": \"" << p.names[e[0]]
+           << "\", \"from\": " << e[1] << ", \"to\": " << e[2]
+           << ", \"state\": " << e[3] << ", \"short\": " << e[4]
+           << ", \"weight\": " << e[5] << "}";
+      }
+      os << "],\n  \"frames\": [";
+      for (std::size_t f = 0; f < p.nbFrames; ++f) {
+        os << (f ? ",\n    " : "\n    ") << "{\"edges\": [";
+        for (std::size_t i = 0; i < p.nbEdges; ++i) {
+          os << (i ? ", " : "") << "[";
+          for (std::size_t r = 0; r < p.nbReasons; ++r)
+            os << (r ? ", " : "") << p.counters[f][i * p.nbReasons + r];
+          os << "]";
+        }
+        os << "], \"histograms\": [";
+        const std::vector <boost::int64_t>& h = p.histograms[f];
+        std::size_t k = 1;
+        for (boost::int64_t j = 0; j < h[0]; ++j) {
+          const boost::int64_t nbBins = h[k++];
+          os << (j ? ", " : "") << "[";
+          for (boost::int64_t b = 0; b < nbBins; ++b)
+            os << (b ? ", " : "") << h[k++];
+          os << "]";
+        }
+        os << "]}";
+      }
+      os << "\n  ]\n}\n";
+    }
+  } // namespace manipulation
+} // namespace hpp
@@ -67,24 +67,25 @@ namespace hpp {
 
     PathPtr_t GraphSteeringMethod::impl_compute (ConfigurationIn_t q1, ConfigurationIn_t q2) const
     {
-      graph::Edges_t possibleEdges;
+      std::size_t pairId;
       const graph::Graph& graph = *problem_.constraintGraph ();
       try {
-        possibleEdges = graph.getEdges
+        pairId = graph.statePairId
 	  (graph.getState (q1), graph.getState (q2));
       } catch (const std::logic_error& e) {
         hppDout (error, e.what ());
         return PathPtr_t ();
       }
+      const graph::Edges_t& possibleEdges = graph.getEdges (pairId);
       PathPtr_t path;
       if (possibleEdges.empty()) {
         hppDout (info, "No edge found.");
       }
-      while (!possibleEdges.empty()) {
-        if (possibleEdges.back ()->build (path, q1, q2)) {
+      for (graph::Edges_t::const_reverse_iterator it =
+          possibleEdges.rbegin (); it != possibleEdges.rend (); ++it) {
+        if ((*it)->build (path, q1, q2)) {
           return path;
         }
-        possibleEdges.pop_back ();
       }
       return PathPtr_t ();
     }
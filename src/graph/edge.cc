@@ -22,6 +22,7 @@
 #include <hpp/util/exception-factory.hh>
 
 #include <hpp/pinocchio/configuration.hh>
+#include <hpp/core/explicit-numerical-constraint.hh>
 #include <hpp/core/path-vector.hh>
 #include <hpp/core/path-validation.hh>
 
@@ -41,7 +42,10 @@ namespace hpp {
         pathConstraints_ (),
 	configConstraints_ (),
         steeringMethod_ (),
-        pathValidation_ ()
+        pathValidation_ (),
+        fullyExplicit_ (false),
+        leafBoundsPrefilter_ (false),
+        leafBoundsValid_ (false)
       {}
 
       Edge::~Edge ()
@@ -221,6 +225,39 @@ namespace hpp {
         }
       }
 
+      // Structural signature of the constraint stack built from these
+      // components: the numerical constraints with their passive dofs
+      // and the locked joints, identified by pointer as in
+      // mergeConstraintsIntoConfigProjector. Edges with the same
+      // signature get the same projector from the graph-wide pool.
+      static std::string projectorSignature
+      (const std::vector <GraphComponentPtr_t>& components)
+      {
+        std::ostringstream oss;
+        for (std::vector <GraphComponentPtr_t>::const_iterator it
+               (components.begin ()); it != components.end (); ++it) {
+          const NumericalConstraints_t& nc ((*it)->numericalConstraints ());
+          const IntervalsContainer_t& pdofs ((*it)->passiveDofs ());
+          assert (nc.size () == pdofs.size ());
+          NumericalConstraints_t::const_iterator itnc (nc.begin ());
+          IntervalsContainer_t::const_iterator itpdof (pdofs.begin ());
+          while (itnc != nc.end ()) {
+            oss << itnc->get ();
+            for (segments_t::const_iterator itseg (itpdof->begin ());
+                itseg != itpdof->end (); ++itseg)
+              oss << ',' << itseg->first << ',' << itseg->second;
+            oss << ';';
+            ++itnc; ++itpdof;
+          }
+          const LockedJoints_t& ljs ((*it)->lockedJoints ());
+          for (LockedJoints_t::const_iterator itlj (ljs.begin ());
+              itlj != ljs.end (); ++itlj)
+            oss << itlj->get () << ';';
+          oss << '|';
+        }
+        return oss.str ();
+      }
+
       ConstraintSetPtr_t Edge::buildConfigConstraint()
       {
         std::string n = "(" + name () + ")";
@@ -228,14 +265,6 @@ namespace hpp {
 
         ConstraintSetPtr_t constraint = ConstraintSet::create (g->robot (), "Set " + n);
 
-        ConfigProjectorPtr_t proj = ConfigProjector::create(g->robot(), "proj_" + n, g->errorThreshold(), g->maxIterations());
-        g->insertLockedJoints (proj);
-        insertLockedJoints (proj);
-        to ()->insertLockedJoints (proj);
-	if (state () != to ()) {
-	  state ()->insertLockedJoints (proj);
-	}
-
         std::vector <GraphComponentPtr_t> components;
         components.push_back (g);
         components.push_back (wkPtr_.lock ());
@@ -243,13 +272,123 @@ namespace hpp {
 	if (state () != to ()) {
           components.push_back (state ());
 	}
-        mergeConstraintsIntoConfigProjector (proj, components, parentGraph ());
+        // Most edges of a generated graph stack the same constraints
+        // and differ only by their right hand side, which is set from a
+        // configuration before every solve: compile the projector once
+        // and share it between those edges.
+        const std::string signature = projectorSignature (components);
+        ConfigProjectorPtr_t proj = g->sharedConfigProjector (signature);
+        if (!proj) {
+          proj = ConfigProjector::create(g->robot(), "proj_" + n, g->errorThreshold(), g->maxIterations());
+          g->insertLockedJoints (proj);
+          insertLockedJoints (proj);
+          to ()->insertLockedJoints (proj);
+          if (state () != to ()) {
+            state ()->insertLockedJoints (proj);
+          }
+          mergeConstraintsIntoConfigProjector (proj, components, parentGraph ());
+          g->addSharedConfigProjector (signature, proj);
+        }
+        collectExplicitConstraints (components);
 
         constraint->addConstraint (proj);
         constraint->edge (wkPtr_.lock ());
+
+        // Coarse stage of the projection ladder: same constraint stack,
+        // loose tolerance and few iterations, to reject hopeless seeds
+        // before the full-precision solve. Shared through the projector
+        // pool like the fine projector.
+        if (g->problem ()->getParameter ("Edge/ProjectionLadder", false)) {
+          const std::string coarseSignature = "coarse:" + signature;
+          ConfigProjectorPtr_t coarse =
+            g->sharedConfigProjector (coarseSignature);
+          if (!coarse) {
+            coarse = ConfigProjector::create (g->robot (), "coarse_proj_" + n,
+                10 * g->errorThreshold (), g->maxIterations () / 4 + 1);
+            g->insertLockedJoints (coarse);
+            insertLockedJoints (coarse);
+            to ()->insertLockedJoints (coarse);
+            if (state () != to ()) {
+              state ()->insertLockedJoints (coarse);
+            }
+            mergeConstraintsIntoConfigProjector (coarse, components,
+                parentGraph ());
+            g->addSharedConfigProjector (coarseSignature, coarse);
+          }
+          coarseConstraint_ = ConstraintSet::create (g->robot (),
+              "CoarseSet " + n);
+          coarseConstraint_->addConstraint (coarse);
+          coarseConstraint_->edge (wkPtr_.lock ());
+        } else coarseConstraint_.reset ();
+
         return constraint;
       }
 
+      void Edge::collectExplicitConstraints
+      (const std::vector <GraphComponentPtr_t>& components)
+      {
+        explicitConstraints_.clear ();
+        fullyExplicit_ = true;
+        for (std::vector <GraphComponentPtr_t>::const_iterator it
+               (components.begin ()); it != components.end (); ++it) {
+          const NumericalConstraints_t& ncs ((*it)->numericalConstraints ());
+          for (NumericalConstraints_t::const_iterator itnc (ncs.begin ());
+              itnc != ncs.end (); ++itnc) {
+            ExplicitNumericalConstraintPtr_t enc
+              (HPP_DYNAMIC_PTR_CAST (core::ExplicitNumericalConstraint,
+                                     *itnc));
+            if (!enc) {
+              fullyExplicit_ = false;
+              continue;
+            }
+            // Equality rows take a leaf-dependent right hand side that
+            // only the solver handles: leave those constraints to it.
+            bool equalToZero = true;
+            const ComparisonTypes_t comp (enc->comparisonType ());
+            for (std::size_t i = 0; i < comp.size (); ++i)
+              if (comp[i] == constraints::Equality) {
+                equalToZero = false;
+                break;
+              }
+            if (equalToZero)
+              explicitConstraints_.push_back (enc);
+            else
+              fullyExplicit_ = false;
+          }
+        }
+        if (explicitConstraints_.empty ()) fullyExplicit_ = false;
+      }
+
+      void Edge::seedFromExplicitConstraints (ConfigurationOut_t q) const
+      {
+        typedef std::vector <ExplicitNumericalConstraintPtr_t> ENCs_t;
+        for (ENCs_t::const_iterator it (explicitConstraints_.begin ());
+            it != explicitConstraints_.end (); ++it) {
+          const DifferentiableFunctionPtr_t& f ((*it)->explicitFunction ());
+          const segments_t& inConf ((*it)->inputConf ());
+          const segments_t& outConf ((*it)->outputConf ());
+          // Gather the input variables.
+          vector_t qin (f->inputSize ());
+          size_type row = 0;
+          for (segments_t::const_iterator itseg (inConf.begin ());
+              itseg != inConf.end (); ++itseg) {
+            qin.segment (row, itseg->second) =
+              q.segment (itseg->first, itseg->second);
+            row += itseg->second;
+          }
+          // Substitute the value into the output variables.
+          LiegroupElement result (f->outputSpace ());
+          f->value (result, qin);
+          row = 0;
+          for (segments_t::const_iterator itseg (outConf.begin ());
+              itseg != outConf.end (); ++itseg) {
+            q.segment (itseg->first, itseg->second) =
+              result.vector ().segment (row, itseg->second);
+            row += itseg->second;
+          }
+        }
+      }
+
       ConstraintSetPtr_t Edge::pathConstraint() const
       {
         throwIfNotInitialized ();
@@ -263,16 +402,20 @@ namespace hpp {
 
         ConstraintSetPtr_t constraint = ConstraintSet::create (g->robot (), "Set " + n);
 
-        ConfigProjectorPtr_t proj = ConfigProjector::create(g->robot(), "proj_" + n, g->errorThreshold(), g->maxIterations());
-        g->insertLockedJoints (proj);
-        insertLockedJoints (proj);
-        state ()->insertLockedJoints (proj);
-
         std::vector <GraphComponentPtr_t> components;
         components.push_back (g);
         components.push_back (wkPtr_.lock ());
         components.push_back (state ());
-        mergeConstraintsIntoConfigProjector (proj, components, parentGraph ());
+        const std::string signature = projectorSignature (components);
+        ConfigProjectorPtr_t proj = g->sharedConfigProjector (signature);
+        if (!proj) {
+          proj = ConfigProjector::create(g->robot(), "proj_" + n, g->errorThreshold(), g->maxIterations());
+          g->insertLockedJoints (proj);
+          insertLockedJoints (proj);
+          state ()->insertLockedJoints (proj);
+          mergeConstraintsIntoConfigProjector (proj, components, parentGraph ());
+          g->addSharedConfigProjector (signature, proj);
+        }
 
         constraint->addConstraint (proj);
         constraint->edge (wkPtr_.lock ());
@@ -281,24 +424,77 @@ namespace hpp {
         const ProblemPtr_t& problem (g->problem());
         steeringMethod_ = problem->steeringMethod()->innerSteeringMethod()->copy();
         steeringMethod_->constraints (constraint);
-        // Build path validation and relative motion matrix
-        // TODO this path validation will not contain obstacles added after
-        // its creation.
-        pathValidation_ = problem->pathValidationFactory ();
-        relMotion_ = RelativeMotion::matrix (g->robot());
-        RelativeMotion::fromConstraint (relMotion_, g->robot(), constraint);
-        pathValidation_->filterCollisionPairs (relMotion_);
+        // Build path validation and relative motion matrix. The matrix
+        // and the collision pairs it disables only depend on the
+        // structure of the stack, so edges with the same signature
+        // share one filtered path validation instead of re-filtering
+        // the pairs edge by edge on every problem reset. A pooled
+        // validation is rebuilt when the geometry epoch changed, so it
+        // stays consistent with obstacles added after its creation.
+        const std::size_t epoch = problem->geometryEpoch ();
+        const Graph::FilteredValidation_t* shared =
+          g->sharedFilteredValidation (signature, epoch);
+        if (!shared) {
+          Graph::FilteredValidation_t data;
+          data.geometryEpoch = epoch;
+          data.pathValidation = problem->pathValidationFactory ();
+          data.relativeMotion = RelativeMotion::matrix (g->robot());
+          RelativeMotion::fromConstraint (data.relativeMotion, g->robot(),
+              constraint);
+          data.pathValidation->filterCollisionPairs (data.relativeMotion);
+          shared = &g->addSharedFilteredValidation (signature, data);
+        }
+        pathValidation_ = shared->pathValidation;
+        relMotion_ = shared->relativeMotion;
+        leafBoundsPrefilter_ = problem->getParameter
+          ("Edge/LeafBoundsPrefilter", false);
+        leafBoundsValid_ = false;
         return constraint;
       }
 
+      bool Edge::insideLeafBounds (const vector_t& rhs) const
+      {
+        if (!leafBoundsValid_ || rhs.size () != leafBoundsLower_.size ())
+          return true;
+        // Same tolerance as the per-leaf projection cache: leaves closer
+        // than the solver can distinguish are considered identical.
+        const value_type tol = 10 * graph_.lock ()->errorThreshold ();
+        for (size_type i = 0; i < rhs.size (); ++i)
+          if (rhs[i] < leafBoundsLower_[i] - tol ||
+              rhs[i] > leafBoundsUpper_[i] + tol)
+            return false;
+        return true;
+      }
+
+      void Edge::growLeafBounds (const vector_t& rhs) const
+      {
+        if (!leafBoundsValid_ || rhs.size () != leafBoundsLower_.size ()) {
+          leafBoundsLower_ = rhs;
+          leafBoundsUpper_ = rhs;
+          leafBoundsValid_ = true;
+          return;
+        }
+        leafBoundsLower_ = leafBoundsLower_.cwiseMin (rhs);
+        leafBoundsUpper_ = leafBoundsUpper_.cwiseMax (rhs);
+      }
+
       bool Edge::canConnect (ConfigurationIn_t q1, ConfigurationIn_t q2)
 	const
       {
         ConstraintSetPtr_t constraints = pathConstraint ();
-        constraints->configProjector ()->rightHandSideFromConfig(q1);
+        ConfigProjectorPtr_t proj = constraints->configProjector ();
+        proj->rightHandSideFromConfig(q1);
+        // Prefilter on the leaf parameter: when q1 lies on a leaf outside
+        // the bounding box of the leaves seen to connect through this
+        // edge, skip the two full constraint evaluations. canConnect is
+        // only called from the planner thread so the bounds need no lock.
+        if (leafBoundsPrefilter_ &&
+            !insideLeafBounds (proj->rightHandSide ()))
+          return false;
         if (!constraints->isSatisfied (q1) || !constraints->isSatisfied (q2)) {
           return false;
         }
+        growLeafBounds (proj->rightHandSide ());
         return true;
       }
 
@@ -339,6 +535,48 @@ namespace hpp {
         return applyConstraints (*(nnear->configuration ()), q);
       }
 
+      const std::size_t Edge::maxLeafProjections_ = 16;
+
+      bool Edge::warmStart (const vector_t& rhs, Configuration_t& q) const
+      {
+        // Leaves are considered identical when their right hand sides match
+        // up to a tolerance coarser than the solver threshold, so that the
+        // cache also warm-starts solves on neighboring leaves.
+        const value_type tol = 10 * graph_.lock ()->errorThreshold ();
+        boost::mutex::scoped_lock lock (leafProjectionsMutex_);
+        for (LeafProjections_t::iterator it = leafProjections_.begin ();
+            it != leafProjections_.end (); ++it) {
+          if (it->first.size () != rhs.size ()) continue;
+          if ((it->first - rhs).lpNorm<Eigen::Infinity> () < tol) {
+            q = it->second;
+            leafProjections_.splice (leafProjections_.begin (),
+                leafProjections_, it);
+            return true;
+          }
+        }
+        return false;
+      }
+
+      void Edge::storeProjection (const vector_t& rhs,
+          ConfigurationIn_t q) const
+      {
+        const value_type tol = 10 * graph_.lock ()->errorThreshold ();
+        boost::mutex::scoped_lock lock (leafProjectionsMutex_);
+        for (LeafProjections_t::iterator it = leafProjections_.begin ();
+            it != leafProjections_.end (); ++it) {
+          if (it->first.size () == rhs.size () &&
+              (it->first - rhs).lpNorm<Eigen::Infinity> () < tol) {
+            it->second = q;
+            leafProjections_.splice (leafProjections_.begin (),
+                leafProjections_, it);
+            return;
+          }
+        }
+        leafProjections_.push_front (LeafProjection_t (rhs, q));
+        if (leafProjections_.size () > maxLeafProjections_)
+          leafProjections_.pop_back ();
+      }
+
       bool Edge::applyConstraints (ConfigurationIn_t qoffset,
 				   ConfigurationOut_t q) const
       {
@@ -346,7 +584,45 @@ namespace hpp {
         ConfigProjectorPtr_t proj = c->configProjector ();
         proj->rightHandSideFromConfig (qoffset);
         if (isShort_) q = qoffset;
-        if (c->apply (q)) return true;
+        // Substitute the explicit part of the constraints (object poses)
+        // into the random sample, so the solver only has to pull back
+        // the remaining degrees of freedom.
+        else seedFromExplicitConstraints (q);
+        // Fully explicit stack: the substitution above is the solution,
+        // so one residual check - which also covers the locked joints -
+        // replaces the Newton solve. When the check fails (a locked
+        // joint not set yet, numerical round-off) the solver below
+        // recovers.
+        if (!isShort_ && fullyExplicit_ && c->isSatisfied (q)) {
+          storeProjection (proj->rightHandSide (), q);
+          return true;
+        }
+        // Coarse-to-fine ladder: a loose low-iteration solve rejects
+        // hopeless seeds, so the full-precision iterations below are
+        // only spent polishing candidates that roughly converged.
+        if (coarseConstraint_) {
+          coarseConstraint_->configProjector ()->rightHandSideFromConfig
+            (qoffset);
+          Configuration_t qCoarse (q);
+          if (!coarseConstraint_->apply (qCoarse)) return false;
+          q = qCoarse;
+        }
+        if (c->apply (q)) {
+          storeProjection (proj->rightHandSide (), q);
+          return true;
+        }
+        // Warm-started retry: restart the solver from the last successful
+        // solution on this leaf of the foliation. That configuration lies
+        // on or close to the manifold so the solve is much cheaper than
+        // from the random sample.
+        Configuration_t qWarm;
+        if (warmStart (proj->rightHandSide (), qWarm)) {
+          if (c->apply (qWarm)) {
+            q = qWarm;
+            storeProjection (proj->rightHandSide (), q);
+            return true;
+          }
+        }
 	const ::hpp::statistics::SuccessStatistics& ss = proj->statistics ();
 	if (ss.nbFailure () > ss.nbSuccess ()) {
 	  hppDout (warning, c->name () << " fails often.\n" << ss);
@@ -359,6 +635,47 @@ namespace hpp {
         return false;
       }
 
+      size_type Edge::applyConstraintsWithSeeds (ConfigurationIn_t qoffset,
+					matrixOut_t qs) const
+      {
+        ConstraintSetPtr_t c = configConstraint ();
+        ConfigProjectorPtr_t proj = c->configProjector ();
+        // The right hand side and the data derived from it are computed
+        // once and shared by all the seed solves.
+        proj->rightHandSideFromConfig (qoffset);
+        Configuration_t q (qs.rows ());
+        if (isShort_) {
+          // The seed is overwritten by qoffset on short edges, so all the
+          // columns would run the same solve.
+          q = qoffset;
+          if (c->apply (q)) {
+            qs.col (0) = q;
+            storeProjection (proj->rightHandSide (), q);
+            return 0;
+          }
+          return -1;
+        }
+        for (size_type i = 0; i < qs.cols (); ++i) {
+          q = qs.col (i);
+          if (c->apply (q)) {
+            qs.col (i) = q;
+            storeProjection (proj->rightHandSide (), q);
+            return i;
+          }
+        }
+        // Warm-started retry as in the single seed overload, from the
+        // last successful solution on this leaf of the foliation.
+        Configuration_t qWarm;
+        if (warmStart (proj->rightHandSide (), qWarm)) {
+          if (c->apply (qWarm)) {
+            qs.col (0) = qWarm;
+            storeProjection (proj->rightHandSide (), qWarm);
+            return 0;
+          }
+        }
+        return -1;
+      }
+
       WaypointEdgePtr_t WaypointEdge::create (const std::string& name,
        const GraphWkPtr_t& graph, const StateWkPtr_t& from,
        const StateWkPtr_t& to)
@@ -390,68 +707,125 @@ namespace hpp {
       bool WaypointEdge::build (core::PathPtr_t& path, ConfigurationIn_t q1,
           ConfigurationIn_t q2) const
       {
-        core::PathPtr_t p;
-        core::PathVectorPtr_t pv = core::PathVector::create
-          (graph_.lock ()->robot ()->configSize (),
-           graph_.lock ()->robot ()->numberDof ());
         // Many times, this will be called rigth after WaypointEdge::applyConstraints so config_
-        // already satisfies the constraints.
+        // already satisfies the constraints. Only the intermediate
+        // waypoints need a cached solution here, hence n - 1.
         size_type n = edges_.size();
         assert (configs_.cols() == n + 1);
-        bool useCache = lastSucceeded_
+        bool useCache = validWaypoints_ + 1 >= n
           && configs_.col(0).isApprox (q1)
           && configs_.col(n).isApprox (q2);
         configs_.col(0) = q1;
         configs_.col(n) = q2;
 
+        // Sub-paths are collected in a recycled buffer and the enclosing
+        // path vector is only allocated once the whole chain succeeded:
+        // most attempts fail on an intermediate waypoint and would throw
+        // a freshly allocated path vector away.
+        subPaths_.assign ((std::size_t) n, core::PathPtr_t ());
+
         for (size_type i = 0; i < n; ++i) {
-          if (i < (n-1) && !useCache) configs_.col (i+1) = q2;
-          if (i < (n-1) && !edges_[i]->applyConstraints (configs_.col(i), configs_.col (i+1))) {
-            hppDout (info, "Waypoint edge " << name() << ": applyConstraints failed at waypoint " << i << "."
-                << "\nUse cache: " << useCache
-                );
-            lastSucceeded_ = false;
-            return false;
+          if (i < (n-1) && !useCache) {
+            validWaypoints_ = i;
+            configs_.col (i+1) = q2;
+            if (!edges_[i]->applyConstraints (configs_.col(i), configs_.col (i+1))) {
+              hppDout (info, "Waypoint edge " << name() << ": applyConstraints failed at waypoint " << i << "."
+                  << "\nUse cache: " << useCache
+                  );
+              return false;
+            }
+            rhs_[i] = edges_[i]->configConstraint ()->configProjector ()
+              ->rightHandSide ();
+            validWaypoints_ = i + 1;
           }
-          if (!edges_[i]->build (p, configs_.col(i), configs_.col (i+1))) {
+          if (!edges_[i]->build (subPaths_[(std::size_t) i], configs_.col(i),
+                configs_.col (i+1))) {
             hppDout (info, "Waypoint edge " << name() << ": build failed at waypoint " << i << "."
                 << "\nUse cache: " << useCache
                 );
-            lastSucceeded_ = false;
+            // The waypoints still satisfy the constraints but a retry
+            // with the same chain would fail the same way; discard it
+            // so that the next call draws new solutions.
+            validWaypoints_ = 0;
             return false;
           }
-          pv->appendPath (p);
         }
 
+        core::PathVectorPtr_t pv = core::PathVector::create
+          (graph_.lock ()->robot ()->configSize (),
+           graph_.lock ()->robot ()->numberDof ());
+        for (std::size_t i = 0; i < subPaths_.size (); ++i) {
+          pv->appendPath (subPaths_[i]);
+          subPaths_[i].reset ();
+        }
         path = pv;
-        lastSucceeded_ = true;
         return true;
       }
 
       bool WaypointEdge::applyConstraints (ConfigurationIn_t qoffset, ConfigurationOut_t q) const
       {
-        assert (configs_.cols() == size_type(edges_.size() + 1));
+        const size_type n = size_type(edges_.size());
+        assert (configs_.cols() == n + 1);
+        const value_type tol = 10 * graph_.lock ()->errorThreshold ();
         configs_.col(0) = qoffset;
-        for (std::size_t i = 0; i < edges_.size (); ++i) {
+        for (size_type i = 0; i < n; ++i) {
+          // Waypoint i was solved on the leaf identified by the right
+          // hand side of edge i. When the offset configuration yields
+          // the same right hand side again, the cached solution is
+          // reused and the solve is skipped. The first waypoint whose
+          // right hand side changed invalidates the rest of the chain,
+          // since the following offsets change with it.
+          ConstraintSetPtr_t c = edges_[i]->configConstraint ();
+          ConfigProjectorPtr_t proj = c->configProjector ();
+          proj->rightHandSideFromConfig (configs_.col (i));
+          if (i < validWaypoints_
+              && rhs_[i].size () == proj->rightHandSide ().size ()
+              && (rhs_[i] - proj->rightHandSide ()).lpNorm <Eigen::Infinity> () < tol
+              && c->isSatisfied (configs_.col (i+1)))
+            continue;
+          validWaypoints_ = i;
           configs_.col (i+1) = q;
           if (!edges_[i]->applyConstraints (configs_.col(i), configs_.col (i+1))) {
             q = configs_.col(i+1);
-            lastSucceeded_ = false;
             return false;
           }
+          // Read the right hand side back after the solve so that
+          // sub-edges adding their own offset - LevelSetEdge - store
+          // the one actually used and never match the cache check.
+          rhs_[i] = proj->rightHandSide ();
+          validWaypoints_ = i + 1;
         }
-        q = configs_.col(edges_.size());
-        lastSucceeded_ = true;
+        q = configs_.col(n);
         return true;
       }
 
+      size_type WaypointEdge::applyConstraintsWithSeeds (ConfigurationIn_t qoffset,
+						matrixOut_t qs) const
+      {
+        // The chained waypoint solves depend on each seed, so nothing
+        // can be shared between the columns.
+        Configuration_t q (qs.rows ());
+        for (size_type i = 0; i < qs.cols (); ++i) {
+          q = qs.col (i);
+          if (applyConstraints (qoffset, q)) {
+            qs.col (i) = q;
+            return i;
+          }
+        }
+        return -1;
+      }
+
       void WaypointEdge::nbWaypoints (const size_type number)
       {
         edges_.resize (number + 1);
         states_.resize (number + 1);
         states_.back() = to();
         const size_type nbDof = graph_.lock ()->robot ()->configSize ();
+        // Preallocate the solution and right hand side buffers so that
+        // solving and building on this edge allocate nothing.
         configs_ = matrix_t (nbDof, number + 2);
+        rhs_.assign (number + 1, vector_t ());
+        validWaypoints_ = 0;
       }
 
       void WaypointEdge::setWaypoint (const std::size_t index,
@@ -542,16 +916,39 @@ namespace hpp {
       bool LevelSetEdge::applyConstraints (ConfigurationIn_t qoffset, ConfigurationOut_t q) const
       {
         // First, get an offset from the histogram
-        statistics::DiscreteDistribution < RoadmapNodePtr_t > distrib = hist_->getDistrib ();
-        if (distrib.size () == 0) {
+        const LeafHistogram::NodeDistributionPtr_t distrib = hist_->getDistrib ();
+        if (distrib->size () == 0) {
           hppDout (warning, "Edge " << name() << ": Distrib is empty");
           return false;
         }
-        const Configuration_t& qlevelset = *(distrib ()->configuration ());
+        const Configuration_t& qlevelset = *((*distrib) ()->configuration ());
 
         return applyConstraintsWithOffset (qoffset, qlevelset, q);
       }
 
+      size_type LevelSetEdge::applyConstraintsWithSeeds (ConfigurationIn_t qoffset,
+						matrixOut_t qs) const
+      {
+        // The level set offset is drawn once and shared by all the seed
+        // solves.
+        const LeafHistogram::NodeDistributionPtr_t distrib = hist_->getDistrib ();
+        if (distrib->size () == 0) {
+          hppDout (warning, "Edge " << name() << ": Distrib is empty");
+          return -1;
+        }
+        const Configuration_t& qlevelset = *((*distrib) ()->configuration ());
+
+        Configuration_t q (qs.rows ());
+        for (size_type i = 0; i < qs.cols (); ++i) {
+          q = qs.col (i);
+          if (applyConstraintsWithOffset (qoffset, qlevelset, q)) {
+            qs.col (i) = q;
+            return i;
+          }
+        }
+        return -1;
+      }
+
       bool LevelSetEdge::applyConstraints (core::NodePtr_t n_offset, ConfigurationOut_t q) const
       {
         // First, get an offset from the histogram that is not in the same connected component.
@@ -689,6 +1086,10 @@ namespace hpp {
         // It should not be of any use and it slows down node insertion in the
         // roadmap.
         hist_ = LeafHistogram::create (f);
+        // Bound the memory of the per-leaf node lists on long runs, see
+        // LeafHistogram::nodeRetention. 0 keeps the full lists.
+        hist_->nodeRetention (g->problem ()->getParameter <size_type>
+            ("Histogram/NodeRetention", 0));
         g->insertHistogram (hist_);
       }
 
@@ -16,6 +16,9 @@
 
 #include "hpp/manipulation/graph/graph.hh"
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <hpp/util/assertion.hh>
 
 #include <hpp/manipulation/constraint-set.hh>
@@ -50,12 +53,197 @@ namespace hpp {
       void Graph::initialize ()
       {
         hists_.clear ();
+        // The error threshold or the maximal number of iterations may
+        // have changed: recompile the shared projectors. The filtered
+        // validations survive: each entry records the geometry epoch it
+        // was built at and is rebuilt lazily when the epoch is stale,
+        // so resetting the problem does not pay for re-filtering the
+        // collision pairs of every edge.
+        configProjectorPool_.clear ();
+        intersectionProjectorPool_.clear ();
         assert(components_.size() >= 1 && components_[0].lock() == wkPtr_.lock());
-        for (std::size_t i = 1; i < components_.size(); ++i)
-          components_[i].lock()->initialize();
+        const std::size_t nbThreads = (std::size_t)
+          (initializationThreads_ < 1 ? 1 : initializationThreads_);
+        if (nbThreads <= 1 || components_.size () <= 2) {
+          for (std::size_t i = 1; i < components_.size(); ++i)
+            components_[i].lock()->initialize();
+        } else {
+          // The constraint sets of the states and edges are built
+          // independently of each other; the data the constructions
+          // share - the pools and the histogram list - goes through
+          // mutex-guarded accessors. Building everything here keeps the
+          // construction latency off the sampling critical path, where
+          // it showed up as early-run outliers.
+          boost::thread_group workers;
+          std::vector <std::string> errors (nbThreads);
+          for (std::size_t rank = 0; rank < nbThreads; ++rank)
+            workers.create_thread (boost::bind
+                (&Graph::initializeWorker, this, rank, nbThreads,
+                 boost::ref (errors[rank])));
+          workers.join_all ();
+          // Rethrow the first failure only once every worker stopped.
+          for (std::size_t rank = 0; rank < nbThreads; ++rank)
+            if (!errors[rank].empty ())
+              throw std::runtime_error (errors[rank]);
+        }
+        buildEdgeTable ();
+        buildStateHopTable ();
+        buildComponentTables ();
         isInit_ = true;
       }
 
+      void Graph::initializeWorker (const std::size_t rank,
+          const std::size_t nbThreads, std::string& error)
+      {
+        for (std::size_t i = 1 + rank; i < components_.size ();
+            i += nbThreads) {
+          try {
+            components_[i].lock ()->initialize ();
+          } catch (const std::exception& e) {
+            if (error.empty ()) error = e.what ();
+          }
+        }
+      }
+
+      void Graph::buildEdgeTable ()
+      {
+        edgeTableDim_ = components_.size ();
+        edgeTable_.assign (edgeTableDim_ * edgeTableDim_, Edges_t ());
+        for (std::size_t i = 1; i < edgeTableDim_; ++i) {
+          StatePtr_t state = HPP_DYNAMIC_PTR_CAST (State,
+              components_[i].lock ());
+          if (!state) continue;
+          const Neighbors_t& neighbors = state->neighbors ();
+          for (Neighbors_t::const_iterator it = neighbors.begin ();
+              it != neighbors.end (); ++it)
+            edgeTable_[state->id () * edgeTableDim_
+              + it->second->to ()->id ()].push_back (it->second);
+        }
+      }
+
+      void Graph::buildStateHopTable ()
+      {
+        stateHopTable_.assign (edgeTableDim_ * edgeTableDim_,
+            size_type (-1));
+        std::vector <std::size_t> queue;
+        for (std::size_t from = 0; from < edgeTableDim_; ++from) {
+          size_type* dist = &stateHopTable_[from * edgeTableDim_];
+          dist[from] = 0;
+          queue.clear ();
+          queue.push_back (from);
+          for (std::size_t head = 0; head < queue.size (); ++head) {
+            const std::size_t u = queue[head];
+            const Edges_t* row = &edgeTable_[u * edgeTableDim_];
+            for (std::size_t v = 0; v < edgeTableDim_; ++v) {
+              if (row[v].empty () || dist[v] >= 0) continue;
+              dist[v] = dist[u] + 1;
+              queue.push_back (v);
+            }
+          }
+        }
+      }
+
+      void Graph::buildComponentTables ()
+      {
+        const std::size_t dim = components_.size ();
+        stateByIndex_.assign (dim, (State*) NULL);
+        edgeByIndex_.assign (dim, (Edge*) NULL);
+        edgeInfos_.assign (dim, EdgeInfo_t ());
+        for (std::size_t i = 1; i < dim; ++i) {
+          GraphComponentPtr_t c = components_[i].lock ();
+          StatePtr_t state = HPP_DYNAMIC_PTR_CAST (State, c);
+          if (state) {
+            stateByIndex_[i] = state.get ();
+            continue;
+          }
+          EdgePtr_t edge = HPP_DYNAMIC_PTR_CAST (Edge, c);
+          if (!edge) continue;
+          edgeByIndex_[i] = edge.get ();
+          EdgeInfo_t& info = edgeInfos_[i];
+          info.edge = edge.get ();
+          info.fromId = edge->from ()->id ();
+          info.toId = edge->to ()->id ();
+          info.stateId = edge->state ()->id ();
+          info.isShort = edge->isShort_;
+        }
+        // The selection weights live in the neighbor lists of the source
+        // states: scatter them into the contiguous metadata.
+        for (std::size_t i = 1; i < dim; ++i) {
+          if (!stateByIndex_[i]) continue;
+          const Neighbors_t& neighbors = stateByIndex_[i]->neighbors ();
+          for (Neighbors_t::const_iterator it = neighbors.begin ();
+              it != neighbors.end (); ++it) {
+            const std::size_t id = it->second->id ();
+            if (id < dim) edgeInfos_[id].weight = it->first;
+          }
+        }
+      }
+
+      size_type Graph::stateHops (const StatePtr_t& from, const StatePtr_t& to)
+        const
+      {
+        if (from->id () >= edgeTableDim_ || to->id () >= edgeTableDim_)
+          return -1;
+        return stateHopTable_[from->id () * edgeTableDim_ + to->id ()];
+      }
+
+      ConfigProjectorPtr_t Graph::sharedConfigProjector
+      (const std::string& signature) const
+      {
+        boost::mutex::scoped_lock lock (sharedDataMutex_);
+        ConfigProjectorPool_t::const_iterator it =
+          configProjectorPool_.find (signature);
+        if (it == configProjectorPool_.end ()) return ConfigProjectorPtr_t ();
+        return it->second;
+      }
+
+      void Graph::addSharedConfigProjector (const std::string& signature,
+          const ConfigProjectorPtr_t& projector)
+      {
+        boost::mutex::scoped_lock lock (sharedDataMutex_);
+        configProjectorPool_[signature] = projector;
+      }
+
+      const Graph::FilteredValidation_t* Graph::sharedFilteredValidation
+      (const std::string& signature, const std::size_t& geometryEpoch) const
+      {
+        boost::mutex::scoped_lock lock (sharedDataMutex_);
+        FilteredValidationPool_t::const_iterator it =
+          filteredValidationPool_.find (signature);
+        if (it == filteredValidationPool_.end ()) return NULL;
+        // An entry built with a different obstacle set is stale: the
+        // caller rebuilds and re-registers it.
+        if (it->second.geometryEpoch != geometryEpoch) return NULL;
+        return &it->second;
+      }
+
+      const Graph::FilteredValidation_t& Graph::addSharedFilteredValidation
+      (const std::string& signature, const FilteredValidation_t& data)
+      {
+        boost::mutex::scoped_lock lock (sharedDataMutex_);
+        return filteredValidationPool_[signature] = data;
+      }
+
+      ConfigProjectorPtr_t Graph::sharedIntersectionProjector
+      (const EdgePtr_t& edgeB, const EdgePtr_t& edgeA) const
+      {
+        boost::mutex::scoped_lock lock (sharedDataMutex_);
+        IntersectionProjectorPool_t::const_iterator it =
+          intersectionProjectorPool_.find
+          (std::make_pair (edgeB->id (), edgeA->id ()));
+        if (it == intersectionProjectorPool_.end ())
+          return ConfigProjectorPtr_t ();
+        return it->second;
+      }
+
+      void Graph::addSharedIntersectionProjector (const EdgePtr_t& edgeB,
+          const EdgePtr_t& edgeA, const ConfigProjectorPtr_t& projector)
+      {
+        boost::mutex::scoped_lock lock (sharedDataMutex_);
+        intersectionProjectorPool_[std::make_pair (edgeB->id (),
+            edgeA->id ())] = projector;
+      }
+
       StateSelectorPtr_t Graph::createNodeSelector (const std::string& name)
       {
         return createStateSelector (name);
@@ -136,6 +324,10 @@ namespace hpp {
       Edges_t Graph::getEdges (const StatePtr_t& from, const StatePtr_t& to)
 	const
       {
+        if (from->id () < edgeTableDim_ && to->id () < edgeTableDim_)
+          return edgeTable_[statePairId (from, to)];
+        // Fall back on scanning the neighbors when the lookup table has
+        // not been built yet.
         Edges_t edges;
         for (Neighbors_t::const_iterator it = from->neighbors ().begin ();
             it != from->neighbors ().end (); ++it) {
@@ -145,6 +337,19 @@ namespace hpp {
         return edges;
       }
 
+      std::size_t Graph::statePairId (const StatePtr_t& from,
+          const StatePtr_t& to) const
+      {
+        assert (from->id () < edgeTableDim_ && to->id () < edgeTableDim_);
+        return from->id () * edgeTableDim_ + to->id ();
+      }
+
+      const Edges_t& Graph::getEdges (const std::size_t& statePairId) const
+      {
+        assert (statePairId < edgeTable_.size ());
+        return edgeTable_[statePairId];
+      }
+
       EdgePtr_t Graph::chooseEdge (RoadmapNodePtr_t from) const
       {
         return stateSelector_->chooseEdge (from);
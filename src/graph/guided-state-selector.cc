@@ -17,6 +17,7 @@
 #include "hpp/manipulation/graph/guided-state-selector.hh"
 
 #include <hpp/util/assertion.hh>
+#include <hpp/util/pointer.hh>
 #include <hpp/pinocchio/configuration.hh>
 #include <hpp/core/steering-method.hh>
 
@@ -52,26 +53,55 @@ namespace hpp {
       EdgePtr_t GuidedStateSelector::chooseEdge(RoadmapNodePtr_t from) const
       {
         if (stateList_.empty ()) return StateSelector::chooseEdge (from);
+        // The guidance A* answer for a node only changes when the
+        // roadmap does: drop the cache when the roadmap revision moved,
+        // then look the state sequence up before running a search.
+        const RoadmapPtr_t rdm = HPP_DYNAMIC_PTR_CAST (Roadmap, roadmap_);
         Astar::States_t list;
         bool reverse = false;
-        if (from->connectedComponent () == roadmap_->initNode ()->connectedComponent ()) {
-          Astar alg (roadmap_->distance (), wkPtr_.lock(), static_cast <RoadmapNodePtr_t> (roadmap_->initNode ()));
-          list = alg.solution (from);
-        } else {
-          core::NodeVector_t::const_iterator itg = roadmap_->goalNodes ().begin ();
-          for (; itg != roadmap_->goalNodes ().end (); ++itg)
-            if ((*itg)->connectedComponent () == from->connectedComponent ())
-              break;
-          if (itg == roadmap_->goalNodes ().end ()) {
-            hppDout (error, "This configuration can reach neither the initial "
-                "configuration nor any of the goal configurations.");
-            return EdgePtr_t ();
+        bool cached = false;
+        {
+          // Workers choose edges concurrently: the cache is guarded,
+          // the searches below are not. Two workers may compute the
+          // same guide redundantly, never corrupt the cache.
+          boost::mutex::scoped_lock lock (guideCacheMutex_);
+          if (rdm && guideCacheRevision_ != rdm->revision ()) {
+            guideCache_.clear ();
+            guideCacheRevision_ = rdm->revision ();
+          }
+          GuideCache_t::const_iterator itCache = guideCache_.find (from);
+          if (itCache != guideCache_.end ()) {
+            list = itCache->second.states;
+            reverse = itCache->second.reverse;
+            cached = true;
+          }
+        }
+        if (!cached) {
+          if (from->connectedComponent () == roadmap_->initNode ()->connectedComponent ()) {
+            Astar alg (roadmap_->distance (), wkPtr_.lock(), static_cast <RoadmapNodePtr_t> (roadmap_->initNode ()));
+            list = alg.solution (from);
+          } else {
+            core::NodeVector_t::const_iterator itg = roadmap_->goalNodes ().begin ();
+            for (; itg != roadmap_->goalNodes ().end (); ++itg)
+              if ((*itg)->connectedComponent () == from->connectedComponent ())
+                break;
+            if (itg == roadmap_->goalNodes ().end ()) {
+              hppDout (error, "This configuration can reach neither the initial "
+                  "configuration nor any of the goal configurations.");
+              return EdgePtr_t ();
+            }
+            reverse = true;
+            Astar alg (roadmap_->distance (), wkPtr_.lock(), from);
+            list = alg.solution (static_cast <RoadmapNodePtr_t> (*itg));
+          }
+          list.erase (std::unique (list.begin(), list.end ()), list.end ());
+          if (rdm) {
+            boost::mutex::scoped_lock lock (guideCacheMutex_);
+            CachedGuide_t& entry = guideCache_[from];
+            entry.states = list;
+            entry.reverse = reverse;
           }
-          reverse = true;
-          Astar alg (roadmap_->distance (), wkPtr_.lock(), from);
-          list = alg.solution (static_cast <RoadmapNodePtr_t> (*itg));
         }
-        list.erase (std::unique (list.begin(), list.end ()), list.end ());
         // Check if the beginning of stateList is list
         if (list.size() <= stateList_.size()) {
           Neighbors_t nn;
@@ -89,17 +119,16 @@ namespace hpp {
             } while (++it2 != itEnd2);
             StatePtr_t state = getState (from);
             HPP_ASSERT (state == list.front ());
-            const Neighbors_t& n = state->neighbors();
+            const std::vector <EdgePtr_t>& es = state->neighborEdges ();
+            const vector_t& ws = state->neighborWeights ();
+            const std::vector <std::size_t>& ids = state->neighborStateIds ();
             /// You stay in the same state
-            for (Neighbors_t::const_iterator it = n.begin (); it != n.end (); ++it)
-              if (it->second->to () == state)
-                nn.insert (it->second, it->first);
             /// Go from state it1 to state
             // The path will be build from state. So we must find an edge from
-            // state to it1, that will be reversely 
-            for (Neighbors_t::const_iterator it = n.begin (); it != n.end (); ++it)
-              if (it->second->to () == *it1)
-                nn.insert (it->second, it->first);
+            // state to it1, that will be reversely
+            for (std::size_t i = 0; i < es.size (); ++i)
+              if (ids[i] == state->id () || ids[i] == (*it1)->id ())
+                nn.insert (es[i], (Weight_t) ws[(size_type) i]);
           } else {
             States_t::const_iterator it1 = stateList_.begin ();
             Astar::States_t::const_iterator it2 = list.begin();
@@ -114,12 +143,14 @@ namespace hpp {
             } while (++it2 != itEnd2);
             StatePtr_t state = getState (from);
             HPP_ASSERT (state == list.back ());
-            const Neighbors_t& n = state->neighbors();
-            for (Neighbors_t::const_iterator it = n.begin (); it != n.end (); ++it)
+            const std::vector <EdgePtr_t>& es = state->neighborEdges ();
+            const vector_t& ws = state->neighborWeights ();
+            const std::vector <std::size_t>& ids = state->neighborStateIds ();
+            for (std::size_t i = 0; i < es.size (); ++i)
               /// You stay in the same state
-              /// or go from state to state it1 
-              if (it->second->to () == state || it->second->to () == *it1)
-                nn.insert (it->second, it->first);
+              /// or go from state to state it1
+              if (ids[i] == state->id () || ids[i] == (*it1)->id ())
+                nn.insert (es[i], (Weight_t) ws[(size_type) i]);
           }
           if (nn.size () > 0 && nn.totalWeight() > 0)
             return nn ();
@@ -16,6 +16,8 @@
 
 #include <hpp/manipulation/graph/helper.hh>
 
+#include <map>
+#include <sstream>
 #include <tr1/unordered_map>
 #include <tr1/unordered_set>
 
@@ -23,6 +25,8 @@
 #include <boost/regex.hpp>
 #include <boost/foreach.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <pinocchio/multibody/model.hpp>
 
@@ -34,6 +38,7 @@
 #include <hpp/constraints/differentiable-function.hh>
 
 #include <hpp/manipulation/handle.hh>
+#include <hpp/manipulation/problem.hh>
 #include <hpp/manipulation/graph/state.hh>
 #include <hpp/manipulation/graph/edge.hh>
 #include <hpp/manipulation/graph/state-selector.hh>
@@ -457,21 +462,23 @@ namespace hpp {
             const GripperPtr_t& gripper, const HandlePtr_t& handle,
             FoliatedManifold& grasp, FoliatedManifold& pregrasp)
         {
-          NumericalConstraintPtr_t gc  = handle->createGrasp (gripper, "");
+          // Grasp constraints are memoized per (gripper, handle) pair:
+          // the instances are shared with every other site building
+          // them.
+          NumericalConstraintPtr_t gc  = handle->grasp (gripper);
           grasp.nc.nc.push_back (gc);
           grasp.nc.pdof.push_back (segments_t ());
           grasp.nc_path.nc.push_back (gc);
           // TODO: see function declaration
           grasp.nc_path.pdof.push_back (segments_t ());
-          NumericalConstraintPtr_t gcc = handle->createGraspComplement
-            (gripper, "");
+          NumericalConstraintPtr_t gcc = handle->graspComplement (gripper);
           if (gcc->function ().outputSize () > 0) {
             grasp.nc_fol.nc.push_back (gcc);
             grasp.nc_fol.pdof.push_back (segments_t());
           }
 
           const value_type c = handle->clearance () + gripper->clearance ();
-          NumericalConstraintPtr_t pgc = handle->createPreGrasp (gripper, c, "");
+          NumericalConstraintPtr_t pgc = handle->pregrasp (gripper, c);
           pregrasp.nc.nc.push_back (pgc);
           pregrasp.nc.pdof.push_back (segments_t());
           pregrasp.nc_path.nc.push_back (pgc);
@@ -1010,6 +1017,77 @@ namespace hpp {
           }
         }
 
+        namespace {
+          /// Grasp constraints of one (gripper, handle) pair built by a
+          /// prefabrication worker, registered sequentially afterwards.
+          struct PrebuiltGrasp {
+            NumericalConstraintPtr_t grasp, complement, both, pregrasp;
+          };
+
+          void prebuildGraspConstraintsWorker (Result& r,
+              std::vector <PrebuiltGrasp>& prebuilt,
+              const std::size_t rank, const std::size_t nbThreads)
+          {
+            typedef core::ProblemSolver CPS_t;
+            for (std::size_t p = rank; p < prebuilt.size (); p += nbThreads) {
+              const GripperPtr_t& g (r.gs[p / r.nOH]);
+              const HandlePtr_t& h (r.handle (p % r.nOH));
+              const std::string name = g->name() + " grasps " + h->name();
+              // Reads of the named store are safe: nothing writes to it
+              // during this phase.
+              if (r.ps->CPS_t::has<NumericalConstraintPtr_t>(name)) continue;
+              PrebuiltGrasp& pg = prebuilt[p];
+              pg.grasp      = h->grasp (g);
+              pg.complement = h->graspComplement (g);
+              pg.both       = h->graspAndComplement (g);
+              pg.pregrasp   = h->pregrasp (g,
+                  h->clearance () + g->clearance ());
+            }
+          }
+
+          /// Build the grasp constraints of every (gripper, handle) pair
+          /// over a thread pool, then register them in pair order so
+          /// that names and ids stay deterministic. The sequential graph
+          /// construction that follows finds them ready in
+          /// Result::graspCs.
+          void prebuildGraspConstraints (Result& r, const size_type nbThreads)
+          {
+            std::vector <PrebuiltGrasp> prebuilt (r.nG * r.nOH);
+            boost::thread_group workers;
+            for (std::size_t rank = 0; rank < (std::size_t) nbThreads; ++rank)
+              workers.create_thread (boost::bind
+                  (prebuildGraspConstraintsWorker, boost::ref (r),
+                   boost::ref (prebuilt), rank, (std::size_t) nbThreads));
+            workers.join_all ();
+
+            typedef core::ProblemSolver CPS_t;
+            for (std::size_t p = 0; p < prebuilt.size (); ++p) {
+              const PrebuiltGrasp& pg = prebuilt[p];
+              boost::array<NumericalConstraintPtr_t,3>& gcs = r.graspCs[p];
+              const GripperPtr_t& g (r.gs[p / r.nOH]);
+              const HandlePtr_t& h (r.handle (p % r.nOH));
+              const std::string name = g->name() + " grasps " + h->name();
+              if (!pg.grasp) {
+                // Registered by a previous build: fetch it.
+                if (r.ps->CPS_t::has<NumericalConstraintPtr_t>(name)) {
+                  gcs[0] = r.ps->CPS_t::get<NumericalConstraintPtr_t>(name);
+                  gcs[1] = r.ps->CPS_t::get<NumericalConstraintPtr_t>(name + "/complement");
+                  gcs[2] = r.ps->CPS_t::get<NumericalConstraintPtr_t>(g->name() + " pregrasps " + h->name());
+                }
+                continue;
+              }
+              r.ps->addNumericalConstraint (name, pg.grasp);
+              r.ps->addNumericalConstraint (name + "/complement", pg.complement);
+              r.ps->addNumericalConstraint (name + "/hold", pg.both);
+              r.graph->registerConstraints (pg.grasp, pg.complement, pg.both);
+              r.ps->addNumericalConstraint (g->name() + " pregrasps " + h->name(), pg.pregrasp);
+              gcs[0] = pg.grasp;
+              gcs[1] = pg.complement;
+              gcs[2] = pg.pregrasp;
+            }
+          }
+        }
+
         void graphBuilder (
             const ProblemSolverPtr_t& ps,
             const Objects_t& objects,
@@ -1024,6 +1102,18 @@ namespace hpp {
           Result r (ps, grippers, objects, graph);
           r.setRules (rules);
 
+          // Opt-in parallel prefabrication of the per-pair grasp
+          // constraints, the dominant cost of the construction. The
+          // graph itself is still built sequentially below, so component
+          // ids remain deterministic. Pairs excluded by the rules are
+          // prefabricated too, which trades some extra work for the
+          // parallelism.
+          const size_type nbThreads = ps->problem ()
+            ? ps->problem ()->getParameter<size_type>
+              ("GraphBuilder/NumberOfThreads", 1)
+            : 1;
+          if (nbThreads > 1) prebuildGraspConstraints (r, nbThreads);
+
           IndexV_t availG (r.nG), availOH (r.nOH);
           for (index_t i = 0; i < r.nG; ++i) availG[i] = i;
           for (index_t i = 0; i < r.nOH; ++i) availOH[i] = i;
@@ -1036,6 +1126,54 @@ namespace hpp {
               "and " << r.edges.size() << " edges.");
         }
 
+        namespace {
+          /// In-process compiled-graph cache. The graph is fully
+          /// determined by the builder inputs and the robot, so when
+          /// graphBuilder is called again with the same inputs - which
+          /// happens each time a client script re-runs its setup on a
+          /// living server - the graph built the first time is returned
+          /// instead of re-running the combinatorial construction.
+          struct BuiltGraph {
+            core::DevicePtr_t robot;
+            core::RoadmapPtr_t roadmap;
+            GraphPtr_t graph;
+          };
+          typedef std::map <std::string, BuiltGraph> GraphCache_t;
+          GraphCache_t builtGraphs;
+
+          std::string builderFingerprint (
+              const std::string& graphName,
+              const StringList_t& griNames,
+              const std::list <ObjectDef_t>& objs,
+              const StringList_t& envNames,
+              const std::vector <Rule>& rules,
+              const value_type& prePlaceWidth)
+          {
+            std::ostringstream oss;
+            oss << graphName << '\n' << prePlaceWidth << '\n';
+            BOOST_FOREACH (const std::string& gn, griNames)
+              oss << "g:" << gn << '\n';
+            BOOST_FOREACH (const ObjectDef_t& od, objs) {
+              oss << "o:" << od.name << '\n';
+              BOOST_FOREACH (const std::string& hn, od.handles)
+                oss << "h:" << hn << '\n';
+              BOOST_FOREACH (const std::string& sn, od.shapes)
+                oss << "s:" << sn << '\n';
+            }
+            BOOST_FOREACH (const std::string& en, envNames)
+              oss << "e:" << en << '\n';
+            BOOST_FOREACH (const Rule& r, rules) {
+              oss << "r:" << (r.link_ ? 1 : 0);
+              BOOST_FOREACH (const std::string& gn, r.grippers_)
+                oss << ' ' << gn;
+              BOOST_FOREACH (const std::string& hn, r.handles_)
+                oss << ' ' << hn;
+              oss << '\n';
+            }
+            return oss.str ();
+          }
+        }
+
         GraphPtr_t graphBuilder (
             const ProblemSolverPtr_t& ps,
             const std::string& graphName,
@@ -1045,12 +1183,29 @@ namespace hpp {
 	    const std::vector <Rule>& rules,
             const value_type& prePlaceWidth)
         {
+          // The cache entry is valid only while the robot and the roadmap
+          // are the ones the graph was built for: the constraints are
+          // bound to the robot model and the state selector keeps a
+          // pointer to the roadmap.
+          const std::string fingerprint = builderFingerprint
+            (graphName, griNames, objs, envNames, rules, prePlaceWidth);
+          GraphCache_t::iterator _cache = builtGraphs.find (fingerprint);
+          if (_cache != builtGraphs.end ()) {
+            if (_cache->second.robot == ps->robot ()
+                && _cache->second.roadmap == ps->roadmap ()) {
+              hppDout (info, "Reusing the constraint graph built for these"
+                  " inputs.");
+              ps->constraintGraph (_cache->second.graph);
+              return _cache->second.graph;
+            }
+            builtGraphs.erase (_cache);
+          }
           const Device& robot = *(ps->robot ());
           const pinocchio::Model& model = robot.model();
           Grippers_t grippers (griNames.size());
           index_t i = 0;
           BOOST_FOREACH (const std::string& gn, griNames) {
-            grippers[i] = robot.get <GripperPtr_t> (gn);
+            grippers[i] = robot.gripper (robot.gripperId (gn));
             ++i;
           }
           Objects_t objects (objs.size());
@@ -1063,7 +1218,7 @@ namespace hpp {
             objects[i].get<1> ().resize (od.handles.size());
             Handles_t::iterator it = objects[i].get<1> ().begin();
             BOOST_FOREACH (const std::string hn, od.handles) {
-              *it = robot.get <HandlePtr_t> (hn);
+              *it = robot.handle (robot.handleId (hn));
               ++it;
             }
             // Create placement
@@ -1099,7 +1254,8 @@ namespace hpp {
 	    // Loop over all frames of object, detect joint and create locked
 	    // joint.
             assert (robot.has <FrameIndices_t> (od.name));
-            BOOST_FOREACH (const se3::FrameIndex& f, robot.get<FrameIndices_t> (od.name)) {
+            BOOST_FOREACH (const se3::FrameIndex& f,
+                robot.frameIndices (robot.frameIndicesId (od.name))) {
               if (model.frames[f].type != se3::JOINT) continue;
               const JointIndex j = model.frames[f].parent;
               JointPtr_t oj (new Joint (ps->robot(), j));
@@ -1123,6 +1279,12 @@ namespace hpp {
 
           graphBuilder (ps, objects, grippers, graph, rules);
           ps->constraintGraph (graph);
+
+          BuiltGraph built;
+          built.robot = ps->robot ();
+          built.roadmap = ps->roadmap ();
+          built.graph = graph;
+          builtGraphs[fingerprint] = built;
           return graph;
         }
       } // namespace helper
@@ -76,7 +76,11 @@ namespace hpp {
       {
         for (WeighedStates_t::const_iterator it = orderedStates_.begin();
 	     orderedStates_.end() != it; ++it) {
-          if (it->second->contains(config))
+          // Most candidates are rejected by their discriminating
+          // constraints alone; the constraints shared by the whole graph
+          // are then evaluated only for the states passing that test.
+          if (it->second->maybeContains(config) &&
+              it->second->contains(config))
             return it->second;
 	}
 	std::stringstream oss;
@@ -107,11 +111,9 @@ namespace hpp {
       EdgePtr_t StateSelector::chooseEdge(RoadmapNodePtr_t from) const
       {
         StatePtr_t state = getState (from);
-        const Neighbors_t neighborPicker = state->neighbors();
-        if (neighborPicker.totalWeight () == 0) {
-          return EdgePtr_t ();
-        }
-        return neighborPicker ();
+        // O(1) alias sampling; returns an empty pointer when the total
+        // weight is 0, as the distribution based code did.
+        return state->sampleNeighbor ();
       }
 
       std::ostream& StateSelector::dotPrint (std::ostream& os, dot::DrawingAttributes) const
@@ -16,6 +16,8 @@
 
 #include "hpp/manipulation/graph/state.hh"
 
+#include <cstdlib>
+
 #include <hpp/constraints/differentiable-function.hh>
 
 #include "hpp/manipulation/device.hh"
@@ -27,7 +29,8 @@ namespace hpp {
   namespace manipulation {
     namespace graph {
       State::State (const std::string& name) :
-	GraphComponent (name), configConstraints_ (),
+	GraphComponent (name), aliasDirty_ (true), neighborsDirty_ (true),
+        configConstraints_ (),
         isWaypoint_ (false)
       {}
 
@@ -52,16 +55,109 @@ namespace hpp {
 			     const size_type& w, EdgeFactory create)
       {
         EdgePtr_t newEdge = create(name, graph_, wkPtr_, to);
-        if (w >= 0) neighbors_.insert (newEdge, (Weight_t)w);
+        if (w >= 0) {
+          neighbors_.insert (newEdge, (Weight_t)w);
+          neighborsDirty_ = true;
+          aliasDirty_ = true;
+        }
         else hiddenNeighbors_.push_back (newEdge);
         return newEdge;
       }
 
+      void State::buildNeighborTables () const
+      {
+        // Double-checked: callers test the dirty flag without the lock,
+        // the losers of a rebuild race serialize here and find the flag
+        // already cleared.
+        boost::mutex::scoped_lock lock (tablesMutex_);
+        fillNeighborTables ();
+      }
+
+      void State::fillNeighborTables () const
+      {
+        // tablesMutex_ must be held.
+        if (!neighborsDirty_) return;
+        // Flatten the distribution into parallel arrays: the selection
+        // loops then read consecutive memory instead of dereferencing
+        // the distribution pairs for each neighbor.
+        const std::size_t n = neighbors_.size ();
+        neighborEdges_.clear (); neighborEdges_.reserve (n);
+        neighborStateIds_.clear (); neighborStateIds_.reserve (n);
+        neighborWeights_.resize ((size_type) n);
+        size_type i = 0;
+        for (Neighbors_t::const_iterator it = neighbors_.begin ();
+            it != neighbors_.end (); ++it, ++i) {
+          neighborEdges_.push_back (it->second);
+          neighborWeights_[i] = (value_type) it->first;
+          neighborStateIds_.push_back (it->second->to ()->id ());
+        }
+        neighborsDirty_ = false;
+      }
+
+      void State::buildAliasTable () const
+      {
+        // Walker's alias method: each entry i holds the probability of
+        // keeping edge i when i is drawn uniformly, and the edge to
+        // return otherwise. Construction is O(n), sampling O(1).
+        // Double-checked as in buildNeighborTables; the flag is cleared
+        // only once the table is fully built.
+        boost::mutex::scoped_lock lock (tablesMutex_);
+        if (!aliasDirty_) return;
+        fillNeighborTables ();
+        const std::size_t n = neighborEdges_.size ();
+        const value_type total = neighborWeights_.sum ();
+        aliasEdges_.clear ();
+        aliasProbabilities_.assign (n, 1);
+        aliases_.assign (n, 0);
+        if (n == 0 || total == 0) {
+          aliasDirty_ = false;
+          return;
+        }
+        aliasEdges_ = neighborEdges_;
+        const value_type scale = (value_type) n / total;
+        std::vector <value_type> scaled; scaled.reserve (n);
+        for (std::size_t i = 0; i < n; ++i)
+          scaled.push_back (neighborWeights_[(size_type) i] * scale);
+        std::vector <std::size_t> small, large;
+        for (std::size_t i = 0; i < n; ++i)
+          (scaled[i] < 1 ? small : large).push_back (i);
+        while (!small.empty () && !large.empty ()) {
+          const std::size_t s = small.back (); small.pop_back ();
+          const std::size_t l = large.back ();
+          aliasProbabilities_[s] = scaled[s];
+          aliases_[s] = l;
+          scaled[l] -= (1 - scaled[s]);
+          if (scaled[l] < 1) {
+            large.pop_back ();
+            small.push_back (l);
+          }
+        }
+        // Entries left in either list have probability 1 up to rounding.
+        aliasDirty_ = false;
+      }
+
+      EdgePtr_t State::sampleNeighbor () const
+      {
+        if (aliasDirty_) buildAliasTable ();
+        const std::size_t n = aliasEdges_.size ();
+        if (n == 0) return EdgePtr_t ();
+        const std::size_t i = (std::size_t) rand () % n;
+        const value_type u = (value_type) rand () / (value_type) RAND_MAX;
+        return (u <= aliasProbabilities_[i]) ? aliasEdges_[i]
+                                             : aliasEdges_[aliases_[i]];
+      }
+
       bool State::contains (ConfigurationIn_t config) const
       {
         return configConstraint()->isSatisfied (config);
       }
 
+      bool State::maybeContains (ConfigurationIn_t config) const
+      {
+        if (!discriminatingConstraints_) return true;
+        return discriminatingConstraints_->isSatisfied (config);
+      }
+
       std::ostream& State::dotPrint (std::ostream& os, dot::DrawingAttributes da) const
       {
         da.insertWithQuote ("label", name ());
@@ -72,14 +168,15 @@ namespace hpp {
         os << id () << " " << da << ";" << std::endl;
 
         dot::DrawingAttributes dac;
-        std::vector <double> p = neighbors_.probabilities ();
-        size_t i = 0;
-        for (Neighbors_t::const_iterator it = neighbors_.begin();
-            it != neighbors_.end(); ++it) {
-          std::ostringstream oss; oss << (p[i] * 3 + 0.5);
+        const std::vector <EdgePtr_t>& edges = neighborEdges ();
+        const vector_t& weights = neighborWeights ();
+        const value_type total = weights.sum ();
+        for (std::size_t i = 0; i < edges.size (); ++i) {
+          const value_type p =
+            (total > 0) ? weights[(size_type) i] / total : 0;
+          std::ostringstream oss; oss << (p * 3 + 0.5);
           dac ["penwidth"] = oss.str ();
-          i++;
-          it->second->dotPrint (os, dac) << std::endl;
+          edges[i]->dotPrint (os, dac) << std::endl;
         }
         return os;
       }
@@ -99,9 +196,11 @@ namespace hpp {
       {
         os << "|   |-- ";
         GraphComponent::print (os) << std::endl;
-        for (Neighbors_t::const_iterator it = neighbors_.begin();
-            it != neighbors_.end(); ++it)
-          os << *(it->second) << " - " << it->first << std::endl;
+        const std::vector <EdgePtr_t>& edges = neighborEdges ();
+        const vector_t& weights = neighborWeights ();
+        for (std::size_t i = 0; i < edges.size (); ++i)
+          os << *(edges[i]) << " - " << (Weight_t) weights[(size_type) i]
+             << std::endl;
         return os;
       }
 
@@ -120,6 +219,17 @@ namespace hpp {
 
         g->insertLockedJoints (proj);
         insertLockedJoints (proj);
+
+        // Constraint set with only the state specific part of the
+        // constraints above, for maybeContains.
+        discriminatingConstraints_ = ConstraintSet::create
+          (g->robot (), "Discriminating set " + n);
+        ConfigProjectorPtr_t discrProj = ConfigProjector::create (g->robot (),
+            "discriminating proj " + n, g->errorThreshold (),
+            g->maxIterations ());
+        insertNumericalConstraints (discrProj);
+        discriminatingConstraints_->addConstraint (discrProj);
+        insertLockedJoints (discrProj);
       }
 
       void State::updateWeight (const EdgePtr_t& e, const Weight_t& w)
@@ -129,6 +239,8 @@ namespace hpp {
           if (it->second == e) {
             /// Update the weights
             neighbors_.insert (e, w);
+            neighborsDirty_ = true;
+            aliasDirty_ = true;
           }
         }
         hppDout (error, "Edge not found");
@@ -16,22 +16,72 @@
 
 #include "hpp/manipulation/graph/statistics.hh"
 
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+
+#include <boost/functional/hash.hpp>
+
 #include "hpp/manipulation/constraint-set.hh"
 
 namespace hpp {
   namespace manipulation {
     namespace graph {
-      LeafBin::LeafBin(const vector_t& v, value_type* thr):
-        value_(v), nodes_(), thr_ (thr)
+      namespace {
+        /// Hash of the parameter vector quantized with the bin
+        /// threshold. Values closer than the threshold may fall in
+        /// adjacent cells and thus in distinct bins, which is an
+        /// acceptable approximation of the element-wise compare.
+        std::size_t quantizedHash (const vector_t& v, const value_type thr)
+        {
+          std::size_t seed = 0;
+          if (thr > 0)
+            for (vector_t::Index p = 0; p < v.size (); ++p)
+              boost::hash_combine (seed, (long)std::floor (v[p] / thr));
+          else
+            for (vector_t::Index p = 0; p < v.size (); ++p)
+              boost::hash_combine (seed, v[p]);
+          return seed;
+        }
+
+        /// Apply the retention policy of the owning histogram to an
+        /// observed node, see LeafHistogram::nodeRetention.
+        void retainNode (std::list <RoadmapNodePtr_t>& nodes,
+            const RoadmapNodePtr_t& n, const size_type retention,
+            const std::size_t seen)
+        {
+          if (retention < 0) return; // count-only
+          if (retention == 0 || nodes.size () < (std::size_t) retention) {
+            nodes.push_back (n);
+            return;
+          }
+          // Reservoir sampling (algorithm R): replace a random element
+          // with probability retention / seen, which keeps the list a
+          // uniform sample of every node added to the bin.
+          const std::size_t j = (std::size_t) rand () % seen;
+          if (j < (std::size_t) retention) {
+            std::list <RoadmapNodePtr_t>::iterator it = nodes.begin ();
+            std::advance (it, (long) j);
+            *it = n;
+          }
+        }
+      }
+
+      LeafBin::LeafBin(const vector_t& v, value_type* thr,
+          const size_type* retention):
+        value_(v), nodes_(), thr_ (thr), retention_ (retention), seen_ (0),
+        hash_ (quantizedHash (v, *thr))
       {}
 
       void LeafBin::push_back(const RoadmapNodePtr_t& n)
       {
-        nodes_.push_back(n);
+        ++seen_;
+        retainNode (nodes_, n, *retention_, seen_);
       }
 
       bool LeafBin::operator<(const LeafBin& rhs) const
       {
+        if (hash_ != rhs.hash_) return hash_ < rhs.hash_;
         const vector_t& v = rhs.value ();
         assert (value_.size() == v.size());
         for (int p = 0; p < value_.size(); p++) {
@@ -43,6 +93,7 @@ namespace hpp {
 
       bool LeafBin::operator==(const LeafBin& rhs) const
       {
+        if (hash_ != rhs.hash_) return false;
         const vector_t& v = rhs.value ();
         assert (value_.size() == v.size());
         for (int p = 0; p < value_.size(); p++) {
@@ -98,13 +149,14 @@ namespace hpp {
         return os;
       }
 
-      NodeBin::NodeBin(const StatePtr_t& n):
-        state_(n), roadmapNodes_()
+      NodeBin::NodeBin(const StatePtr_t& n, const size_type* retention):
+        state_(n), roadmapNodes_(), retention_ (retention), seen_ (0)
       {}
 
       void NodeBin::push_back(const RoadmapNodePtr_t& n)
       {
-        roadmapNodes_.push_back(n);
+        ++seen_;
+        retainNode (roadmapNodes_, n, *retention_, seen_);
       }
 
       bool NodeBin::operator<(const NodeBin& rhs) const
@@ -155,33 +207,77 @@ namespace hpp {
         return os << "NodeBin (" << state()->name () << ")";
       }
 
+      namespace {
+        std::size_t nextHistogramId ()
+        {
+          // Histograms are created by LevelSetEdge::initialize, which
+          // Graph::initialize may run on several workers, so the
+          // counter is guarded.
+          static boost::mutex idMutex;
+          static std::size_t lastId = 0;
+          boost::mutex::scoped_lock lock (idMutex);
+          return lastId++;
+        }
+      }
+
       LeafHistogramPtr_t LeafHistogram::create (const Foliation f)
       {
         return LeafHistogramPtr_t (new LeafHistogram (f));
       }
 
       LeafHistogram::LeafHistogram (const Foliation f) :
-        f_ (f), threshold_ (0)
+        f_ (f), id_ (nextHistogramId ()), threshold_ (0), nodeRetention_ (0),
+        version_ (1), distribVersion_ (0)
       {
         ConfigProjectorPtr_t p = f_.parametrizer ()->configProjector();
         if (p) {
           if (p->rightHandSide ().size () > 0)
             threshold_ = p->errorThreshold () /
               sqrt((double)p->rightHandSide ().size ());
+          parameter_.resize (p->rightHandSide ().size ());
         }
       }
 
       void LeafHistogram::add (const RoadmapNodePtr_t& n)
       {
         if (!f_.contains (*n->configuration())) return;
-	iterator it = insert (LeafBin (f_.parameter (*n->configuration()),
-                              &threshold_));
+        boost::mutex::scoped_lock lock (mutex_);
+        // The node may have been through this foliation already - in a
+        // previous histogram generation or through the leaf database -
+        // in which case the constraint functions are not re-evaluated.
+        const vector_t* param = n->cachedParameter (id_);
+        if (!param) {
+          f_.parameter (parameter_, *n->configuration());
+          param = &n->cacheParameter (id_, parameter_);
+        }
+	iterator it = insert (LeafBin (*param, &threshold_,
+                              &nodeRetention_));
         it->push_back (n);
+        ++version_;
         if (numberOfObservations()%10 == 0) {
           hppDout (info, *this);
         }
       }
 
+      void LeafHistogram::seed (const RoadmapNodePtr_t& n,
+          const std::size_t freq)
+      {
+        if (freq == 0 || !f_.contains (*n->configuration())) return;
+        boost::mutex::scoped_lock lock (mutex_);
+        const vector_t* param = n->cachedParameter (id_);
+        if (!param) {
+          f_.parameter (parameter_, *n->configuration());
+          param = &n->cacheParameter (id_, parameter_);
+        }
+        iterator it = insert (LeafBin (*param, &threshold_,
+                              &nodeRetention_));
+        it->push_back (n);
+        // Each insertion raises the frequency of the bin by one.
+        for (std::size_t i = 1; i < freq; ++i)
+          insert (LeafBin (*param, &threshold_, &nodeRetention_));
+        ++version_;
+      }
+
       std::ostream& LeafHistogram::print (std::ostream& os) const
       {
         os << "Leaf Histogram of foliation " << f_.condition()->name() << std::endl;
@@ -190,15 +286,22 @@ namespace hpp {
 
       HistogramPtr_t LeafHistogram::clone () const
       {
-        return HistogramPtr_t (new LeafHistogram (f_));
+        LeafHistogram* ptr = new LeafHistogram (f_);
+        ptr->nodeRetention_ = nodeRetention_;
+        // Same foliation: the parameters the nodes cached under this id
+        // stay valid for the clone.
+        ptr->id_ = id_;
+        return HistogramPtr_t (ptr);
       }
 
       StateHistogram::StateHistogram (const graph::GraphPtr_t& graph) :
-        graph_ (graph) {}
+        graph_ (graph), nodeRetention_ (0) {}
 
       void StateHistogram::add (const RoadmapNodePtr_t& n)
       {
-        iterator it = insert (NodeBin (constraintGraph()->getState (n)));
+        boost::mutex::scoped_lock lock (mutex_);
+        iterator it = insert (NodeBin (constraintGraph()->getState (n),
+                              &nodeRetention_));
         it->push_back (n);
         if (numberOfObservations()%10 == 0) {
           hppDout (info, *this);
@@ -218,7 +321,9 @@ namespace hpp {
 
       HistogramPtr_t StateHistogram::clone () const
       {
-        return HistogramPtr_t (new StateHistogram (constraintGraph()));
+        StateHistogram* ptr = new StateHistogram (constraintGraph());
+        ptr->nodeRetention_ = nodeRetention_;
+        return HistogramPtr_t (ptr);
       }
 
       unsigned int LeafBin::numberOfObsOutOfConnectedComponent (const core::ConnectedComponentPtr_t& cc) const
@@ -231,11 +336,14 @@ namespace hpp {
         return count;
       }
 
-      statistics::DiscreteDistribution < RoadmapNodePtr_t > LeafHistogram::getDistribOutOfConnectedComponent (
+      LeafHistogram::NodeDistribution_t LeafHistogram::getDistribOutOfConnectedComponent (
           const core::ConnectedComponentPtr_t& cc) const
       {
-        statistics::DiscreteDistribution < RoadmapNodePtr_t > distrib;
+        NodeDistribution_t distrib;
         for (const_iterator bin = begin(); bin != end (); ++bin) {
+          // Count-only bins retain no node to sample from.
+          if (bin->nodes ().empty ())
+            continue;
           unsigned int w = bin->numberOfObsOutOfConnectedComponent (cc);
           if (w == 0)
             continue;
@@ -244,16 +352,27 @@ namespace hpp {
         return distrib;
       }
 
-      statistics::DiscreteDistribution < RoadmapNodePtr_t > LeafHistogram::getDistrib () const
+      LeafHistogram::NodeDistributionPtr_t LeafHistogram::getDistrib () const
       {
-        statistics::DiscreteDistribution < RoadmapNodePtr_t > distrib;
-        for (const_iterator bin = begin(); bin != end (); ++bin) {
-          std::size_t w = bin->freq ();
-          if (w == 0)
-            continue;
-          distrib.insert (bin->nodes ().front (), w);
+        boost::mutex::scoped_lock lock (mutex_);
+        if (!distrib_ || distribVersion_ != version_) {
+          // The histogram changed since the last query: rebuild once.
+          // A fresh snapshot is installed instead of updating the
+          // previous one, which callers may still be sampling from.
+          NodeDistributionPtr_t distrib (new NodeDistribution_t ());
+          for (const_iterator bin = begin(); bin != end (); ++bin) {
+            // Count-only bins retain no node to sample from.
+            if (bin->nodes ().empty ())
+              continue;
+            std::size_t w = bin->freq ();
+            if (w == 0)
+              continue;
+            distrib->insert (bin->nodes ().front (), w);
+          }
+          distrib_ = distrib;
+          distribVersion_ = version_;
         }
-        return distrib;
+        return distrib_;
       }
 
       const LeafBin::RoadmapNodes_t& LeafBin::nodes () const
@@ -274,6 +393,16 @@ namespace hpp {
         return parametrizer_->configProjector()->rightHandSideFromConfig (q);
       }
 
+      void Foliation::parameter (vector_t& result, ConfigurationIn_t q) const
+      {
+        if (!condition_->isSatisfied (q)) {
+          hppDout (error, "Configuration not in the foliation");
+        }
+        // Assigning into the caller's buffer reuses its storage when the
+        // sizes match.
+        result = parametrizer_->configProjector()->rightHandSideFromConfig (q);
+      }
+
       ConstraintSetPtr_t Foliation::condition () const
       {
         return condition_;
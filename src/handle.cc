@@ -88,6 +88,27 @@ namespace hpp {
       return ss.str();
     }
 
+    DifferentiableFunctionPtr_t Handle::maskedRelativeTransformation
+    (const std::string& name, const pinocchio::DevicePtr_t& robot,
+     const JointPtr_t& joint1, const JointPtr_t& joint2,
+     const Transform3f& frame1, const Transform3f& frame2,
+     const std::vector<bool>& mask)
+    {
+      assert (mask.size () == 6);
+      const bool position    = mask[0] || mask[1] || mask[2];
+      const bool orientation = mask[3] || mask[4] || mask[5];
+      if (position && !orientation)
+        return RelativePosition::create (name, robot, joint1, joint2,
+            frame1, frame2,
+            std::vector<bool> (mask.begin (), mask.begin () + 3));
+      if (orientation && !position)
+        return RelativeOrientation::create (name, robot, joint1, joint2,
+            frame1, frame2,
+            std::vector<bool> (mask.begin () + 3, mask.end ()));
+      return RelativeTransformation::create (name, robot, joint1, joint2,
+          frame1, frame2, mask);
+    }
+
     void Handle::mask (const std::vector<bool>& mask)
     {
       assert(mask.size() == 6);
@@ -100,8 +121,13 @@ namespace hpp {
         case 2: // This does not make sense.
           throw std::logic_error("It is not allowed to constrain only one rotation");
           break;
-      } 
+      }
       mask_ = mask;
+      // The memoized grasp constraints are built from the mask and
+      // keyed by gripper name only: drop them so the next lookup
+      // rebuilds against the new mask.
+      boost::mutex::scoped_lock lock (graspCacheMutex_);
+      graspCache_.clear ();
     }
 
     NumericalConstraintPtr_t Handle::createGrasp
@@ -118,7 +144,7 @@ namespace hpp {
 	   gripper->objectPositionInJoint (), localPosition())->createNumericalConstraint();
       }
       return NumericalConstraintPtr_t
-	(NumericalConstraint::create (RelativeTransformation::create
+	(NumericalConstraint::create (maskedRelativeTransformation
 				      (n,
 				       gripper->joint()->robot(),
 				       gripper->joint (), joint (),
@@ -142,7 +168,7 @@ namespace hpp {
             );
       } else {
         std::vector<bool> Cmask = complementMask(mask_);
-        RelativeTransformationPtr_t function = RelativeTransformation::create
+        DifferentiableFunctionPtr_t function = maskedRelativeTransformation
           (n,
            gripper->joint()->robot(),
            gripper->joint (), joint (),
@@ -201,13 +227,68 @@ namespace hpp {
         n = "Pregrasp_ " + maskToStr(mask_) + "_" + name ()
           + "_" + gripper->name ();
       return NumericalConstraintPtr_t
-	(NumericalConstraint::create (RelativeTransformation::create
+	(NumericalConstraint::create (maskedRelativeTransformation
 				      (n,
 				       gripper->joint()->robot(),
 				       gripper->joint (), joint (),
                                        transform, localPosition(), mask_)));
     }
 
+    NumericalConstraintPtr_t Handle::cacheLookup (const std::string& key)
+      const
+    {
+      boost::mutex::scoped_lock lock (graspCacheMutex_);
+      GraspCache_t::const_iterator it = graspCache_.find (key);
+      if (it == graspCache_.end ()) return NumericalConstraintPtr_t ();
+      return it->second;
+    }
+
+    NumericalConstraintPtr_t Handle::cacheStore (const std::string& key,
+        const NumericalConstraintPtr_t& constraint) const
+    {
+      boost::mutex::scoped_lock lock (graspCacheMutex_);
+      return graspCache_.insert (std::make_pair (key, constraint))
+        .first->second;
+    }
+
+    NumericalConstraintPtr_t Handle::grasp (const GripperPtr_t& gripper)
+      const
+    {
+      const std::string key = gripper->name () + "/grasp";
+      NumericalConstraintPtr_t c = cacheLookup (key);
+      if (!c) c = cacheStore (key, createGrasp (gripper, ""));
+      return c;
+    }
+
+    NumericalConstraintPtr_t Handle::graspComplement
+    (const GripperPtr_t& gripper) const
+    {
+      const std::string key = gripper->name () + "/complement";
+      NumericalConstraintPtr_t c = cacheLookup (key);
+      if (!c) c = cacheStore (key, createGraspComplement (gripper, ""));
+      return c;
+    }
+
+    NumericalConstraintPtr_t Handle::graspAndComplement
+    (const GripperPtr_t& gripper) const
+    {
+      const std::string key = gripper->name () + "/hold";
+      NumericalConstraintPtr_t c = cacheLookup (key);
+      if (!c) c = cacheStore (key, createGraspAndComplement (gripper, ""));
+      return c;
+    }
+
+    NumericalConstraintPtr_t Handle::pregrasp (const GripperPtr_t& gripper,
+        const value_type& shift) const
+    {
+      std::stringstream ss;
+      ss << gripper->name () << "/pregrasp_" << shift;
+      const std::string key = ss.str ();
+      NumericalConstraintPtr_t c = cacheLookup (key);
+      if (!c) c = cacheStore (key, createPreGrasp (gripper, shift, ""));
+      return c;
+    }
+
     HandlePtr_t Handle::clone () const
     {
       HandlePtr_t other = Handle::create (name (), localPosition (), joint ());
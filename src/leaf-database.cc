@@ -0,0 +1,234 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/manipulation/leaf-database.hh>
+
+#include <cstring>
+#include <fstream>
+
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <hpp/util/debug.hh>
+#include <hpp/util/pointer.hh>
+
+#include <hpp/manipulation/device.hh>
+#include <hpp/manipulation/roadmap-node.hh>
+#include <hpp/manipulation/graph/graph.hh>
+#include <hpp/manipulation/graph/edge.hh>
+#include <hpp/manipulation/graph/statistics.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace {
+      const char magic_[8] = { 'h', 'p', 'p', 'l', 'e', 'a', 'f', '\0' };
+      const boost::int64_t version_ = 1;
+
+      /// Stored frequencies are capped: beyond this the relative
+      /// weights of the leaves are saturated anyway, and seeding
+      /// replays one histogram insertion per count.
+      const std::size_t maxStoredFreq_ = 1000;
+
+      void write64 (std::ostream& os, const boost::int64_t v)
+      {
+        os.write (reinterpret_cast <const char*> (&v), sizeof (v));
+      }
+
+      boost::int64_t read64 (std::istream& is)
+      {
+        boost::int64_t v = 0;
+        is.read (reinterpret_cast <char*> (&v), sizeof (v));
+        return v;
+      }
+
+      /// Hash of the graph structure: the component names in id order.
+      /// Renaming or restructuring the graph invalidates the database;
+      /// changing weights or parameters does not.
+      std::size_t structureHash (const graph::GraphPtr_t& graph)
+      {
+        std::size_t seed = 0;
+        for (std::size_t id = 0; id < graph->nbComponents (); ++id) {
+          const graph::GraphComponentPtr_t c = graph->get (id).lock ();
+          if (c) boost::hash_combine (seed, c->name ());
+        }
+        return seed;
+      }
+    }
+
+    LeafDatabase::LeafDatabase (const std::string& path,
+        const graph::GraphPtr_t& graph) :
+      path_ (path), graph_ (graph), graphHash_ (structureHash (graph))
+    {
+      load ();
+    }
+
+    LeafDatabase::~LeafDatabase ()
+    {
+      for (std::size_t i = 0; i < seededNodes_.size (); ++i)
+        delete seededNodes_[i];
+    }
+
+    void LeafDatabase::load ()
+    {
+      std::ifstream is (path_.c_str (), std::ios::binary);
+      if (!is) return; // First run: start empty.
+      char magic [sizeof (magic_)];
+      is.read (magic, sizeof (magic));
+      if (!is || std::memcmp (magic, magic_, sizeof (magic_)) != 0) {
+        hppDout (warning, path_ << " is not a leaf database, ignored.");
+        return;
+      }
+      if (read64 (is) != version_) {
+        hppDout (warning, "Unsupported leaf database version, ignored.");
+        return;
+      }
+      if ((std::size_t) read64 (is) != graphHash_) {
+        hppDout (info, "Leaf database " << path_ << " was recorded for"
+            " another graph, ignored.");
+        return;
+      }
+      const size_type configSize = (size_type) read64 (is);
+      const boost::int64_t nbEdges = read64 (is);
+      for (boost::int64_t e = 0; e < nbEdges && is; ++e) {
+        const std::size_t edgeId = (std::size_t) read64 (is);
+        const boost::int64_t nbLeaves = read64 (is);
+        Leaves_t& leaves = store_[edgeId];
+        for (boost::int64_t l = 0; l < nbLeaves && is; ++l) {
+          Leaf_t leaf;
+          leaf.freq = (std::size_t) read64 (is);
+          leaf.configuration.resize (configSize);
+          is.read (reinterpret_cast <char*> (leaf.configuration.data ()),
+              configSize * (size_type) sizeof (value_type));
+          if (is) leaves.push_back (leaf);
+        }
+      }
+      hppDout (info, "Loaded " << nbLeaves () << " leaves from " << path_);
+    }
+
+    void LeafDatabase::preload ()
+    {
+      graph::GraphPtr_t graph = graph_.lock ();
+      if (!graph) return;
+      for (Store_t::const_iterator it = store_.begin ();
+          it != store_.end (); ++it) {
+        graph::LevelSetEdgePtr_t edge = HPP_DYNAMIC_PTR_CAST
+          (graph::LevelSetEdge, graph->get (it->first).lock ());
+        if (!edge || !edge->histogram ()) continue;
+        const Leaves_t& leaves = it->second;
+        for (std::size_t l = 0; l < leaves.size (); ++l) {
+          // The representative is a detached node: it belongs to no
+          // roadmap and only carries the configuration the sampling
+          // distributions hand out.
+          ConfigurationPtr_t q (new Configuration_t
+              (leaves[l].configuration));
+          RoadmapNodePtr_t node = new RoadmapNode (q);
+          seededNodes_.push_back (node);
+          edge->histogram ()->seed (node,
+              std::min (leaves[l].freq, maxStoredFreq_));
+        }
+      }
+    }
+
+    void LeafDatabase::mergeHistograms ()
+    {
+      graph::GraphPtr_t graph = graph_.lock ();
+      if (!graph) return;
+      for (std::size_t id = 0; id < graph->nbComponents (); ++id) {
+        graph::LevelSetEdgePtr_t edge = HPP_DYNAMIC_PTR_CAST
+          (graph::LevelSetEdge, graph->get (id).lock ());
+        if (!edge || !edge->histogram ()) continue;
+        const graph::LeafHistogramPtr_t hist = edge->histogram ();
+        Leaves_t& leaves = store_[id];
+        // Parameters of the stored leaves, to match observed bins to
+        // stored entries within the solver threshold.
+        const value_type threshold = 10 * graph->errorThreshold ();
+        std::vector <vector_t> parameters (leaves.size ());
+        for (std::size_t l = 0; l < leaves.size (); ++l)
+          parameters[l] = hist->foliation ().parameter
+            (leaves[l].configuration);
+        for (graph::LeafHistogram::const_iterator bin = hist->begin ();
+            bin != hist->end (); ++bin) {
+          if (bin->nodes ().empty ()) continue;
+          const vector_t& p = bin->value ();
+          std::size_t match = leaves.size ();
+          for (std::size_t l = 0; l < leaves.size (); ++l) {
+            if (parameters[l].size () == p.size () &&
+                (parameters[l] - p).lpNorm <Eigen::Infinity> ()
+                < threshold) {
+              match = l;
+              break;
+            }
+          }
+          if (match < leaves.size ()) {
+            // The bin frequency includes the count seeded by preload:
+            // keeping the maximum merges the new observations without
+            // counting the seed twice.
+            leaves[match].freq = std::max (leaves[match].freq,
+                std::min ((std::size_t) bin->freq (), maxStoredFreq_));
+          } else {
+            Leaf_t leaf;
+            leaf.freq = std::min ((std::size_t) bin->freq (),
+                maxStoredFreq_);
+            leaf.configuration =
+              *(bin->nodes ().front ()->configuration ());
+            leaves.push_back (leaf);
+            parameters.push_back (p);
+          }
+        }
+        if (leaves.empty ()) store_.erase (id);
+      }
+    }
+
+    void LeafDatabase::save ()
+    {
+      graph::GraphPtr_t graph = graph_.lock ();
+      if (!graph) return;
+      mergeHistograms ();
+      std::ofstream os (path_.c_str (), std::ios::binary | std::ios::trunc);
+      if (!os) {
+        hppDout (error, "Cannot write leaf database " << path_);
+        return;
+      }
+      os.write (magic_, sizeof (magic_));
+      write64 (os, version_);
+      write64 (os, (boost::int64_t) graphHash_);
+      write64 (os, (boost::int64_t) graph->robot ()->configSize ());
+      write64 (os, (boost::int64_t) store_.size ());
+      for (Store_t::const_iterator it = store_.begin ();
+          it != store_.end (); ++it) {
+        write64 (os, (boost::int64_t) it->first);
+        write64 (os, (boost::int64_t) it->second.size ());
+        for (std::size_t l = 0; l < it->second.size (); ++l) {
+          const Leaf_t& leaf = it->second[l];
+          write64 (os, (boost::int64_t) leaf.freq);
+          os.write (reinterpret_cast <const char*>
+              (leaf.configuration.data ()),
+              leaf.configuration.size () * (size_type) sizeof (value_type));
+        }
+      }
+      hppDout (info, "Saved " << nbLeaves () << " leaves to " << path_);
+    }
+
+    std::size_t LeafDatabase::nbLeaves () const
+    {
+      std::size_t n = 0;
+      for (Store_t::const_iterator it = store_.begin ();
+          it != store_.end (); ++it)
+        n += it->second.size ();
+      return n;
+    }
+  } // namespace manipulation
+} // namespace hpp
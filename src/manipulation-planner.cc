@@ -16,8 +16,17 @@
 
 #include "hpp/manipulation/manipulation-planner.hh"
 
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+
 #include <boost/tuple/tuple.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/locks.hpp>
 
 #include <hpp/util/pointer.hh>
 #include <hpp/util/timer.hh>
@@ -27,6 +36,7 @@
 
 #include <hpp/core/path-validation.hh>
 #include <hpp/core/connected-component.hh>
+#include <hpp/core/distance.hh>
 #include <hpp/core/path-projector.hh>
 #include <hpp/core/projection-error.hh>
 #include <hpp/core/nearest-neighbor.hh>
@@ -39,10 +49,15 @@
 #include "hpp/manipulation/problem.hh"
 #include "hpp/manipulation/roadmap.hh"
 #include "hpp/manipulation/roadmap-node.hh"
+#include "hpp/manipulation/decision-log.hh"
+#include "hpp/manipulation/leaf-database.hh"
 #include "hpp/manipulation/graph-path-validation.hh"
 #include "hpp/manipulation/graph/edge.hh"
+#include "hpp/manipulation/graph/state.hh"
 #include "hpp/manipulation/graph/state-selector.hh"
 
+#include <hpp/core/path-vector.hh>
+
 namespace hpp {
   namespace manipulation {
     namespace {
@@ -60,14 +75,6 @@ namespace hpp {
       HPP_DEFINE_TIMECOUNTER(projectPath);
       HPP_DEFINE_TIMECOUNTER(validatePath);
 
-      bool belongs (const ConfigurationPtr_t& q, const core::Nodes_t& nodes)
-      {
-        for (core::Nodes_t::const_iterator itNode = nodes.begin ();
-            itNode != nodes.end (); ++itNode) {
-          if (*((*itNode)->configuration ()) == *q) return true;
-        }
-        return false;
-      }
     }
 
     const std::vector<ManipulationPlanner::Reason>
@@ -107,19 +114,86 @@ namespace hpp {
     {
       const std::size_t& id = edge->id ();
       ErrorFreqs_t ret;
-      if (indexPerEdgeStatistics_.size() <= id ||
-         indexPerEdgeStatistics_[id] < 0) {
+      // Merge the per-worker shards on read.
+      bool found = false;
+      std::vector <std::size_t> freqs (reasons_.size() + 1, 0);
+      for (std::size_t rank = 0; rank < statisticsShards_.size(); ++rank) {
+        const StatisticsShard& shard = statisticsShards_[rank];
+        if (shard.indexPerEdge.size() <= id || shard.indexPerEdge[id] < 0)
+          continue;
+        found = true;
+        const SuccessStatistics& ss = shard.perEdge[shard.indexPerEdge[id]];
+        freqs[0] += ss.nbSuccess ();
+        for (std::size_t i = 0; i < reasons_.size(); ++i)
+          freqs[i+1] += ss.nbFailure (reasons_[i]);
+      }
+      if (!found) {
         for (std::size_t i = 0; i < reasons_.size(); ++i) ret.push_back (0);
       } else {
-        const SuccessStatistics& ss =
-          perEdgeStatistics_[indexPerEdgeStatistics_[id]];
-        ret.push_back (ss.nbSuccess ());
-        for (std::size_t i = 0; i < reasons_.size(); ++i)
-          ret.push_back (ss.nbFailure (reasons_[i]));
+        ret.insert (ret.end(), freqs.begin(), freqs.end());
       }
       return ret;
     }
 
+    void ManipulationPlanner::adaptEdgeWeights ()
+    {
+      // Only this planner's workers read the neighbor tables, and none
+      // of them runs here; the constructor disables adaptation in
+      // shared roadmap mode, where other planner instances would
+      // sample the tables while updateWeight rebuilds them.
+      assert (!sharedRoadmap_);
+      const graph::GraphPtr_t graph = problem_.constraintGraph ();
+      if (!graph) return;
+      // Minimum number of attempts before the success rate of an edge
+      // is trusted; below it the edge keeps the optimistic prior.
+      const std::size_t minObservations = 10;
+      // Weights are integers: the base weights are scaled up so the
+      // success rates keep some resolution after rounding.
+      const value_type scale = 100;
+      for (std::size_t id = 0; id < graph->nbComponents (); ++id) {
+        graph::StatePtr_t state = HPP_DYNAMIC_PTR_CAST
+          (graph::State, graph->get (id).lock ());
+        if (!state) continue;
+        // Copies: updateWeight below invalidates the flat tables.
+        const std::vector <graph::EdgePtr_t> edges = state->neighborEdges ();
+        const vector_t weights = state->neighborWeights ();
+        for (std::size_t i = 0; i < edges.size (); ++i) {
+          const graph::EdgePtr_t& edge = edges[i];
+          const std::size_t eid = edge->id ();
+          // The base weight is what the graph was built - or hand-tuned
+          // - with, recorded before the first rewrite.
+          const value_type base = baseWeights_.insert (std::make_pair
+              (eid, (value_type) weights[(size_type) i])).first->second;
+          // A zero weight disables the edge on purpose; leave it so.
+          if (base == 0) continue;
+          // Merge the statistics shards, as getEdgeStat does.
+          std::size_t nbSuccess = 0, nbFailure = 0;
+          for (std::size_t rank = 0; rank < statisticsShards_.size ();
+              ++rank) {
+            const StatisticsShard& shard = statisticsShards_[rank];
+            if (shard.indexPerEdge.size () <= eid ||
+                shard.indexPerEdge[eid] < 0) continue;
+            const SuccessStatistics& ss =
+              shard.perEdge[shard.indexPerEdge[eid]];
+            nbSuccess += ss.nbSuccess ();
+            nbFailure += ss.nbFailure (reasons_[FAILURE]);
+          }
+          const std::size_t total = nbSuccess + nbFailure;
+          // Unattempted edges keep the prior rate of 1 so they stay
+          // attractive until tried. Attempted ones get a Laplace
+          // smoothed success rate, kept above the exploration floor so
+          // that no edge starves.
+          const value_type rate = (total < minObservations) ? 1 :
+            (value_type) (nbSuccess + 1) / (value_type) (total + 2);
+          const value_type f = weightFloor_ + (1 - weightFloor_) * rate;
+          graph::Weight_t w = (graph::Weight_t) (scale * base * f + 0.5);
+          if (w < 1) w = 1;
+          if (w != state->getWeight (edge))
+            state->updateWeight (edge, w);
+        }
+      }
+    }
+
     StringList_t ManipulationPlanner::errorList ()
     {
       StringList_t ret;
@@ -130,13 +204,53 @@ namespace hpp {
 
     void ManipulationPlanner::oneStep ()
     {
+      // Anytime budgets: interrupt the enclosing solve() once the time
+      // or iteration budget of the query is exhausted. solve() still
+      // returns normally when a solution was found before that.
+      if (iterationBudget_ > 0 && ++iterationsDone_ > iterationBudget_) {
+        interrupt ();
+        return;
+      }
+      if (timeBudget_ > 0) {
+        const value_type elapsed = (value_type)
+          (boost::posix_time::microsec_clock::universal_time () - solveStart_)
+          .total_milliseconds () / 1000;
+        if (elapsed > timeBudget_) {
+          interrupt ();
+          return;
+        }
+      }
       HPP_START_TIMECOUNTER(oneStep);
+      // Always-on counter, recorded by the main thread into shard 0;
+      // the workers write other phases of that shard, never this one.
+      Telemetry::ScopedPhase telStep (telemetry_, 0, Telemetry::ONE_STEP);
+
+      // Fold the accumulated per-edge statistics into the sampling
+      // weights every adaptWeightsPeriod_ iterations. No worker is
+      // running here, so the graph weights can be rewritten safely.
+      if (adaptWeightsPeriod_ > 0 &&
+          ++stepsSinceWeightUpdate_ >= adaptWeightsPeriod_) {
+        stepsSinceWeightUpdate_ = 0;
+        adaptEdgeWeights ();
+      }
+
+      // When several planners grow the roadmap, the structural phases
+      // below - statistics flush, nearest neighbor collection, node and
+      // edge insertion - run under the roadmap write mutex. The
+      // extension work in between, which dominates the iteration, runs
+      // unlocked.
+      boost::mutex::scoped_lock roadmapLock (roadmap_->writeMutex (),
+          boost::defer_lock);
+      if (sharedRoadmap_) roadmapLock.lock ();
+
+      // When histogram updates are deferred, the nodes queued during the
+      // previous iteration land in the histograms here, in one batch and
+      // off the per-node insertion path. The leaf distributions read by
+      // the level set edges are thus at most one iteration stale.
+      roadmap_->flushStatistics ();
 
       DevicePtr_t robot = HPP_DYNAMIC_PTR_CAST(Device, problem ().robot ());
       HPP_ASSERT(robot);
-      const graph::States_t& graphStates = problem_.constraintGraph ()
-        ->stateSelector ()->getStates ();
-      graph::States_t::const_iterator itState;
       core::Nodes_t newNodes;
       core::PathPtr_t path;
 
@@ -145,39 +259,118 @@ namespace hpp {
       typedef std::vector <DelayedEdge_t> DelayedEdges_t;
       DelayedEdges_t delayedEdges;
 
-      // Pick a random node
-      ConfigurationPtr_t q_rand = shooter_->shoot();
+      // Collect the extension jobs: for every configuration of the batch,
+      // one nearest neighbor per pair (connected component, graph state).
+      // Shooting several configurations at once amortizes the iteration
+      // over connected components and graph states.
+      // The job, candidate and path arrays below live in member buffers
+      // so that, once the planner is warm, an iteration does not
+      // allocate them again.
+      ExtensionJobs_t& jobs = jobsBuffer_;
+      jobs.clear ();
+      NodesAndDistances_t nearest;
+      for (size_type s = 0; s < batchSize_; ++s) {
+        // Pick a random node
+        ConfigurationPtr_t q_rand = shootConfiguration ();
 
-      // Extend each connected component
-      for (core::ConnectedComponents_t::const_iterator itcc =
-          roadmap ()->connectedComponents ().begin ();
-          itcc != roadmap ()->connectedComponents ().end (); ++itcc) {
-        // Find the nearest neighbor.
-        core::value_type distance;
-        for (itState = graphStates.begin (); itState != graphStates.end (); ++itState) {
+        for (core::ConnectedComponents_t::const_iterator itcc =
+            roadmap ()->connectedComponents ().begin ();
+            itcc != roadmap ()->connectedComponents ().end (); ++itcc) {
+          // Find the nearest neighbor per graph state, in one traversal
+          // of the component instead of one query per state of the
+          // graph.
           HPP_START_TIMECOUNTER(nearestNeighbor);
-          RoadmapNodePtr_t near = roadmap_->nearestNode (q_rand, HPP_STATIC_PTR_CAST(ConnectedComponent,*itcc), *itState, distance);
+          roadmap_->nearestNodes (q_rand,
+              HPP_STATIC_PTR_CAST(ConnectedComponent,*itcc), nearest);
           HPP_STOP_TIMECOUNTER(nearestNeighbor);
           HPP_DISPLAY_LAST_TIMECOUNTER(nearestNeighbor);
-          if (!near) continue;
-
-          HPP_START_TIMECOUNTER(extend);
-          bool pathIsValid = extend (near, q_rand, path);
-          HPP_STOP_TIMECOUNTER(extend);
-          HPP_DISPLAY_LAST_TIMECOUNTER(extend);
-          // Insert new path to q_near in roadmap
-          if (pathIsValid) {
-            value_type t_final = path->timeRange ().second;
-            if (t_final != path->timeRange ().first) {
-	      bool success;
-              ConfigurationPtr_t q_new (new Configuration_t
-					((*path) (t_final, success)));
-              delayedEdges.push_back (DelayedEdge_t (near, q_new, path));
-            }
+          for (std::size_t i = 0; i < nearest.size (); ++i)
+            jobs.push_back (ExtensionJob_t (nearest[i].first, q_rand));
+        }
+      }
+      if (sharedRoadmap_) roadmapLock.unlock ();
+
+      // Run the extension jobs. They are independent from each other so,
+      // when more than one worker is requested, they are distributed over
+      // a thread pool. Roadmap insertion remains serialized through
+      // delayedEdges.
+      std::vector <core::PathPtr_t>& paths = pathsBuffer_;
+      paths.assign (jobs.size (), core::PathPtr_t ());
+      // One context and statistics shard per worker, grown while no
+      // worker is running.
+      growWorkerPools ((std::size_t) (nbThreads_ < 1 ? 1 : nbThreads_));
+      telemetry_.nbWorkers ((std::size_t) nbThreads_);
+      HPP_START_TIMECOUNTER(extend);
+      if (nbThreads_ <= 1) {
+        extendWorker (jobs, paths, 0);
+      } else if (pipelineValidation_ && greedyDepth_ <= 1) {
+        // Two-stage pipeline: all projection/steering candidates are
+        // produced first, then path validation - usually the dominant
+        // cost - is load-balanced over the same pool. Greedy chaining
+        // needs inline validation, so it keeps the fused workers.
+        ValidationCandidates_t& candidates = candidatesBuffer_;
+        candidates.assign (jobs.size (), ValidationCandidate_t ());
+        {
+          boost::thread_group producers;
+          for (std::size_t rank = 0; rank < (std::size_t) nbThreads_; ++rank)
+            producers.create_thread (boost::bind
+                (&ManipulationPlanner::produceWorker, this,
+                 boost::cref (jobs), boost::ref (candidates), rank));
+          producers.join_all ();
+        }
+        {
+          // The candidates of one edge share its stateful validation
+          // objects, so they go to the same validator - as
+          // GraphPathValidation::firstInvalidRank assigns its ranks -
+          // and the per-edge locks stay uncontended. Edges themselves
+          // round-robin over the pool.
+          std::vector <std::vector <std::size_t> > assigned
+            ((std::size_t) nbThreads_);
+          std::map <std::size_t, std::size_t> workerOfEdge;
+          std::size_t next = 0;
+          for (std::size_t i = 0; i < candidates.size (); ++i) {
+            if (!candidates[i].edge) continue;
+            std::pair <std::map <std::size_t, std::size_t>::iterator, bool>
+              res = workerOfEdge.insert
+              (std::make_pair (candidates[i].edge->id (), next));
+            if (res.second) next = (next + 1) % (std::size_t) nbThreads_;
+            assigned[res.first->second].push_back (i);
           }
+          boost::thread_group validators;
+          for (std::size_t rank = 0; rank < (std::size_t) nbThreads_; ++rank)
+            validators.create_thread (boost::bind
+                (&ManipulationPlanner::validateWorker, this,
+                 boost::cref (candidates), boost::cref (assigned[rank]),
+                 boost::ref (paths), rank));
+          validators.join_all ();
+        }
+      } else {
+        boost::thread_group workers;
+        for (std::size_t rank = 0; rank < (std::size_t) nbThreads_; ++rank)
+          workers.create_thread (boost::bind
+              (&ManipulationPlanner::extendWorker, this,
+               boost::cref (jobs), boost::ref (paths), rank));
+        workers.join_all ();
+      }
+      HPP_STOP_TIMECOUNTER(extend);
+      HPP_DISPLAY_LAST_TIMECOUNTER(extend);
+
+      for (std::size_t i = 0; i < paths.size (); ++i) {
+        path = paths[i];
+        if (!path) continue;
+        // Insert new path to q_near in roadmap
+        value_type t_final = path->timeRange ().second;
+        if (t_final != path->timeRange ().first) {
+          bool success;
+          // make_shared allocates the configuration and the shared_ptr
+          // control block at once.
+          ConfigurationPtr_t q_new (boost::make_shared <Configuration_t>
+                                    ((*path) (t_final, success)));
+          delayedEdges.push_back (DelayedEdge_t (jobs[i].first, q_new, path));
         }
       }
 
+      if (sharedRoadmap_) roadmapLock.lock ();
       HPP_START_TIMECOUNTER(delayedEdges);
       // Insert delayed edges
       for (DelayedEdges_t::const_iterator itEdge = delayedEdges.begin ();
@@ -192,16 +385,36 @@ namespace hpp {
       }
       HPP_STOP_TIMECOUNTER(delayedEdges);
 
-      // Try to connect the new nodes together
-      HPP_START_TIMECOUNTER(tryConnectNewNodes);
-      const std::size_t nbConn = tryConnectNewNodes (newNodes);
-      HPP_STOP_TIMECOUNTER(tryConnectNewNodes);
-      HPP_DISPLAY_LAST_TIMECOUNTER(tryConnectNewNodes);
-      if (nbConn == 0) {
-        HPP_START_TIMECOUNTER(tryConnectToRoadmap);
-        tryConnectToRoadmap (newNodes);
-        HPP_STOP_TIMECOUNTER(tryConnectToRoadmap);
-        HPP_DISPLAY_LAST_TIMECOUNTER(tryConnectToRoadmap);
+      // Try to connect the new nodes together. The attempted pairs are
+      // shared with the fallback phase below so no pair is steered twice.
+      // The distance memo is per iteration: pairs measured by the first
+      // phase are served from it when the fallback proposes them again.
+      distanceMemo_.clear (16 * newNodes.size ());
+      NodePairs_t attempted;
+      {
+        Telemetry::ScopedPhase telConn (telemetry_, 0,
+            Telemetry::TRY_CONNECT);
+        HPP_START_TIMECOUNTER(tryConnectNewNodes);
+        const std::size_t nbConn = tryConnectNewNodes (newNodes, attempted);
+        HPP_STOP_TIMECOUNTER(tryConnectNewNodes);
+        HPP_DISPLAY_LAST_TIMECOUNTER(tryConnectNewNodes);
+        if (nbConn == 0) {
+          HPP_START_TIMECOUNTER(tryConnectToRoadmap);
+          tryConnectToRoadmap (newNodes, attempted);
+          HPP_STOP_TIMECOUNTER(tryConnectToRoadmap);
+          HPP_DISPLAY_LAST_TIMECOUNTER(tryConnectToRoadmap);
+        }
+      }
+      if (sharedRoadmap_) {
+        roadmapLock.unlock ();
+        // Install the epoch lock-free readers work on. publish takes
+        // the write mutex itself, hence the unlock above. It snapshots
+        // the whole roadmap, so it runs on a period rather than per
+        // iteration; readers tolerate an epoch a few iterations old.
+        if (publishPeriod_ > 0 && ++stepsSincePublish_ >= publishPeriod_) {
+          stepsSincePublish_ = 0;
+          roadmap_->publish ();
+        }
       }
       HPP_STOP_TIMECOUNTER(oneStep);
       HPP_DISPLAY_LAST_TIMECOUNTER(oneStep);
@@ -217,86 +430,174 @@ namespace hpp {
       HPP_DISPLAY_TIMECOUNTER(buildPath);
       HPP_DISPLAY_TIMECOUNTER(projectPath);
       HPP_DISPLAY_TIMECOUNTER(validatePath);
+      // Commit the decisions of this iteration, so an interrupted run
+      // leaves a log replayable up to its last whole iteration.
+      if (recordLog_) recordLog_->commit ();
+    }
+
+    ConfigurationPtr_t ManipulationPlanner::shootConfiguration ()
+    {
+      if (replayLog_) {
+        ConfigurationPtr_t q (new Configuration_t
+            (problem ().robot ()->configSize ()));
+        if (replayLog_->nextConfiguration (*q)) return q;
+        // Log exhausted or diverged: continue with fresh samples.
+      }
+      ConfigurationPtr_t q = shooter_->shoot ();
+      if (recordLog_) recordLog_->recordConfiguration (*q);
+      return q;
     }
 
     bool ManipulationPlanner::extend(
         RoadmapNodePtr_t n_near,
         const ConfigurationPtr_t& q_rand,
         core::PathPtr_t& validPath)
+    {
+      return extend (n_near, q_rand, validPath, workerContexts_[0].qProj, 0);
+    }
+
+    void ManipulationPlanner::growWorkerPools (const std::size_t n)
+    {
+      if (statisticsShards_.size () < n) statisticsShards_.resize (n);
+      while (workerContexts_.size () < n) {
+        workerContexts_.push_back (WorkerContext ());
+        WorkerContext& context = workerContexts_.back ();
+        context.qProj.resize (problem ().robot ()->configSize ());
+        // Path validation is stateful, so each rank gets its own
+        // instance built by the problem factory instead of sharing
+        // the problem's one. The subpath threading setting of the
+        // problem instance is carried over.
+        GraphPathValidationPtr_t validation (GraphPathValidation::create
+            (problem_.pathValidationFactory ()));
+        validation->constraintGraph (problem_.constraintGraph ());
+        if (problem_.pathValidation ())
+          validation->numberOfThreads
+            (problem_.pathValidation ()->numberOfThreads ());
+        context.pathValidation = validation;
+      }
+      // The first context is built by the constructor, possibly before
+      // the constraint graph reached the problem: refresh it on every
+      // growth, which happens before any worker runs.
+      for (std::size_t i = 0; i < workerContexts_.size (); ++i)
+        workerContexts_[i].pathValidation->constraintGraph
+          (problem_.constraintGraph ());
+    }
+
+    void ManipulationPlanner::extendWorker (const ExtensionJobs_t& jobs,
+        std::vector <core::PathPtr_t>& paths, const std::size_t rank)
+    {
+      // Each worker owns its context so that extend is reentrant.
+      Configuration_t& qProj = workerContexts_[rank].qProj;
+      const std::size_t step = (nbThreads_ <= 1) ? 1 : (std::size_t) nbThreads_;
+      for (std::size_t i = rank; i < jobs.size (); i += step) {
+        core::PathPtr_t path;
+        if (extend (jobs[i].first, jobs[i].second, path, qProj, rank))
+          paths[i] = path;
+      }
+    }
+
+    bool ManipulationPlanner::projectAndBuild (const graph::EdgePtr_t& edge,
+        ConfigurationIn_t q_from, Configuration_t& qProj,
+        const std::size_t rank, ProjectionModel* model,
+        core::PathPtr_t& projPath, bool& projShorter)
     {
       graph::GraphPtr_t graph = problem_.constraintGraph ();
       PathProjectorPtr_t pathProjector = problem_.pathProjector ();
       pinocchio::DevicePtr_t robot (problem_.robot ());
       value_type eps (graph->errorThreshold ());
-      // Select next node in the constraint graph.
-      const ConfigurationPtr_t q_near = n_near->configuration ();
-      HPP_START_TIMECOUNTER (chooseEdge);
-      graph::EdgePtr_t edge = graph->chooseEdge (n_near);
-      HPP_STOP_TIMECOUNTER (chooseEdge);
-      if (!edge) {
-        return false;
-      }
-      qProj_ = *q_rand;
+      projShorter = false;
+      // Two jobs routinely pick the same edge, whose projector,
+      // steering method and caches are stateful: ranks serialize per
+      // edge. Jobs on distinct edges still run in parallel. In shared
+      // roadmap mode the other planner instances use the same edge
+      // objects, so the lock is taken even with a single worker.
+      boost::mutex::scoped_lock edgeLock (edge->workerMutex (),
+          boost::defer_lock);
+      if (nbThreads_ > 1 || sharedRoadmap_) edgeLock.lock ();
+      SuccessStatistics& es = edgeStat (edge, rank);
       HPP_START_TIMECOUNTER (applyConstraints);
-      SuccessStatistics& es = edgeStat (edge);
-      if (!edge->applyConstraints (n_near, qProj_)) {
+      const Telemetry::counter_t projStart = Telemetry::tick ();
+      const bool projOk = edge->applyConstraints (q_from, qProj);
+      telemetry_.recordEdge (rank, Telemetry::PROJECTION, edge->id (),
+          projOk, Telemetry::tick () - projStart);
+      if (model) {
+        ++model->nbObs;
+        if (projOk) ++model->nbSuccess;
+      }
+      if (!projOk) {
         HPP_STOP_TIMECOUNTER (applyConstraints);
-        es.addFailure (reasons_[FAILURE]);
-        es.addFailure (reasons_[PROJECTION]);
+        addFailure (PROJECTION, es);
         return false;
       }
-      if (pinocchio::isApprox (robot, qProj_, *q_near, eps)) {
-        es.addFailure (reasons_[FAILURE]);
-	es.addFailure (reasons_[PATH_PROJECTION_ZERO]);
+      if (pinocchio::isApprox (robot, qProj, q_from, eps)) {
+        addFailure (PATH_PROJECTION_ZERO, es);
 	return false;
       }
       HPP_STOP_TIMECOUNTER (applyConstraints);
       core::PathPtr_t path;
       HPP_START_TIMECOUNTER (buildPath);
-      if (!edge->build (path, *q_near, qProj_)) {
+      if (!edge->build (path, q_from, qProj)) {
         HPP_STOP_TIMECOUNTER (buildPath);
-        es.addFailure (reasons_[FAILURE]);
-        es.addFailure (reasons_[STEERING_METHOD]);
+        addFailure (STEERING_METHOD, es);
         return false;
       }
       HPP_STOP_TIMECOUNTER (buildPath);
-      core::PathPtr_t projPath;
-      bool projShorter = false;
       if (pathProjector) {
         HPP_START_TIMECOUNTER (projectPath);
         projShorter = !pathProjector->apply (path, projPath);
         if (projShorter) {
           if (!projPath || projPath->length () == 0) {
             HPP_STOP_TIMECOUNTER (projectPath);
-	    es.addFailure (reasons_[FAILURE]);
-            es.addFailure (reasons_[PATH_PROJECTION_ZERO]);
+            addFailure (PATH_PROJECTION_ZERO, es);
             return false;
           }
         }
         HPP_STOP_TIMECOUNTER (projectPath);
       } else projPath = path;
-      GraphPathValidationPtr_t pathValidation (problem_.pathValidation ());
+      return true;
+    }
+
+    bool ManipulationPlanner::validateCandidate (const graph::EdgePtr_t& edge,
+        const core::PathPtr_t& projPath, const bool projShorter,
+        const std::size_t rank, core::PathPtr_t& validPath,
+        bool& fullyValid, bool& trimmed)
+    {
+      fullyValid = false;
+      trimmed = false;
+      // The inner validation of the subpaths is dispatched to the
+      // stateful per-edge instances, shared between the ranks - and
+      // between the planner instances in shared roadmap mode - so
+      // candidates of one edge serialize here.
+      boost::mutex::scoped_lock edgeLock (edge->workerMutex (),
+          boost::defer_lock);
+      if (nbThreads_ > 1 || sharedRoadmap_) edgeLock.lock ();
+      SuccessStatistics& es = edgeStat (edge, rank);
+      GraphPathValidationPtr_t pathValidation
+        (workerContexts_[rank].pathValidation);
       PathValidationReportPtr_t report;
       core::PathPtr_t fullValidPath;
       HPP_START_TIMECOUNTER (validatePath);
-      bool fullyValid = false;
-      try {
-        fullyValid = pathValidation->validate
-          (projPath, false, fullValidPath, report);
-      } catch (const core::projection_error& e) {
-        hppDout (error, e.what ());
-        es.addFailure (reasons_[FAILURE]);
-        es.addFailure (reasons_[PATH_VALIDATION_ZERO]);
-        return false;
+      bool validationOk = false;
+      {
+        Telemetry::ScopedPhase telValidate (telemetry_, rank,
+            Telemetry::PATH_VALIDATION);
+        try {
+          validationOk = pathValidation->validate
+            (projPath, false, fullValidPath, report);
+        } catch (const core::projection_error& e) {
+          hppDout (error, e.what ());
+          addFailure (PATH_VALIDATION_ZERO, es);
+          return false;
+        }
       }
       HPP_STOP_TIMECOUNTER (validatePath);
+      fullyValid = validationOk && !projShorter;
       if (fullValidPath->length () == 0) {
-        es.addFailure (reasons_[FAILURE]);
-        es.addFailure (reasons_[PATH_VALIDATION_ZERO]);
+        addFailure (PATH_VALIDATION_ZERO, es);
         validPath = fullValidPath;
         return false;
       } else {
-        if (extendStep_ == 1 || fullyValid) {
+        if (extendStep_ == 1 || validationOk) {
           validPath = fullValidPath;
         } else {
           const value_type& length = fullValidPath->length();
@@ -304,144 +605,397 @@ namespace hpp {
           try {
             validPath = fullValidPath->extract
               (core::interval_t(t_init, t_init + length * extendStep_));
+            trimmed = true;
           } catch (const core::projection_error& e) {
             hppDout (error, e.what());
-	    es.addSuccess ();
-            es.addFailure (reasons_[PATH_PROJECTION_SHORTER]);
+            addSuccess (PATH_PROJECTION_SHORTER, es);
             return false;
           }
         }
         hppDout (info, "Extension:" << std::endl
             << es);
       }
-      if (!projShorter && fullyValid) {
-	es.addSuccess ();
-	es.addFailure (reasons_ [REACHED_DESTINATION_NODE]);
+      if (!projShorter && validationOk) {
+        addSuccess (REACHED_DESTINATION_NODE, es);
+      } else {
+        addSuccess (projShorter ? PATH_PROJECTION_SHORTER
+                                : PATH_VALIDATION_SHORTER, es);
+      }
+      return true;
+    }
+
+    bool ManipulationPlanner::extendAlongEdge (const graph::EdgePtr_t& edge,
+        ConfigurationIn_t q_from, Configuration_t& qProj,
+        const std::size_t rank, ProjectionModel* model,
+        core::PathPtr_t& validPath, bool& fullyValid, bool& trimmed)
+    {
+      core::PathPtr_t projPath;
+      bool projShorter = false;
+      if (!projectAndBuild (edge, q_from, qProj, rank, model, projPath,
+            projShorter))
+        return false;
+      return validateCandidate (edge, projPath, projShorter, rank, validPath,
+          fullyValid, trimmed);
+    }
+
+    graph::EdgePtr_t ManipulationPlanner::selectEdge (RoadmapNodePtr_t n_near,
+        const std::size_t rank, ProjectionModel*& model)
+    {
+      model = NULL;
+      HPP_START_TIMECOUNTER (chooseEdge);
+      graph::EdgePtr_t edge;
+      bool replayed = false;
+      if (replayLog_)
+        replayed = replayLog_->nextEdge (edge, problem_.constraintGraph ());
+      if (!replayed) {
+        edge = problem_.constraintGraph ()->chooseEdge (n_near);
+        if (recordLog_) recordLog_->recordEdge (edge);
+      }
+      HPP_STOP_TIMECOUNTER (chooseEdge);
+      if (!edge) return edge;
+      // Online reject model: when projection on this (edge, leaf) pair
+      // keeps failing, skip most attempts instead of paying a full
+      // Newton solve for each. Skips are not recorded anywhere: they
+      // are not solver outcomes.
+      if (projectionFloor_ > 0) {
+        model = &statisticsShards_[rank].projectionModels
+          [ProjectionKey_t (edge->id (), n_near->symbolicComponent ())];
+        const value_type rate = model->successRate ();
+        if (model->nbObs >= 10 && rate < projectionFloor_) {
+          const value_type u = (value_type) rand () / (value_type) RAND_MAX;
+          if (u > rate / projectionFloor_) return graph::EdgePtr_t ();
+        }
+      }
+      return edge;
+    }
+
+    void ManipulationPlanner::produceWorker (const ExtensionJobs_t& jobs,
+        ValidationCandidates_t& candidates, const std::size_t rank)
+    {
+      Telemetry::ScopedPhase telExtend (telemetry_, rank, Telemetry::EXTEND);
+      // Each worker owns its context so that production is reentrant.
+      Configuration_t& qProj = workerContexts_[rank].qProj;
+      const std::size_t step = (std::size_t) nbThreads_;
+      for (std::size_t i = rank; i < jobs.size (); i += step) {
+        ProjectionModel* model = NULL;
+        graph::EdgePtr_t edge = selectEdge (jobs[i].first, rank, model);
+        if (!edge) continue;
+        qProj = *(jobs[i].second);
+        core::PathPtr_t projPath;
+        bool projShorter = false;
+        if (!projectAndBuild (edge, *(jobs[i].first->configuration ()), qProj,
+              rank, model, projPath, projShorter))
+          continue;
+        candidates[i].edge = edge;
+        candidates[i].projPath = projPath;
+        candidates[i].projShorter = projShorter;
       }
-      else {
-	es.addSuccess ();
-	if (projShorter) {
-	  es.addFailure (reasons_ [PATH_PROJECTION_SHORTER]);
-	} else {
-	  es.addFailure (reasons_ [PATH_VALIDATION_SHORTER]);
-	}
+    }
+
+    void ManipulationPlanner::validateWorker (
+        const ValidationCandidates_t& candidates,
+        const std::vector <std::size_t>& indices,
+        std::vector <core::PathPtr_t>& paths, const std::size_t rank)
+    {
+      for (std::size_t k = 0; k < indices.size (); ++k) {
+        const std::size_t i = indices[k];
+        core::PathPtr_t validPath;
+        bool fullyValid = false, trimmed = false;
+        if (validateCandidate (candidates[i].edge, candidates[i].projPath,
+              candidates[i].projShorter, rank, validPath, fullyValid,
+              trimmed))
+          paths[i] = validPath;
+      }
+    }
+
+    bool ManipulationPlanner::extend(
+        RoadmapNodePtr_t n_near,
+        const ConfigurationPtr_t& q_rand,
+        core::PathPtr_t& validPath,
+        Configuration_t& qProj, const std::size_t rank)
+    {
+      Telemetry::ScopedPhase telExtend (telemetry_, rank, Telemetry::EXTEND);
+      // Select next node in the constraint graph.
+      const ConfigurationPtr_t q_near = n_near->configuration ();
+      ProjectionModel* model = NULL;
+      graph::EdgePtr_t edge = selectEdge (n_near, rank, model);
+      if (!edge) {
+        return false;
+      }
+      qProj = *q_rand;
+      bool fullyValid = false, trimmed = false;
+      if (!extendAlongEdge (edge, *q_near, qProj, rank, model, validPath,
+            fullyValid, trimmed))
+        return false;
+      // Greedy chaining: as long as the previous edge was traversed
+      // completely, keep pulling toward q_rand along the graph within
+      // the same call, amortizing the nearest neighbor query and the
+      // roadmap insertion over several edges of progress. The chained
+      // segments share one roadmap edge, whose path is the
+      // concatenation built here.
+      if (greedyDepth_ > 1) {
+        core::PathVectorPtr_t chain;
+        graph::EdgePtr_t lastEdge = edge;
+        for (size_type depth = 1;
+            depth < greedyDepth_ && fullyValid && !trimmed; ++depth) {
+          graph::StatePtr_t state = lastEdge->to ();
+          graph::EdgePtr_t next = state->sampleNeighbor ();
+          if (!next) break;
+          const Configuration_t q_from (qProj);
+          qProj = *q_rand;
+          core::PathPtr_t segment;
+          // The reject model is keyed by the extended node: chained
+          // steps start from a configuration that has no node yet, so
+          // they bypass it.
+          if (!extendAlongEdge (next, q_from, qProj, rank, NULL, segment,
+                fullyValid, trimmed)) {
+            qProj = q_from;
+            break;
+          }
+          if (!chain) {
+            chain = core::PathVector::create (validPath->outputSize (),
+                validPath->outputDerivativeSize ());
+            chain->appendPath (validPath);
+          }
+          chain->appendPath (segment);
+          lastEdge = next;
+        }
+        if (chain) validPath = chain;
       }
       return true;
     }
 
+    void ManipulationPlanner::addFailure (TypeOfFailure t,
+        SuccessStatistics& es)
+    {
+      es.addFailure (reasons_[FAILURE]);
+      es.addFailure (reasons_[t]);
+    }
+
+    void ManipulationPlanner::addSuccess (TypeOfFailure t,
+        SuccessStatistics& es)
+    {
+      es.addSuccess ();
+      es.addFailure (reasons_[t]);
+    }
+
     ManipulationPlanner::SuccessStatistics& ManipulationPlanner::edgeStat
-      (const graph::EdgePtr_t& edge)
+      (const graph::EdgePtr_t& edge, const std::size_t& rank)
     {
+      StatisticsShard& shard = statisticsShards_[rank];
       const std::size_t& id = edge->id ();
-      if (indexPerEdgeStatistics_.size () <= id) {
-        indexPerEdgeStatistics_.resize (id + 1, -1);
+      if (shard.indexPerEdge.size () <= id) {
+        shard.indexPerEdge.resize (id + 1, -1);
+      }
+      if (shard.indexPerEdge[id] < 0) {
+        shard.indexPerEdge[id] = (int) shard.perEdge.size();
+        shard.perEdge.push_back (SuccessStatistics (edge->name (), 2));
+      }
+      return shard.perEdge[shard.indexPerEdge[id]];
+    }
+
+    namespace {
+      inline std::size_t pairHash (const core::Node* a, const core::Node* b)
+      {
+        std::size_t seed = boost::hash_value (a);
+        boost::hash_combine (seed, b);
+        return seed;
+      }
+    }
+
+    void ManipulationPlanner::DistanceMemo::clear (const std::size_t n)
+    {
+      // Smallest power of two keeping the table at most half full, so
+      // linear probing stays short.
+      std::size_t capacity = 64;
+      while (capacity < 2 * n) capacity <<= 1;
+      slots.assign (capacity, Slot ());
+      used = 0;
+    }
+
+    bool ManipulationPlanner::DistanceMemo::find (const core::Node* a,
+        const core::Node* b, value_type& d) const
+    {
+      if (slots.empty ()) return false;
+      const std::size_t mask = slots.size () - 1;
+      for (std::size_t h = pairHash (a, b) & mask; slots[h].a;
+          h = (h + 1) & mask) {
+        if (slots[h].a == a && slots[h].b == b) {
+          d = slots[h].d;
+          return true;
+        }
       }
-      if (indexPerEdgeStatistics_[id] < 0) {
-        indexPerEdgeStatistics_[id] = (int) perEdgeStatistics_.size();
-        perEdgeStatistics_.push_back (SuccessStatistics (edge->name (), 2));
+      return false;
+    }
+
+    void ManipulationPlanner::DistanceMemo::store (const core::Node* a,
+        const core::Node* b, const value_type d)
+    {
+      if (slots.empty () || 2 * (used + 1) > slots.size ()) {
+        // Rehash into a table twice as large.
+        std::vector <Slot> old;
+        old.swap (slots);
+        slots.assign (old.empty () ? 64 : 2 * old.size (), Slot ());
+        used = 0;
+        for (std::size_t i = 0; i < old.size (); ++i)
+          if (old[i].a) store (old[i].a, old[i].b, old[i].d);
       }
-      return perEdgeStatistics_[indexPerEdgeStatistics_[id]];
+      const std::size_t mask = slots.size () - 1;
+      std::size_t h = pairHash (a, b) & mask;
+      while (slots[h].a) h = (h + 1) & mask;
+      slots[h].a = a;
+      slots[h].b = b;
+      slots[h].d = d;
+      ++used;
     }
 
-    inline std::size_t ManipulationPlanner::tryConnectToRoadmap (const core::Nodes_t nodes)
+    value_type ManipulationPlanner::memoizedDistance
+      (const core::DistancePtr_t& distance,
+       const core::NodePtr_t& n1, const core::NodePtr_t& n2)
     {
-      const core::SteeringMethodPtr_t& sm (problem ().steeringMethod ());
+      // The metric is symmetric: one entry per unordered pair.
+      const core::Node* a = std::min (n1, n2);
+      const core::Node* b = std::max (n1, n2);
+      value_type d;
+      if (distanceMemo_.find (a, b, d)) return d;
+      d = (*distance) (n1, n2);
+      distanceMemo_.store (a, b, d);
+      return d;
+    }
+
+    inline std::size_t ManipulationPlanner::attemptConnections
+      (ConnectionCandidates_t& candidates, NodePairs_t& attempted)
+    {
+      graph::GraphPtr_t graph = problem_.constraintGraph ();
       core::PathValidationPtr_t pathValidation (problem ().pathValidation ());
       PathProjectorPtr_t pathProjector (problem().pathProjector ());
       core::PathPtr_t path, projPath, validPath;
-      graph::GraphPtr_t graph = problem_.constraintGraph ();
-      bool connectSucceed = false;
       std::size_t nbConnection = 0;
+      // Attempt the cheapest connections first: when a close pair merges
+      // two components, the remaining candidates between those components
+      // are skipped without steering.
+      std::sort (candidates.begin (), candidates.end ());
+      for (ConnectionCandidates_t::const_iterator it = candidates.begin ();
+          it != candidates.end (); ++it) {
+        const core::NodePtr_t& n1 (it->n1);
+        const core::NodePtr_t& n2 (it->n2);
+        if (n1->connectedComponent () == n2->connectedComponent ())
+          continue;
+        // The attempted set is shared by the two connection phases of a
+        // step, so a pair proposed by both is steered at most once.
+        NodePair_t pair (std::min (n1, n2), std::max (n1, n2));
+        if (!attempted.insert (pair).second) continue;
+        bool _1to2 = n1->isOutNeighbor (n2);
+        bool _2to1 = n1->isInNeighbor (n2);
+        if (_1to2 && _2to1) {
+          hppDout (info, "the two nodes are already connected");
+          continue;
+        }
+        ConfigurationPtr_t q1 (n1->configuration ());
+        ConfigurationPtr_t q2 (n2->configuration ());
+        assert (*q1 != *q2);
+        // Steer through the graph edges directly instead of the
+        // steering method of the problem, so each build runs under the
+        // worker mutex of its edge. In shared roadmap mode this phase
+        // holds only the roadmap write mutex, while the extension
+        // workers of the other planner instances use the same stateful
+        // edge objects under Edge::workerMutex ().
+        std::size_t pairId;
+        try {
+          pairId = graph->statePairId (graph->getState (*q1),
+                                       graph->getState (*q2));
+        } catch (const std::logic_error& e) {
+          hppDout (error, e.what ());
+          continue;
+        }
+        const graph::Edges_t& possibleEdges (graph->getEdges (pairId));
+        path = core::PathPtr_t ();
+        graph::EdgePtr_t edge;
+        for (graph::Edges_t::const_reverse_iterator itE =
+            possibleEdges.rbegin (); itE != possibleEdges.rend (); ++itE) {
+          boost::mutex::scoped_lock buildLock ((*itE)->workerMutex (),
+              boost::defer_lock);
+          if (nbThreads_ > 1 || sharedRoadmap_) buildLock.lock ();
+          if ((*itE)->build (path, *q1, *q2)) {
+            edge = *itE;
+            break;
+          }
+        }
+        if (!path) continue;
+        // The path projector and the per-edge path validation of the
+        // graph validation are stateful too: keep the edge serialized
+        // until the connection is validated.
+        boost::mutex::scoped_lock edgeLock (edge->workerMutex (),
+            boost::defer_lock);
+        if (nbThreads_ > 1 || sharedRoadmap_) edgeLock.lock ();
+        if (pathProjector) {
+          if (!pathProjector->apply (path, projPath)) continue;
+        } else projPath = path;
+        PathValidationReportPtr_t report;
+        if (pathValidation->validate (projPath, false, validPath, report)) {
+          nbConnection++;
+          if (!_1to2) roadmap ()->addEdge (n1, n2, projPath);
+          if (!_2to1) {
+            core::interval_t timeRange = projPath->timeRange ();
+            roadmap ()->addEdge (n2, n1, projPath->extract
+                (core::interval_t (timeRange.second,
+                                   timeRange.first)));
+          }
+        }
+      }
+      return nbConnection;
+    }
+
+    inline std::size_t ManipulationPlanner::tryConnectToRoadmap
+      (const core::Nodes_t nodes, NodePairs_t& attempted)
+    {
+      const core::DistancePtr_t& distance (problem ().distance ());
       const std::size_t K = 7;
-      value_type distance;
+      value_type d;
+      ConnectionCandidates_t candidates;
       for (core::Nodes_t::const_iterator itn1 = nodes.begin ();
           itn1 != nodes.end (); ++itn1) {
         ConfigurationPtr_t q1 ((*itn1)->configuration ());
-        connectSucceed = false;
+        // Components already holding this exact configuration are
+        // skipped. The lookup goes through the hash index of the
+        // roadmap, not a scan of the component nodes.
+        const RoadmapNodePtr_t duplicate =
+          roadmap_->nodeWithConfiguration (*q1);
         for (core::ConnectedComponents_t::const_iterator itcc =
             roadmap ()->connectedComponents ().begin ();
             itcc != roadmap ()->connectedComponents ().end (); ++itcc) {
           if (*itcc == (*itn1)->connectedComponent ())
             continue;
+          if (duplicate && duplicate != *itn1 &&
+              duplicate->connectedComponent () == *itcc)
+            continue;
           core::Nodes_t knearest = roadmap()->nearestNeighbor ()
-            ->KnearestSearch (q1, *itcc, K, distance);
+            ->KnearestSearch (q1, *itcc, K, d);
           for (core::Nodes_t::const_iterator itn2 = knearest.begin ();
-              itn2 != knearest.end (); ++itn2) {
-            bool _1to2 = (*itn1)->isOutNeighbor (*itn2);
-            bool _2to1 = (*itn1)->isInNeighbor (*itn2);
-            if (_1to2 && _2to1) {
-              hppDout (info, "the two nodes are already connected");
-              continue;
-            }
-            ConfigurationPtr_t q2 ((*itn2)->configuration ());
-            assert (*q1 != *q2);
-            path = (*sm) (*q1, *q2);
-            if (!path) continue;
-            if (pathProjector) {
-              if (!pathProjector->apply (path, projPath)) continue;
-            } else projPath = path;
-	    PathValidationReportPtr_t report;
-            if (pathValidation->validate (projPath, false, validPath, report)) {
-              nbConnection++;
-              if (!_1to2) roadmap ()->addEdge (*itn1, *itn2, projPath);
-              if (!_2to1) {
-                core::interval_t timeRange = projPath->timeRange ();
-                roadmap ()->addEdge (*itn2, *itn1, projPath->extract
-                    (core::interval_t (timeRange.second,
-                                       timeRange.first)));
-              }
-              connectSucceed = true;
-              break;
-            }
-          }
-          if (connectSucceed) break;
+              itn2 != knearest.end (); ++itn2)
+            candidates.push_back (ConnectionCandidate (*itn1, *itn2,
+                  memoizedDistance (distance, *itn1, *itn2)));
         }
       }
-      return nbConnection;
+      return attemptConnections (candidates, attempted);
     }
 
-    inline std::size_t ManipulationPlanner::tryConnectNewNodes (const core::Nodes_t nodes)
+    inline std::size_t ManipulationPlanner::tryConnectNewNodes
+      (const core::Nodes_t nodes, NodePairs_t& attempted)
     {
-      const core::SteeringMethodPtr_t& sm (problem ().steeringMethod ());
-      core::PathValidationPtr_t pathValidation (problem ().pathValidation ());
-      PathProjectorPtr_t pathProjector (problem().pathProjector ());
-      core::PathPtr_t path, projPath, validPath;
-      graph::GraphPtr_t graph = problem_.constraintGraph ();
-      std::size_t nbConnection = 0;
+      const core::DistancePtr_t& distance (problem ().distance ());
+      ConnectionCandidates_t candidates;
       for (core::Nodes_t::const_iterator itn1 = nodes.begin ();
           itn1 != nodes.end (); ++itn1) {
-        ConfigurationPtr_t q1 ((*itn1)->configuration ());
         for (core::Nodes_t::const_iterator itn2 = boost::next (itn1);
             itn2 != nodes.end (); ++itn2) {
           if ((*itn1)->connectedComponent () == (*itn2)->connectedComponent ())
             continue;
-          bool _1to2 = (*itn1)->isOutNeighbor (*itn2);
-          bool _2to1 = (*itn1)->isInNeighbor (*itn2);
-          if (_1to2 && _2to1) {
-            hppDout (info, "the two nodes are already connected");
-            continue;
-          }
-          ConfigurationPtr_t q2 ((*itn2)->configuration ());
-          assert (*q1 != *q2);
-          path = (*sm) (*q1, *q2);
-          if (!path) continue;
-          if (pathProjector) {
-            if (!pathProjector->apply (path, projPath)) continue;
-          } else projPath = path;
-          PathValidationReportPtr_t report;
-          if (pathValidation->validate (projPath, false, validPath, report)) {
-            nbConnection++;
-            if (!_1to2) roadmap ()->addEdge (*itn1, *itn2, projPath);
-            if (!_2to1) {
-              core::interval_t timeRange = projPath->timeRange ();
-              roadmap ()->addEdge (*itn2, *itn1, projPath->extract
-                  (core::interval_t (timeRange.second,
-                                     timeRange.first)));
-            }
-          }
+          candidates.push_back (ConnectionCandidate (*itn1, *itn2,
+                memoizedDistance (distance, *itn1, *itn2)));
         }
       }
-      return nbConnection;
+      return attemptConnections (candidates, attempted);
     }
 
     ManipulationPlanner::ManipulationPlanner (const Problem& problem,
@@ -450,13 +1004,128 @@ namespace hpp {
       shooter_ (problem.configurationShooter()),
       problem_ (problem), roadmap_ (roadmap),
       extendStep_ (problem.getParameter<value_type>("ManipulationPlanner/ExtendStep", 1)),
-      qProj_ (problem.robot ()->configSize ())
-    {}
+      greedyDepth_ (std::max<size_type> (1, problem.getParameter<size_type>("ManipulationPlanner/GreedyDepth", 1))),
+      batchSize_ (std::max<size_type> (1, problem.getParameter<size_type>("ManipulationPlanner/BatchSize", 1))),
+      nbThreads_ (problem.getParameter<size_type>("ManipulationPlanner/NumberOfThreads", 1)),
+      projectionFloor_ (problem.getParameter<value_type>("ManipulationPlanner/ProjectionFloor", 0)),
+      pipelineValidation_ (problem.getParameter<bool>("ManipulationPlanner/PipelineValidation", false)),
+      sharedRoadmap_ (problem.getParameter<bool>("ManipulationPlanner/SharedRoadmap", false)),
+      publishPeriod_ (problem.getParameter<size_type>("ManipulationPlanner/PublishPeriod", 10)),
+      stepsSincePublish_ (0),
+      adaptWeightsPeriod_ (problem.getParameter<size_type>("ManipulationPlanner/AdaptWeightsPeriod", 0)),
+      weightFloor_ (problem.getParameter<value_type>("ManipulationPlanner/WeightFloor", 0.1)),
+      stepsSinceWeightUpdate_ (0),
+      timeBudget_ (problem.getParameter<value_type>("ManipulationPlanner/TimeBudget", 0)),
+      iterationBudget_ (problem.getParameter<size_type>("ManipulationPlanner/IterationBudget", 0)),
+      iterationsDone_ (0), backgroundThread_ (NULL), stopBackground_ (false),
+      telemetry_ ((std::size_t) (nbThreads_ < 1 ? 1 : nbThreads_))
+    {
+      growWorkerPools (1);
+      if (sharedRoadmap_ && adaptWeightsPeriod_ > 0) {
+        // State::updateWeight rebuilds the neighbor tables and the
+        // alias table in place, and the other planner instances sample
+        // them through chooseEdge with no lock: the combination is
+        // unsound, so adaptation is disabled.
+        hppDout (warning, "ManipulationPlanner/AdaptWeightsPeriod is "
+            "ignored when ManipulationPlanner/SharedRoadmap is set: "
+            "the planners sharing the graph read the sampling tables "
+            "concurrently.");
+        adaptWeightsPeriod_ = 0;
+      }
+      if (problem.getParameter ("ManipulationPlanner/DeferHistograms", false))
+        roadmap_->deferHistogramUpdates (true);
+      const std::string recordPath = problem.getParameter<std::string>
+        ("ManipulationPlanner/RecordLog", std::string ());
+      if (!recordPath.empty ())
+        recordLog_ = DecisionLogWriterPtr_t (new DecisionLogWriter
+            (recordPath, problem.robot ()->configSize ()));
+      const std::string replayPath = problem.getParameter<std::string>
+        ("ManipulationPlanner/ReplayLog", std::string ());
+      if (!replayPath.empty ())
+        replayLog_ = DecisionLogReaderPtr_t (new DecisionLogReader
+            (replayPath));
+      const std::string leafDbPath = problem.getParameter<std::string>
+        ("LevelSetEdge/LeafDatabase", std::string ());
+      if (!leafDbPath.empty ()) {
+        leafDatabase_ = LeafDatabasePtr_t (new LeafDatabase
+            (leafDbPath, problem.constraintGraph ()));
+        leafDatabase_->preload ();
+      }
+    }
+
+    ManipulationPlanner::~ManipulationPlanner ()
+    {
+      stopBackground ();
+      if (leafDatabase_) leafDatabase_->save ();
+    }
 
     void ManipulationPlanner::init (const ManipulationPlannerWkPtr_t& weak)
     {
       core::PathPlanner::init (weak);
       weakPtr_ = weak;
     }
+
+    void ManipulationPlanner::startSolve ()
+    {
+      core::PathPlanner::startSolve ();
+      solveStart_ = boost::posix_time::microsec_clock::universal_time ();
+      iterationsDone_ = 0;
+    }
+
+    void ManipulationPlanner::continueInBackground ()
+    {
+      boost::mutex::scoped_lock lock (backgroundMutex_);
+      if (backgroundThread_) return;
+      stopBackground_ = false;
+      backgroundThread_ = new boost::thread
+        (boost::bind (&ManipulationPlanner::backgroundWorker, this));
+    }
+
+    core::PathVectorPtr_t ManipulationPlanner::bestPath () const
+    {
+      boost::mutex::scoped_lock lock (backgroundMutex_);
+      return bestPath_;
+    }
+
+    void ManipulationPlanner::stopBackground ()
+    {
+      boost::thread* thread = NULL;
+      {
+        boost::mutex::scoped_lock lock (backgroundMutex_);
+        stopBackground_ = true;
+        std::swap (thread, backgroundThread_);
+      }
+      if (thread) {
+        interrupt ();
+        thread->join ();
+        delete thread;
+      }
+    }
+
+    void ManipulationPlanner::backgroundWorker ()
+    {
+      try {
+        while (true) {
+          {
+            boost::mutex::scoped_lock lock (backgroundMutex_);
+            if (stopBackground_) return;
+          }
+          // Extract the path through the current roadmap - this is the
+          // full solve on the first iteration - then grow the roadmap a
+          // bit more before the next extraction.
+          core::PathVectorPtr_t path = solve ();
+          {
+            boost::mutex::scoped_lock lock (backgroundMutex_);
+            if (path && (!bestPath_ || path->length () < bestPath_->length ()))
+              bestPath_ = path;
+            if (stopBackground_) return;
+          }
+          oneStep ();
+        }
+      } catch (const std::exception& e) {
+        // Budget exhaustion and interruption both end up here.
+        hppDout (info, "Background planning stopped: " << e.what ());
+      }
+    }
   } // namespace manipulation
 } // namespace hpp
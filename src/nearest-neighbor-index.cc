@@ -0,0 +1,225 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/manipulation/nearest-neighbor-index.hh>
+
+#include <algorithm>
+#include <limits>
+
+#include <hpp/util/pointer.hh>
+
+#include <hpp/core/distance.hh>
+
+#include <hpp/manipulation/roadmap-node.hh>
+#include <hpp/manipulation/weighed-distance.hh>
+
+namespace hpp {
+  namespace manipulation {
+    /// A cell is either a leaf holding up to bucketSize_ nodes, with their
+    /// configurations packed column-major in a contiguous block so that
+    /// distances are evaluated with the batched kernel, or a split cell
+    /// whose pivot and radius partition its subtree: nodes closer to the
+    /// pivot than radius_ go in inside_, the other ones in outside_.
+    struct NearestNeighborIndex::Cell
+    {
+      Cell () : pivot (NULL), radius (-1), inside (NULL), outside (NULL) {}
+
+      bool leaf () const { return pivot == NULL; }
+
+      RoadmapNodePtr_t pivot;
+      value_type radius;
+      Cell* inside;
+      Cell* outside;
+
+      /// Leaf storage. configs.col(i) is the configuration of bucket[i].
+      RoadmapNodes_t bucket;
+      matrix_t configs;
+    }; // struct NearestNeighborIndex::Cell
+
+    NearestNeighborIndex::NearestNeighborIndex
+    (const core::DistancePtr_t& distance) :
+      distance_ (distance),
+      weighedDistance_ (HPP_DYNAMIC_PTR_CAST (WeighedDistance, distance)),
+      root_ (NULL), size_ (0)
+    {}
+
+    NearestNeighborIndex::~NearestNeighborIndex ()
+    {
+      destroy (root_);
+    }
+
+    void NearestNeighborIndex::insert (const RoadmapNodePtr_t& node)
+    {
+      insert (root_, node);
+      ++size_;
+    }
+
+    void NearestNeighborIndex::insert (Cell*& cell,
+        const RoadmapNodePtr_t& node)
+    {
+      if (!cell) cell = new Cell ();
+      if (!cell->leaf ()) {
+        const value_type d = (*distance_) (*cell->pivot->configuration (),
+                                           *node->configuration ());
+        if (d <= cell->radius) insert (cell->inside, node);
+        else                   insert (cell->outside, node);
+        return;
+      }
+      append (cell, node);
+      if (cell->bucket.size () > bucketSize_) split (cell);
+    }
+
+    void NearestNeighborIndex::append (Cell* cell,
+        const RoadmapNodePtr_t& node)
+    {
+      const Configuration_t& q = *node->configuration ();
+      if (cell->configs.size () == 0)
+        cell->configs.resize (q.size (), (size_type) (bucketSize_ + 1));
+      cell->configs.col ((size_type) cell->bucket.size ()) = q;
+      cell->bucket.push_back (node);
+    }
+
+    void NearestNeighborIndex::split (Cell* cell)
+    {
+      // The first node of the bucket becomes the pivot, the other ones are
+      // partitioned around the median of their distances to it.
+      const std::size_t n = cell->bucket.size () - 1;
+      cell->pivot = cell->bucket[0];
+      vector_t ds ((size_type) n);
+      if (weighedDistance_)
+        weighedDistance_->distances (cell->configs.rightCols
+            (cell->configs.cols () - 1), n,
+            *cell->pivot->configuration (), ds);
+      else {
+        for (std::size_t i = 0; i < n; ++i)
+          ds[(size_type) i] = (*distance_)
+            (cell->configs.col ((size_type) (i + 1)),
+             *cell->pivot->configuration ());
+      }
+      std::vector <value_type> sorted (ds.data (), ds.data () + n);
+      std::nth_element (sorted.begin (), sorted.begin () + n / 2,
+          sorted.end ());
+      cell->radius = sorted[n / 2];
+      for (std::size_t i = 0; i < n; ++i) {
+        Cell*& side = (ds[(size_type) i] <= cell->radius) ? cell->inside
+                                                          : cell->outside;
+        if (!side) side = new Cell ();
+        append (side, cell->bucket[i + 1]);
+      }
+      RoadmapNodes_t ().swap (cell->bucket);
+      matrix_t ().swap (cell->configs);
+    }
+
+    RoadmapNodePtr_t NearestNeighborIndex::nearest (const Configuration_t& q,
+        value_type& minDistance) const
+    {
+      RoadmapNodePtr_t closest = NULL;
+      minDistance = std::numeric_limits <value_type>::infinity ();
+      search (root_, q, closest, minDistance);
+      return closest;
+    }
+
+    void NearestNeighborIndex::search (const Cell* cell,
+        const Configuration_t& q, RoadmapNodePtr_t& closest,
+        value_type& minDistance) const
+    {
+      if (!cell) return;
+      if (cell->leaf ()) {
+        const std::size_t n = cell->bucket.size ();
+        if (n == 0) return;
+        if (weighedDistance_) {
+          vector_t ds ((size_type) n);
+          weighedDistance_->distances (cell->configs, n, q, ds);
+          for (std::size_t i = 0; i < n; ++i) {
+            if (ds[(size_type) i] < minDistance) {
+              minDistance = ds[(size_type) i];
+              closest = cell->bucket[i];
+            }
+          }
+        } else {
+          for (std::size_t i = 0; i < n; ++i) {
+            const value_type d = (*distance_)
+              (cell->configs.col ((size_type) i), q);
+            if (d < minDistance) {
+              minDistance = d;
+              closest = cell->bucket[i];
+            }
+          }
+        }
+        return;
+      }
+      const value_type d = (*distance_) (*cell->pivot->configuration (), q);
+      if (d < minDistance) {
+        minDistance = d;
+        closest = cell->pivot;
+      }
+      // Visit the side containing q first, prune the other one with the
+      // triangle inequality.
+      if (d <= cell->radius) {
+        search (cell->inside, q, closest, minDistance);
+        if (cell->radius - d <= minDistance)
+          search (cell->outside, q, closest, minDistance);
+      } else {
+        search (cell->outside, q, closest, minDistance);
+        if (d - cell->radius <= minDistance)
+          search (cell->inside, q, closest, minDistance);
+      }
+    }
+
+    void NearestNeighborIndex::merge (const NearestNeighborIndexPtr_t& other)
+    {
+      if (!other || other->size_ == 0) return;
+      // Re-insert the nodes of the smaller index into the larger one.
+      if (other->size_ > size_) {
+        std::swap (root_, other->root_);
+        std::swap (size_, other->size_);
+      }
+      RoadmapNodes_t nodes;
+      nodes.reserve (other->size_);
+      collect (other->root_, nodes);
+      other->root_ = NULL;
+      other->size_ = 0;
+      for (RoadmapNodes_t::const_iterator it = nodes.begin ();
+          it != nodes.end (); ++it)
+        insert (*it);
+    }
+
+    void NearestNeighborIndex::clear ()
+    {
+      destroy (root_);
+      root_ = NULL;
+      size_ = 0;
+    }
+
+    void NearestNeighborIndex::collect (Cell* cell, RoadmapNodes_t& nodes)
+    {
+      if (!cell) return;
+      if (cell->pivot) nodes.push_back (cell->pivot);
+      nodes.insert (nodes.end (), cell->bucket.begin (), cell->bucket.end ());
+      collect (cell->inside, nodes);
+      collect (cell->outside, nodes);
+      delete cell;
+    }
+
+    void NearestNeighborIndex::destroy (Cell* cell)
+    {
+      if (!cell) return;
+      destroy (cell->inside);
+      destroy (cell->outside);
+      delete cell;
+    }
+  } // namespace manipulation
+} // namespace hpp
@@ -21,6 +21,7 @@
 #include <hpp/core/path.hh>
 #include <hpp/core/config-projector.hh>
 #include <hpp/manipulation/device.hh>
+#include <hpp/manipulation/graph/graph.hh>
 #include <hpp/manipulation/graph/state.hh>
 #include <hpp/manipulation/graph/edge.hh>
 #include <hpp/manipulation/constraint-set.hh>
@@ -47,11 +48,21 @@ namespace hpp {
 
         reverse = reverseB;
 
-        ConfigProjectorPtr_t p = ConfigProjector::create (graph->robot(),
-            "intersect_" + setB->edge()->name() + "_" + setA->edge()->name(),
-            graph->errorThreshold (), graph->maxIterations ());
+        // The set of adjacent edge pairs is fixed by the graph: the
+        // intersection projector is compiled once per pair and cached on
+        // the graph, so repeated optimizer runs only reset its right
+        // hand side.
+        ConfigProjectorPtr_t p = graph->sharedIntersectionProjector
+          (setB->edge (), setA->edge ());
+        if (!p) {
+          p = ConfigProjector::create (graph->robot(),
+              "intersect_" + setB->edge()->name() + "_" + setA->edge()->name(),
+              graph->errorThreshold (), graph->maxIterations ());
 
-        setB->edge()->intersectionConstraint (setA->edge (), p);
+          setB->edge()->intersectionConstraint (setA->edge (), p);
+          graph->addSharedIntersectionProjector (setB->edge (), setA->edge (),
+              p);
+        }
 
         p->rightHandSideFromConfig (before->end ());
         return p;
@@ -16,6 +16,12 @@
 
 #include <hpp/manipulation/path-optimization/keypoints.hh>
 
+#include <algorithm>
+#include <set>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/functional/hash.hpp>
+
 #include <hpp/core/path.hh>
 #include <hpp/core/path-vector.hh>
 #include <hpp/core/path-projector.hh>
@@ -31,30 +37,89 @@ namespace hpp {
     namespace pathOptimization {
       using std::make_pair;
 
+      namespace {
+        std::size_t configurationHash (const Configuration_t& q)
+        {
+          std::size_t seed = 0;
+          for (size_type i = 0; i < q.size (); ++i)
+            boost::hash_combine (seed, q[i]);
+          return seed;
+        }
+      }
+
       PathVectorPtr_t Keypoints::optimize (const PathVectorPtr_t& path)
       {
+        // The memoized validation results are only valid while the
+        // environment does not change: scope the cache to this run, so
+        // a reused optimizer does not return outcomes computed against
+        // the obstacles of a previous call.
+        validationCache_.clear ();
         PathVectorPtr_t input = PathVector::create (
-              path->outputSize(), path->outputDerivativeSize()); 
+              path->outputSize(), path->outputDerivativeSize());
         PathVectorPtr_t output = path;
         path->flatten (input);
         // Step 1: find the key waypoints
-        // paths is a vector of 
+        // paths is a vector of
         IKPvector_t paths = split (input);
 
         // Step 2: for each couple of consecutive path between keywaypoints,
         //         try to find a better intermediate key waypoint.
-        std::size_t i1 = 0;
+        //         The pairs are tried by decreasing length of the portion
+        //         they could remove: under a fixed post-processing budget,
+        //         the largest expected gains must come first.
         bool success = false;
-        for (std::size_t i2 = 1; i2 < paths.size(); ++i2) {
-          if (paths[i2].isShort) continue; // So that i2 = i1 + 2
-          // Try to generate a new key waypoint
-          PathVectorPtr_t shortcut = shorten (paths, i1, i2);
-          if (shortcut) {
-            paths = replaceInPath (paths, shortcut, i1, i2);
-            success = true;
-            while (i2 < paths.size() && !paths[i2].isShort) ++i2;
+        const value_type timeBudget = problem ().getParameter <value_type>
+          ("Keypoints/TimeBudget", 0);
+        const boost::posix_time::ptime tStart =
+          boost::posix_time::microsec_clock::universal_time ();
+        // (candidate pair, length of the portion it spans)
+        typedef std::pair <value_type, std::pair <std::size_t, std::size_t> >
+          Candidate_t;
+        // Pairs already tried, identified by their edges and spanned
+        // length so that the bookkeeping survives the index shifts of
+        // replaceInPath. Only a successful shortcut changes the key of
+        // the surrounding pairs, which thus get one more try.
+        typedef std::pair <const graph::Edge*, const graph::Edge*> EdgePair_t;
+        std::set <std::pair <EdgePair_t, value_type> > attempted;
+        bool rescan = true;
+        while (rescan) {
+          rescan = false;
+          std::vector <Candidate_t> candidates;
+          std::size_t i1 = 0;
+          for (std::size_t i2 = 1; i2 < paths.size(); ++i2) {
+            if (paths[i2].isShort) continue; // So that i2 = i1 + 2
+            value_type gain = 0;
+            for (std::size_t i = i1; i < i2 + 1; ++i)
+              gain += paths[i].path->length ();
+            candidates.push_back (Candidate_t (gain, make_pair (i1, i2)));
+            i1 = i2;
+          }
+          std::sort (candidates.begin (), candidates.end (),
+              std::greater <Candidate_t> ());
+          for (std::size_t c = 0; c < candidates.size (); ++c) {
+            if (timeBudget > 0) {
+              const value_type elapsed = (value_type)
+                (boost::posix_time::microsec_clock::universal_time () - tStart)
+                .total_milliseconds () / 1000;
+              if (elapsed > timeBudget) { rescan = false; break; }
+            }
+            const std::size_t j1 = candidates[c].second.first,
+                              j2 = candidates[c].second.second;
+            const std::pair <EdgePair_t, value_type> key (
+                EdgePair_t (paths[j1].edge.get (), paths[j2].edge.get ()),
+                candidates[c].first);
+            if (!attempted.insert (key).second) continue;
+            // Try to generate a new key waypoint
+            PathVectorPtr_t shortcut = shorten (paths, j1, j2);
+            if (shortcut) {
+              paths = replaceInPath (paths, shortcut, j1, j2);
+              success = true;
+              // The indices of the remaining candidates are stale:
+              // rescan the rewritten path and reorder what is left.
+              rescan = true;
+              break;
+            }
           }
-          i1 = i2;
         }
 
         if (success) {
@@ -78,13 +143,13 @@ namespace hpp {
               input->outputSize(), input->outputDerivativeSize()); 
           PathPtr_t current = input->pathAtRank (i_s);
           ikpp.path->appendPath (current);
-          c = HPP_DYNAMIC_PTR_CAST (ConstraintSet, current->constraints ());
+          c = ConstraintSet::cast (current->constraints ());
           if (c) ikpp.edge = c->edge ();
           ikpp.isShort = ikpp.edge && ikpp.edge->isShort();
           std::size_t i_e = i_s + 1;
           for (; i_e < input->numberPaths (); ++i_e) {
             current = input->pathAtRank (i_e);
-            c = HPP_DYNAMIC_PTR_CAST (ConstraintSet, current->constraints ());
+            c = ConstraintSet::cast (current->constraints ());
             if (!c && ikpp.edge) {
               hppDout(info, "No manipulation::ConstraintSet");
               break;
@@ -112,7 +177,6 @@ namespace hpp {
 
         const core::SteeringMethodPtr_t& sm (problem_.steeringMethod ());
         PathProjectorPtr_t pathProjector (problem().pathProjector ());
-        core::PathValidationPtr_t pathValidation (problem ().pathValidation ());
 
         // Get all the possible edges of the graph.
         const InterKeypointPath& ikpp1 = paths[i1];
@@ -131,10 +195,6 @@ namespace hpp {
                         q1 (ikpp1.path->outputSize()),
                         q4 (ikpp1.path->outputSize());
 
-        // Unused variables
-        PathValidationReportPtr_t report;
-        PathPtr_t unusedP;
-
         for (std::size_t n1 = 0; n1 < maxTrials; ++n1) {
           // Generate a random parameter on p1.
           t0 = ikpp1.path->timeRange().first;
@@ -151,7 +211,7 @@ namespace hpp {
               PathPtr_t short1, proj1;
               if ((*_edges)->build (short1, q1, q)) {
                 if (!short1 || !pathProjector->apply(short1, proj1)) continue;
-                if (!pathValidation->validate (proj1, false, unusedP, report)) continue;
+                if (!validateWithCache (proj1, *_edges, q1, q)) continue;
 
                 // short1 is a valid path leading to the target node.
                 // Try to connect this to ikpp2.path
@@ -164,7 +224,8 @@ namespace hpp {
                   PathPtr_t short2, proj2;
                   short2 = (*sm)(q, q4);
                   if (!short2 || !pathProjector->apply(short2, proj2)) continue;
-                  if (!pathValidation->validate (proj2, false, unusedP, report)) continue;
+                  if (!validateWithCache (proj2, graph::EdgePtr_t (), q, q4))
+                    continue;
                   // short2 is possible. Build the path and check it is shorter.
 
                   PathVectorPtr_t tmp = PathVector::create (ikpp1.path->outputSize (),
@@ -188,6 +249,35 @@ namespace hpp {
         return result;
       }
 
+      bool Keypoints::validateWithCache (const PathPtr_t& path,
+          const graph::EdgePtr_t& edge,
+          const Configuration_t& q1, const Configuration_t& q2) const
+      {
+        std::size_t key = configurationHash (q1);
+        boost::hash_combine (key, configurationHash (q2));
+        boost::hash_combine (key, edge.get ());
+        const std::pair <ValidationCache_t::const_iterator,
+              ValidationCache_t::const_iterator> range =
+          validationCache_.equal_range (key);
+        for (ValidationCache_t::const_iterator it = range.first;
+            it != range.second; ++it) {
+          const ValidatedSegment& vs = it->second;
+          if (vs.edge == edge && vs.q1 == q1 && vs.q2 == q2)
+            return vs.valid;
+        }
+        // Unused variables
+        PathValidationReportPtr_t report;
+        PathPtr_t unusedP;
+        ValidatedSegment vs;
+        vs.edge = edge;
+        vs.q1 = q1;
+        vs.q2 = q2;
+        vs.valid = problem ().pathValidation ()->validate
+          (path, false, unusedP, report);
+        validationCache_.insert (make_pair (key, vs));
+        return vs.valid;
+      }
+
       Keypoints::IKPvector_t Keypoints::replaceInPath(const IKPvector_t& input,
           const PathVectorPtr_t& shortcut,
           std::size_t i1, std::size_t i2) const
@@ -23,6 +23,7 @@
 
 #include <hpp/manipulation/graph/edge.hh>
 #include <hpp/manipulation/constraint-set.hh>
+#include <hpp/manipulation/flattened-path.hh>
 #include <hpp/manipulation/graph-path-validation.hh>
 
 namespace hpp {
@@ -33,10 +34,10 @@ namespace hpp {
         PathVectorPtr_t
           opted = PathVector::create (path->outputSize(),
                                       path->outputDerivativeSize()),
-          flat =  PathVector::create (path->outputSize(),
-                                      path->outputDerivativeSize()),
           toConcat;
-        path->flatten (flat);
+        // Flattened view over the input: the leaves are indexed once
+        // instead of being copied into an intermediate path vector.
+        FlattenedPath flat (path);
 
         GraphPathValidationPtr_t gpv = HPP_DYNAMIC_PTR_CAST (GraphPathValidation,
             this->problem().pathValidation ());
@@ -47,27 +48,46 @@ namespace hpp {
         wholebodyStep::SmallSteps& step (*stepPtr);
         step.leftHand_.active = true;
 
+        // As long as the groups match the cache of the previous call -
+        // same subpath objects, in order - their timing solution is
+        // reused; the generator runs again from the first divergence.
+        bool stillPrefix = incremental_;
+        GroupCache_t newCache;
+
         ConstraintSetPtr_t c;
-        for (std::size_t i_s = 0; i_s < flat->numberPaths ();) {
+        for (std::size_t i_s = 0; i_s < flat.numberPaths ();) {
           PathVectorPtr_t toOpt = PathVector::create (
-              path->outputSize(), path->outputDerivativeSize()); 
-          PathPtr_t current = flat->pathAtRank (i_s);
+              path->outputSize(), path->outputDerivativeSize());
+          CachedGroup_t group;
+          PathPtr_t current = flat.pathAtRank (i_s);
           toOpt->appendPath (current);
+          group.inputs.push_back (current);
           graph::EdgePtr_t edge;
-          c = HPP_DYNAMIC_PTR_CAST (ConstraintSet, current->constraints ());
+          c = ConstraintSet::cast (current->constraints ());
           if (c) edge = c->edge ();
           std::size_t i_e = i_s + 1;
-          for (; i_e < flat->numberPaths (); ++i_e) {
-            current = flat->pathAtRank (i_e);
-            c = HPP_DYNAMIC_PTR_CAST (ConstraintSet, current->constraints ());
+          for (; i_e < flat.numberPaths (); ++i_e) {
+            current = flat.pathAtRank (i_e);
+            c = ConstraintSet::cast (current->constraints ());
             if (!c && edge) break;
             if (c && edge->state() != c->edge ()->state()) break;
             toOpt->appendPath (current);
+            group.inputs.push_back (current);
+          }
+          const std::size_t g = newCache.size ();
+          if (stillPrefix && g < cache_.size ()
+              && cache_[g].inputs == group.inputs) {
+            toConcat = cache_[g].output;
+          } else {
+            stillPrefix = false;
+            toConcat = step.optimize (toOpt);
           }
-          toConcat = step.optimize (toOpt);
+          group.output = toConcat;
+          newCache.push_back (group);
           i_s = i_e;
           opted->concatenate (toConcat);
         }
+        if (incremental_) cache_.swap (newCache);
 
         const_cast <core::Problem&>(this->problem ()).pathValidation (gpv);
         return opted;
@@ -16,6 +16,11 @@
 
 #include <hpp/manipulation/path-optimization/spline-gradient-based.hh>
 
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <hpp/core/path-optimization/spline-gradient-based/linear-constraint.hh>
 
 #include <hpp/manipulation/constraint-set.hh>
@@ -25,6 +30,33 @@
 namespace hpp {
   namespace manipulation {
     namespace pathOptimization {
+      namespace {
+        /// One state membership query of addProblemConstraints. Queries
+        /// are distributed over workers by state id so that the
+        /// projector of a given state is only ever used by one worker.
+        struct ContainsJob_t {
+          graph::StatePtr_t state;
+          const Configuration_t* q;
+          bool* result;
+          ContainsJob_t (const graph::StatePtr_t& s,
+              const Configuration_t* q_, bool* r) :
+            state (s), q (q_), result (r) {}
+        };
+        typedef std::vector <ContainsJob_t> ContainsJobs_t;
+
+        /// Results of the four membership checks of one spline.
+        struct Memberships_t {
+          bool src_q0, dst_q0, src_q1, dst_q1;
+        };
+
+        void containsWorker (const ContainsJobs_t& jobs,
+            const std::size_t rank, const std::size_t step)
+        {
+          for (std::size_t i = 0; i < jobs.size (); ++i)
+            if (jobs[i].state->id () % step == rank)
+              *jobs[i].result = jobs[i].state->contains (*jobs[i].q);
+        }
+      }
 
       template <int _PB, int _SO>
       SplineGradientBased<_PB, _SO>::SplineGradientBased (const Problem& problem)
@@ -77,14 +109,53 @@ namespace hpp {
         bool zeroDerivative = this->problem().getParameter ("SplineGradientBased/zeroDerivativesAtStateIntersection", false);
 
         const std::size_t last = splines.size() - 1;
-        graph::StatePtr_t stateOfStart;
+
+        // The state membership checks each run a numerical evaluation of
+        // the state constraints and are independent across splines: when
+        // more than one worker is requested they are distributed over a
+        // thread pool, grouped by state so that a given state's
+        // projector stays confined to one worker. The row assembly below
+        // chains stateOfStart from one spline to the next and remains
+        // sequential.
+        const size_type nbThreads = this->problem().getParameter
+          ("SplineGradientBased/NumberOfThreads", size_type (1));
+        std::vector <graph::EdgePtr_t> transitions (last);
+        std::vector <Configuration_t> q0s (last), q1s (last);
+        std::vector <Memberships_t> memberships (last);
+        ContainsJobs_t jobs;
+        jobs.reserve (4 * last);
         for (std::size_t i = 0; i < last; ++i) {
-          core::PathPtr_t path = init->pathAtRank(i);
           ConstraintSetPtr_t set = HPP_STATIC_PTR_CAST (ConstraintSet, splines[i]->constraints ());
           if (!set || !set->edge())
             std::invalid_argument ("Cannot optimize a path that has not been "
                 "generated with a graph.");
-          graph::EdgePtr_t transition = set->edge();
+          transitions[i] = set->edge();
+          core::PathPtr_t path = init->pathAtRank(i);
+          q0s[i] = path->initial ();
+          q1s[i] = path->end ();
+          jobs.push_back (ContainsJob_t (transitions[i]->from (), &q0s[i],
+                &memberships[i].src_q0));
+          jobs.push_back (ContainsJob_t (transitions[i]->to   (), &q0s[i],
+                &memberships[i].dst_q0));
+          jobs.push_back (ContainsJob_t (transitions[i]->from (), &q1s[i],
+                &memberships[i].src_q1));
+          jobs.push_back (ContainsJob_t (transitions[i]->to   (), &q1s[i],
+                &memberships[i].dst_q1));
+        }
+        if (nbThreads <= 1) {
+          containsWorker (jobs, 0, 1);
+        } else {
+          boost::thread_group workers;
+          for (std::size_t rank = 0; rank < (std::size_t) nbThreads; ++rank)
+            workers.create_thread (boost::bind (containsWorker,
+                  boost::cref (jobs), rank, (std::size_t) nbThreads));
+          workers.join_all ();
+        }
+
+        graph::StatePtr_t stateOfStart;
+        for (std::size_t i = 0; i < last; ++i) {
+          core::PathPtr_t path = init->pathAtRank(i);
+          graph::EdgePtr_t transition = transitions[i];
 
           this->addProblemConstraintOnPath (path, i, splines[i], lc, ss[i]);
 
@@ -95,12 +166,10 @@ namespace hpp {
           graph::StatePtr_t to = transition->to();
           graph::StatePtr_t from2 = from, to2 = to;
 
-          Configuration_t q0 = path->initial (),
-                          q1 = path->end ();
-          const bool src_contains_q0 = from->contains (q0);
-          const bool dst_contains_q0 = to  ->contains (q0);
-          const bool src_contains_q1 = from->contains (q1);
-          const bool dst_contains_q1 = to  ->contains (q1);
+          const bool src_contains_q0 = memberships[i].src_q0;
+          const bool dst_contains_q0 = memberships[i].dst_q0;
+          const bool src_contains_q1 = memberships[i].src_q1;
+          const bool dst_contains_q1 = memberships[i].dst_q1;
 
           bool use_direct  = src_contains_q0 && dst_contains_q1;
           bool use_reverse = src_contains_q1 && dst_contains_q0;
@@ -110,7 +179,7 @@ namespace hpp {
             else if (stateOfStart == to)
               use_direct = false;
             else if (stateOfStart) {
-              if (stateOfStart->contains(q0))
+              if (stateOfStart->contains(q0s[i]))
                 use_reverse = false;
               else
                 use_direct = false; // assumes stateOfStart->contains(q0)
@@ -244,7 +313,7 @@ namespace hpp {
       // template class SplineGradientBased<core::path::CanonicalPolynomeBasis, 2>;
       // template class SplineGradientBased<core::path::CanonicalPolynomeBasis, 3>;
       template class SplineGradientBased<core::path::BernsteinBasis, 1>; // equivalent to StraightPath
-      // template class SplineGradientBased<core::path::BernsteinBasis, 2>;
+      template class SplineGradientBased<core::path::BernsteinBasis, 2>;
       template class SplineGradientBased<core::path::BernsteinBasis, 3>;
     } // namespace pathOptimization
   }  // namespace manipulation
@@ -134,7 +134,7 @@ namespace hpp {
       // parent_t::add <PathOptimizerBuilder_t> ("SplineGradientBased_cannonical2",pathOptimization::SplineGradientBased<core::path::CanonicalPolynomeBasis, 2>::createFromCore);
       // parent_t::add <PathOptimizerBuilder_t> ("SplineGradientBased_cannonical3",pathOptimization::SplineGradientBased<core::path::CanonicalPolynomeBasis, 3>::createFromCore);
       parent_t::add <PathOptimizerBuilder_t> ("SplineGradientBased_bezier1",pathOptimization::SplineGradientBased<core::path::BernsteinBasis, 1>::createFromCore);
-      // parent_t::add <PathOptimizerBuilder_t> ("SplineGradientBased_bezier2",pathOptimization::SplineGradientBased<core::path::BernsteinBasis, 2>::createFromCore);
+      parent_t::add <PathOptimizerBuilder_t> ("SplineGradientBased_bezier2",pathOptimization::SplineGradientBased<core::path::BernsteinBasis, 2>::createFromCore);
       parent_t::add <PathOptimizerBuilder_t> ("SplineGradientBased_bezier3",pathOptimization::SplineGradientBased<core::path::BernsteinBasis, 3>::createFromCore);
 
       using core::SteeringMethodBuilder_t;
@@ -196,6 +196,9 @@ namespace hpp {
       if (!constraintGraph_)
         throw std::runtime_error ("The graph is not defined.");
       initSteeringMethod();
+      if (problem_)
+        constraintGraph_->initializationThreads (problem_->getParameter
+            <size_type> ("Graph/InitializationThreads", 1));
       constraintGraph_->initialize();
     }
 
@@ -306,15 +309,17 @@ namespace hpp {
       if (!constraintGraph ()) {
         throw std::runtime_error ("The graph is not defined.");
       }
-      GripperPtr_t g = robot_->get <GripperPtr_t> (gripper);
+      GripperPtr_t g = robot_->gripper (robot_->gripperId (gripper));
       if (!g) throw std::runtime_error ("No gripper with name " + gripper + ".");
-      HandlePtr_t h = robot_->get <HandlePtr_t> (handle);
+      HandlePtr_t h = robot_->handle (robot_->handleId (handle));
       if (!h) throw std::runtime_error ("No handle with name " + handle + ".");
       const std::string cname = name + "/complement";
       const std::string bname = name + "/hold";
-      NumericalConstraintPtr_t constraint (h->createGrasp (g, name));
-      NumericalConstraintPtr_t complement (h->createGraspComplement (g, cname));
-      NumericalConstraintPtr_t both (h->createGraspAndComplement (g, bname));
+      // The memoized accessors share one constraint instance per
+      // (gripper, handle) pair with the graph construction helpers.
+      NumericalConstraintPtr_t constraint (h->grasp (g));
+      NumericalConstraintPtr_t complement (h->graspComplement (g));
+      NumericalConstraintPtr_t both (h->graspAndComplement (g));
       addNumericalConstraint ( name, constraint);
       addNumericalConstraint (cname, complement);
       addNumericalConstraint (bname, both);
@@ -325,13 +330,13 @@ namespace hpp {
     (const std::string& name, const std::string& gripper,
      const std::string& handle)
     {
-      GripperPtr_t g = robot_->get <GripperPtr_t> (gripper);
+      GripperPtr_t g = robot_->gripper (robot_->gripperId (gripper));
       if (!g) throw std::runtime_error ("No gripper with name " + gripper + ".");
-      HandlePtr_t h = robot_->get <HandlePtr_t> (handle);
+      HandlePtr_t h = robot_->handle (robot_->handleId (handle));
       if (!h) throw std::runtime_error ("No handle with name " + handle + ".");
 
       value_type c = h->clearance () + g->clearance ();
-      NumericalConstraintPtr_t constraint = h->createPreGrasp (g, c, name);
+      NumericalConstraintPtr_t constraint = h->pregrasp (g, c);
       addNumericalConstraint (name, constraint);
     }
 
@@ -349,8 +354,21 @@ namespace hpp {
     {
       if (!problem ())
         throw std::runtime_error ("The problem is not defined.");
-      if (roadmap())
+      if (roadmap()) {
+        // Warm reset: systems replanning many times on similar problems
+        // keep the same roadmap object, so the node pool blocks and the
+        // index buckets grown by the previous query are reused instead
+        // of being returned to the allocator and faulted in again.
+        RoadmapPtr_t current = HPP_DYNAMIC_PTR_CAST (Roadmap, roadmap ());
+        if (current && problem_ &&
+            problem_->getParameter<bool> ("Roadmap/WarmReset", false)) {
+          current->warmReset (true);
+          current->clear ();
+          if (constraintGraph_) current->constraintGraph (constraintGraph_);
+          return;
+        }
         roadmap()->clear();
+      }
       RoadmapPtr_t r (Roadmap::create (problem ()->distance (), problem ()->robot ()));
       if (constraintGraph_) r->constraintGraph (constraintGraph_);
       roadmap (r);
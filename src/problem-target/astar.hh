@@ -19,7 +19,9 @@
 #ifndef HPP_MANIPULATION_PROBLEM_TARGET_ASTAR_HH
 # define HPP_MANIPULATION_PROBLEM_TARGET_ASTAR_HH
 
+# include <algorithm>
 # include <limits>
+# include <vector>
 
 # include <hpp/util/exception-factory.hh>
 
@@ -32,6 +34,8 @@
 # include <hpp/manipulation/config.hh>
 # include <hpp/manipulation/roadmap.hh>
 # include <hpp/manipulation/roadmap-node.hh>
+# include <hpp/manipulation/graph/graph.hh>
+# include <hpp/manipulation/graph/state.hh>
 
 namespace hpp {
   namespace manipulation {
@@ -40,21 +44,48 @@ namespace hpp {
       {
         typedef core::PathVectorPtr_t PathVectorPtr_t;
         typedef core::EdgePtr_t EdgePtr_t;
-        typedef std::vector < RoadmapNodePtr_t > Nodes_t;
         typedef std::list < EdgePtr_t > Edges_t;
-        typedef std::map < core::NodePtr_t, EdgePtr_t> Parent_t;
-        Nodes_t closed_;
-        Nodes_t open_;
-        std::map <RoadmapNodePtr_t, value_type> costFromStart_;
-        std::map <RoadmapNodePtr_t, value_type> estimatedCostToGoal_;
-        Parent_t parent_;
+
+        /// Per-node search data, stored contiguously and addressed
+        /// through a dense index assigned when the node is first reached.
+        struct Record {
+          RoadmapNodePtr_t node;
+          EdgePtr_t parent;
+          value_type costFromStart;
+          value_type estimatedCost;
+          bool closed;
+
+          Record (const RoadmapNodePtr_t& n) : node (n), parent (),
+            costFromStart (std::numeric_limits <value_type>::max ()),
+            estimatedCost (std::numeric_limits <value_type>::max ()),
+            closed (false) {}
+        }; // struct Record
+        typedef std::map <RoadmapNodePtr_t, std::size_t> Indices_t;
+        typedef std::vector <Record> Records_t;
+        /// (estimated cost, record index), min-heap on the estimated cost.
+        typedef std::pair <value_type, std::size_t> HeapEntry_t;
+        struct HeapComp {
+          bool operator () (const HeapEntry_t& e1, const HeapEntry_t& e2) const
+          { return e1.first > e2.first; }
+        }; // struct HeapComp
+        typedef std::vector <HeapEntry_t> Heap_t;
+
+        Indices_t indices_;
+        Records_t records_;
+        Heap_t heap_;
         core::RoadmapPtr_t roadmap_;
         core::DistancePtr_t distance_;
         graph::StatePtr_t state_;
+        graph::GraphPtr_t graph_;
+        /// Lower bound on the length of a state-changing roadmap edge,
+        /// computed by findPath(). Scales the state hop counts of the
+        /// constraint graph into an admissible cost bound.
+        value_type minTransitionCost_;
 
         public:
         Astar (const core::RoadmapPtr_t& roadmap, const core::DistancePtr_t distance, graph::StatePtr_t state) :
-          roadmap_ (roadmap), distance_ (distance), state_ (state)
+          roadmap_ (roadmap), distance_ (distance), state_ (state),
+          graph_ (state->parentGraph ()), minTransitionCost_ (0)
         {
         }
 
@@ -64,9 +95,10 @@ namespace hpp {
           Edges_t edges;
 
           while (node) {
-            Parent_t::const_iterator itEdge = parent_.find (node);
-            if (itEdge != parent_.end ()) {
-              EdgePtr_t edge = itEdge->second;
+            Indices_t::const_iterator itNode = indices_.find
+              (static_cast <RoadmapNodePtr_t> (node));
+            if (itNode != indices_.end () && records_[itNode->second].parent) {
+              EdgePtr_t edge = records_[itNode->second].parent;
               edges.push_front (edge);
               node = edge->from ();
             }
@@ -85,59 +117,83 @@ namespace hpp {
         }
 
         private:
-        struct SortFunctor {
-          std::map <RoadmapNodePtr_t, value_type>& cost_;
-          SortFunctor (std::map <RoadmapNodePtr_t, value_type>& cost) :
-            cost_ (cost) {}
-          bool operator () (const RoadmapNodePtr_t& n1, const RoadmapNodePtr_t& n2)
-          {
-            return cost_ [n1] < cost_ [n2];
-          }
-        }; // struc SortFunctor
-
         bool isGoal (const RoadmapNodePtr_t node)
         {
           return node->graphState() == state_;
         }
 
+        std::size_t index (const RoadmapNodePtr_t& node)
+        {
+          std::pair <Indices_t::iterator, bool> ins = indices_.insert
+            (std::make_pair (node, records_.size ()));
+          if (ins.second) records_.push_back (Record (node));
+          return ins.first->second;
+        }
+
+        void push (const value_type& estimatedCost, const std::size_t& i)
+        {
+          heap_.push_back (HeapEntry_t (estimatedCost, i));
+          std::push_heap (heap_.begin (), heap_.end (), HeapComp ());
+        }
+
         RoadmapNodePtr_t findPath ()
         {
-          closed_.clear ();
-          open_.clear ();
-          parent_.clear ();
-          estimatedCostToGoal_.clear ();
-          costFromStart_.clear ();
+          indices_.clear ();
+          records_.clear ();
+          heap_.clear ();
+
+          minTransitionCost_ = std::numeric_limits <value_type>::infinity ();
+          const Edges_t& allEdges = roadmap_->edges ();
+          for (Edges_t::const_iterator itEdge = allEdges.begin ();
+              itEdge != allEdges.end (); ++itEdge) {
+            const RoadmapNodePtr_t from =
+              static_cast <RoadmapNodePtr_t> ((*itEdge)->from ());
+            const RoadmapNodePtr_t to =
+              static_cast <RoadmapNodePtr_t> ((*itEdge)->to ());
+            if (from->graphState () == to->graphState ()) continue;
+            const value_type l = (*itEdge)->path ()->length ();
+            if (l < minTransitionCost_) minTransitionCost_ = l;
+          }
 
           assert(dynamic_cast<RoadmapNodePtr_t>(roadmap_->initNode()));
-          open_.push_back (static_cast<RoadmapNodePtr_t>(roadmap_->initNode ()));
-          while (!open_.empty ()) {
-            std::sort(open_.begin(), open_.end(), SortFunctor (estimatedCostToGoal_));
-            Nodes_t::iterator itv = open_.begin ();
-            RoadmapNodePtr_t current (*itv);
-            if (isGoal (current)) {
-              return current;
+          const RoadmapNodePtr_t initNode =
+            static_cast<RoadmapNodePtr_t>(roadmap_->initNode ());
+          const std::size_t initIndex = index (initNode);
+          records_[initIndex].costFromStart = 0;
+          records_[initIndex].estimatedCost = heuristic (initNode);
+          push (records_[initIndex].estimatedCost, initIndex);
+          while (!heap_.empty ()) {
+            const HeapEntry_t entry = heap_.front ();
+            std::pop_heap (heap_.begin (), heap_.end (), HeapComp ());
+            heap_.pop_back ();
+            Record& current = records_[entry.second];
+            // Skip entries made stale by a cheaper path: records are never
+            // removed from the heap, they are re-pushed with their improved
+            // cost.
+            if (current.closed || entry.first != current.estimatedCost)
+              continue;
+            if (isGoal (current.node)) {
+              return current.node;
             }
-            open_.erase (itv);
-            closed_.push_back (current);
-            for (Edges_t::const_iterator itEdge = current->outEdges ().begin ();
-                itEdge != current->outEdges ().end (); ++itEdge) {
+            current.closed = true;
+            const value_type costOfCurrent = current.costFromStart;
+            const Edges_t& outEdges = current.node->outEdges ();
+            for (Edges_t::const_iterator itEdge = outEdges.begin ();
+                itEdge != outEdges.end (); ++itEdge) {
               value_type transitionCost = edgeCost (*itEdge);
               assert(dynamic_cast<RoadmapNodePtr_t>((*itEdge)->to ()));
-              RoadmapNodePtr_t child = static_cast<RoadmapNodePtr_t>((*itEdge)->to ());
-              if (std::find (closed_.begin (), closed_.end (), child) ==
-                  closed_.end ()) {
-                // node is not in closed set
-                value_type tmpCost = costFromStart_ [current] + transitionCost;
-                bool childNotInOpenSet = (std::find (open_.begin (),
-                      open_.end (),
-                      child) == open_.end ());
-                if ((childNotInOpenSet) || (tmpCost < costFromStart_ [child])) {
-                  parent_ [child] = *itEdge;
-                  costFromStart_ [child] = tmpCost;
-                  estimatedCostToGoal_ [child] = costFromStart_ [child] +
-                    heuristic (child);
-                  if (childNotInOpenSet) open_.push_back (child);
-                }
+              RoadmapNodePtr_t childNode = static_cast<RoadmapNodePtr_t>((*itEdge)->to ());
+              // Note: current may be invalidated by this call.
+              const std::size_t childIndex = index (childNode);
+              Record& child = records_[childIndex];
+              if (child.closed) continue;
+              // node is not in closed set
+              value_type tmpCost = costOfCurrent + transitionCost;
+              if (tmpCost < child.costFromStart) {
+                child.parent = *itEdge;
+                child.costFromStart = tmpCost;
+                child.estimatedCost = tmpCost + heuristic (childNode);
+                push (child.estimatedCost, childIndex);
               }
             }
           }
@@ -156,7 +212,21 @@ namespace hpp {
               res = dist;
             }
           }
-          return res;
+          // Landmark bound from the constraint graph: any path to the
+          // goal state crosses at least stateHops state-changing edges,
+          // each at least minTransitionCost_ long. States that cannot
+          // reach the goal state get an infinite estimate and are
+          // expanded last.
+          const size_type hops =
+            graph_->stateHops (node->graphState (), state_);
+          if (hops < 0)
+            return std::numeric_limits <value_type>::infinity ();
+          value_type landmark = 0;
+          if (hops > 0) landmark = (value_type) hops * minTransitionCost_;
+          // Without goal nodes the metric part is infinite and carries no
+          // information: fall back on the landmark bound alone.
+          if (roadmap_->goalNodes ().empty ()) return landmark;
+          return std::max (res, landmark);
         }
 
         value_type edgeCost (const EdgePtr_t& edge)
@@ -48,9 +48,18 @@ namespace hpp {
       bool State::reached (const core::RoadmapPtr_t& roadmap) const
       {
         const core::ConnectedComponentPtr_t& _cc = roadmap->initNode()->connectedComponent();
-        const ConnectedComponentPtr_t cc = HPP_DYNAMIC_PTR_CAST(ConnectedComponent, _cc);
-        assert (cc);
-        return !cc->getRoadmapNodes(state_).empty();
+        // reached is called once per planner iteration: cache the
+        // down-cast, which only goes stale when a merge absorbs the
+        // initial node's component.
+        if (_cc.get () != lastInitCC_) {
+          initCC_ = HPP_DYNAMIC_PTR_CAST(ConnectedComponent, _cc);
+          lastInitCC_ = _cc.get ();
+        }
+        assert (initCC_);
+        // The per-state node sets are fed by ConnectedComponent::addNode
+        // on Roadmap::push_node and folded by merge, so the solved check
+        // is a hash lookup, not a roadmap scan.
+        return !initCC_->getRoadmapNodes(state_).empty();
       }
 
       core::PathVectorPtr_t State::computePath(const core::RoadmapPtr_t& roadmap) const
@@ -54,6 +54,8 @@ namespace hpp {
     {
       GraphPathValidationPtr_t pv (GraphPathValidation::create (pathValidation));
       pv->constraintGraph (graph_);
+      pv->numberOfThreads (getParameter<size_type>
+          ("GraphPathValidation/NumberOfThreads", 1));
       Parent::pathValidation (pv);
     }
 
@@ -16,17 +16,84 @@
 
 #include "hpp/manipulation/roadmap-node.hh"
 
+#include <new>
+
+#include <boost/pool/singleton_pool.hpp>
+
 #include <hpp/manipulation/connected-component.hh>
+#include <hpp/manipulation/symbolic-component.hh>
 
 namespace hpp {
   namespace manipulation {
-    RoadmapNode::CachingSystem RoadmapNode::defaultCachingSystem = RoadmapNode::CACHE_DISABLED;
+    namespace {
+      struct RoadmapNodePoolTag {};
+      typedef boost::singleton_pool <RoadmapNodePoolTag, sizeof (RoadmapNode)>
+        RoadmapNodePool_t;
+    }
+
+    void* RoadmapNode::operator new (std::size_t size)
+    {
+      // Derived classes would not fit in the pool blocks.
+      if (size != sizeof (RoadmapNode)) return ::operator new (size);
+      void* pointer = RoadmapNodePool_t::malloc ();
+      if (!pointer) throw std::bad_alloc ();
+      return pointer;
+    }
+
+    void RoadmapNode::operator delete (void* pointer)
+    {
+      if (!pointer) return;
+      if (RoadmapNodePool_t::is_from (pointer))
+        RoadmapNodePool_t::free (pointer);
+      else
+        ::operator delete (pointer);
+    }
+
+    void RoadmapNode::releasePoolMemory ()
+    {
+      RoadmapNodePool_t::release_memory ();
+    }
+
+    // The graph state of a node does not change once the node is inserted
+    // in the roadmap so the cache is enabled by default. The state is
+    // computed on the first access - which happens at node insertion, when
+    // the connected component sorts the node by graph state - and re-solving
+    // the state constraints afterwards is avoided.
+    RoadmapNode::CachingSystem RoadmapNode::defaultCachingSystem = RoadmapNode::CACHE_NEED_UPDATE;
 
     RoadmapNode::RoadmapNode (const ConfigurationPtr_t& configuration,
         ConnectedComponentPtr_t cc) :
       core::Node (configuration, cc),
       cacheSystem_ (defaultCachingSystem),
+      configHash_ (hash (*configuration)),
       state_ ()
     {}
+
+    const vector_t* RoadmapNode::cachedParameter (const std::size_t id) const
+    {
+      for (std::size_t i = 0; i < foliationParameters_.size (); ++i)
+        if (foliationParameters_[i].first == id)
+          return &foliationParameters_[i].second;
+      return NULL;
+    }
+
+    const vector_t& RoadmapNode::cacheParameter (const std::size_t id,
+        const vector_t& value) const
+    {
+      foliationParameters_.push_back (FoliationParameter_t (id, value));
+      return foliationParameters_.back ().second;
+    }
+
+    SymbolicComponentPtr_t RoadmapNode::symbolicComponent () const
+    {
+      // Union-find lookup: the stored component may have been merged
+      // away; resolve it to its representative and keep the result.
+      // The store only happens when the resolution moved, so on a
+      // compacted structure the lookup is a pure read.
+      if (!symbolicCC_) return symbolicCC_;
+      const SymbolicComponentPtr_t rep = symbolicCC_->representative ();
+      if (rep != symbolicCC_) symbolicCC_ = rep;
+      return rep;
+    }
   } // namespace manipulation
 } // namespace hpp
@@ -0,0 +1,244 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/manipulation/roadmap-snapshot.hh>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <hpp/util/debug.hh>
+#include <hpp/util/pointer.hh>
+
+#include <hpp/core/edge.hh>
+#include <hpp/core/node.hh>
+#include <hpp/core/steering-method.hh>
+
+#include <hpp/manipulation/connected-component.hh>
+#include <hpp/manipulation/roadmap.hh>
+#include <hpp/manipulation/roadmap-node.hh>
+#include <hpp/manipulation/symbolic-component.hh>
+#include <hpp/manipulation/graph/state.hh>
+
+namespace hpp {
+  namespace manipulation {
+    namespace {
+      const char magic_[8] = { 'h', 'p', 'p', 'r', 'd', 'm', 'p', '\0' };
+      const boost::int64_t version_ = 1;
+      /// Header: magic, version, configuration size, number of nodes,
+      /// number of edges.
+      const std::size_t headerSize_ = 8 + 4 * sizeof (boost::int64_t);
+    } // namespace
+
+    RoadmapSnapshotWriter::RoadmapSnapshotWriter (const std::string& path) :
+      path_ (path),
+      nodes_ ((path + ".nodes").c_str (),
+          std::ios::binary | std::ios::trunc),
+      meta_ ((path + ".meta").c_str (),
+          std::ios::binary | std::ios::trunc),
+      edges_ ((path + ".edges").c_str (),
+          std::ios::binary | std::ios::trunc),
+      nbEdges_ (0), configSize_ (0)
+    {
+      if (!nodes_ || !meta_ || !edges_)
+        throw std::runtime_error ("Could not open roadmap snapshot " + path);
+      writeHeader (0);
+    }
+
+    RoadmapSnapshotWriter::~RoadmapSnapshotWriter ()
+    {
+    }
+
+    void RoadmapSnapshotWriter::checkpoint (const RoadmapPtr_t& roadmap)
+    {
+      using core::Nodes_t;
+      using core::Edges_t;
+
+      const Nodes_t& ns = roadmap->nodes ();
+      Nodes_t::const_iterator itN = ns.begin ();
+      std::advance (itN, (Nodes_t::difference_type) nodeIndices_.size ());
+      for (; itN != ns.end (); ++itN) {
+        const RoadmapNodePtr_t node = static_cast <RoadmapNodePtr_t> (*itN);
+        const Configuration_t& q = *node->configuration ();
+        if (configSize_ == 0) configSize_ = q.size ();
+        nodes_.write (reinterpret_cast <const char*> (q.data ()),
+            (std::streamsize) (sizeof (value_type) * (std::size_t) q.size ()));
+        boost::int64_t m[3];
+        m[0] = (boost::int64_t) roadmap->getState (node)->id ();
+        m[1] = (boost::int64_t) componentId (HPP_DYNAMIC_PTR_CAST
+            (ConnectedComponent, node->connectedComponent ()));
+        m[2] = (boost::int64_t) componentId (node->symbolicComponent ());
+        meta_.write (reinterpret_cast <const char*> (m), sizeof (m));
+        const std::size_t index = nodeIndices_.size ();
+        nodeIndices_[*itN] = index;
+      }
+
+      const Edges_t& es = roadmap->edges ();
+      Edges_t::const_iterator itE = es.begin ();
+      std::advance (itE, (Edges_t::difference_type) nbEdges_);
+      std::size_t nbEdges = nbEdges_;
+      for (; itE != es.end (); ++itE) {
+        boost::int64_t e[2];
+        e[0] = (boost::int64_t) nodeIndices_[(*itE)->from ()];
+        e[1] = (boost::int64_t) nodeIndices_[(*itE)->to ()];
+        edges_.write (reinterpret_cast <const char*> (e), sizeof (e));
+        ++nbEdges;
+      }
+
+      // Flush the arrays before committing the new counts, so that the
+      // header never describes data that did not reach the file system.
+      nodes_.flush ();
+      meta_.flush ();
+      edges_.flush ();
+      writeHeader (nbEdges);
+      nbEdges_ = nbEdges;
+    }
+
+    std::size_t RoadmapSnapshotWriter::componentId
+    (const ConnectedComponentPtr_t& cc)
+    {
+      std::pair <std::map <ConnectedComponentPtr_t, std::size_t>::iterator,
+        bool> res = ccIds_.insert (std::make_pair (cc, ccIds_.size ()));
+      return res.first->second;
+    }
+
+    std::size_t RoadmapSnapshotWriter::componentId
+    (const SymbolicComponentPtr_t& sc)
+    {
+      std::pair <std::map <SymbolicComponentPtr_t, std::size_t>::iterator,
+        bool> res = scIds_.insert (std::make_pair (sc, scIds_.size ()));
+      return res.first->second;
+    }
+
+    void RoadmapSnapshotWriter::writeHeader (const std::size_t nbEdges)
+    {
+      std::ofstream header (path_.c_str (),
+          std::ios::binary | std::ios::trunc);
+      if (!header)
+        throw std::runtime_error ("Could not write roadmap snapshot header "
+            + path_);
+      header.write (magic_, sizeof (magic_));
+      boost::int64_t counts[4];
+      counts[0] = version_;
+      counts[1] = (boost::int64_t) configSize_;
+      counts[2] = (boost::int64_t) nodeIndices_.size ();
+      counts[3] = (boost::int64_t) nbEdges;
+      header.write (reinterpret_cast <const char*> (counts),
+          sizeof (counts));
+      header.flush ();
+    }
+
+    RoadmapSnapshotReader::RoadmapSnapshotReader (const std::string& path) :
+      nbNodes_ (0), nbEdges_ (0), configSize_ (0),
+      nodesFd_ (-1), metaFd_ (-1), edgesFd_ (-1),
+      configs_ (NULL), meta_ (NULL), edges_ (NULL)
+    {
+      std::ifstream header (path.c_str (), std::ios::binary);
+      if (!header)
+        throw std::runtime_error ("Could not open roadmap snapshot " + path);
+      char magic[8];
+      boost::int64_t counts[4];
+      header.read (magic, sizeof (magic));
+      header.read (reinterpret_cast <char*> (counts), sizeof (counts));
+      if (!header || std::memcmp (magic, magic_, sizeof (magic)) != 0
+          || counts[0] != version_)
+        throw std::runtime_error (path + " is not a roadmap snapshot");
+      configSize_ = (size_type) counts[1];
+      nbNodes_ = (std::size_t) counts[2];
+      nbEdges_ = (std::size_t) counts[3];
+
+      configs_ = reinterpret_cast <const value_type*> (map (path + ".nodes",
+            sizeof (value_type) * (std::size_t) configSize_ * nbNodes_,
+            nodesFd_));
+      meta_ = reinterpret_cast <const boost::int64_t*> (map (path + ".meta",
+            3 * sizeof (boost::int64_t) * nbNodes_, metaFd_));
+      edges_ = reinterpret_cast <const boost::int64_t*> (map (path + ".edges",
+            2 * sizeof (boost::int64_t) * nbEdges_, edgesFd_));
+    }
+
+    RoadmapSnapshotReader::~RoadmapSnapshotReader ()
+    {
+      if (configs_) munmap (const_cast <value_type*> (configs_),
+          sizeof (value_type) * (std::size_t) configSize_ * nbNodes_);
+      if (meta_) munmap (const_cast <boost::int64_t*> (meta_),
+          3 * sizeof (boost::int64_t) * nbNodes_);
+      if (edges_) munmap (const_cast <boost::int64_t*> (edges_),
+          2 * sizeof (boost::int64_t) * nbEdges_);
+      if (nodesFd_ >= 0) close (nodesFd_);
+      if (metaFd_ >= 0) close (metaFd_);
+      if (edgesFd_ >= 0) close (edgesFd_);
+    }
+
+    const void* RoadmapSnapshotReader::map (const std::string& file,
+        const std::size_t size, int& fd) const
+    {
+      fd = open (file.c_str (), O_RDONLY);
+      if (fd < 0)
+        throw std::runtime_error ("Could not open " + file);
+      struct stat st;
+      if (fstat (fd, &st) < 0 || (std::size_t) st.st_size < size)
+        throw std::runtime_error (file + " is truncated");
+      if (size == 0) return NULL;
+      void* addr = mmap (NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+      if (addr == MAP_FAILED)
+        throw std::runtime_error ("Could not map " + file);
+      return addr;
+    }
+
+    RoadmapSnapshotReader::ConstConfigurationBlock_t
+    RoadmapSnapshotReader::configurations () const
+    {
+      return ConstConfigurationBlock_t (configs_, configSize_,
+          (size_type) nbNodes_);
+    }
+
+    std::size_t RoadmapSnapshotReader::stateId (const std::size_t index)
+      const
+    {
+      assert (index < nbNodes_);
+      return (std::size_t) meta_[3 * index];
+    }
+
+    void RoadmapSnapshotReader::resume (const RoadmapPtr_t& roadmap,
+        const core::SteeringMethodPtr_t& sm) const
+    {
+      ConstConfigurationBlock_t qs (configurations ());
+      std::vector <core::NodePtr_t> nodes (nbNodes_);
+      for (std::size_t i = 0; i < nbNodes_; ++i) {
+        ConfigurationPtr_t q (new Configuration_t (qs.col ((size_type) i)));
+        nodes[i] = roadmap->addNode (q);
+      }
+      // Re-creating the edges also rebuilds the connected and symbolic
+      // component structure, through Roadmap::addEdge.
+      for (std::size_t i = 0; i < nbEdges_; ++i) {
+        const std::size_t f = (std::size_t) edges_[2 * i],
+                          t = (std::size_t) edges_[2 * i + 1];
+        core::PathPtr_t path = (*sm) (*nodes[f]->configuration (),
+                                      *nodes[t]->configuration ());
+        if (path) roadmap->addEdge (nodes[f], nodes[t], path);
+        else {
+          hppDout (warning, "Could not re-steer snapshot edge " << f
+              << " -> " << t);
+        }
+      }
+    }
+  } // namespace manipulation
+} // namespace hpp
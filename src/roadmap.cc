@@ -16,6 +16,8 @@
 
 #include <hpp/manipulation/roadmap.hh>
 
+#include <map>
+
 #include <hpp/util/pointer.hh>
 
 #include <hpp/core/edge.hh>
@@ -30,7 +32,9 @@
 namespace hpp {
   namespace manipulation {
     Roadmap::Roadmap (const core::DistancePtr_t& distance, const core::DevicePtr_t& robot) :
-      core::Roadmap (distance, robot), weak_ () {}
+      core::Roadmap (distance, robot), deferHistogramUpdates_ (false),
+      warmReset_ (false), revision_ (0), publishedRevision_ (0),
+      robot_ (robot), weak_ () {}
 
     RoadmapPtr_t Roadmap::create (const core::DistancePtr_t& distance, const core::DevicePtr_t& robot)
     {
@@ -43,6 +47,8 @@ namespace hpp {
     void Roadmap::clear ()
     {
       Parent::clear ();
+      ++revision_;
+      pendingStatNodes_.clear ();
       Histograms_t::const_iterator it;
       for (it = histograms_.begin(); it != histograms_.end(); ++it)
         (*it)->clear ();
@@ -52,15 +58,201 @@ namespace hpp {
           (*it)->clear ();
       }
       symbolicCCs_.clear();
+      weighedSymbolicCCs_.clear();
+      configIndex_.clear();
+      {
+        // The published epoch describes a structure that no longer
+        // exists: drop it rather than serve stale queries.
+        boost::mutex::scoped_lock lock (publishMutex_);
+        published_.reset ();
+        publishedRevision_ = 0;
+      }
+      // The parent class deleted every node. On a cold reset the freed
+      // pool blocks go back to the system in one pass; a warm reset
+      // keeps them with the allocator so the next query re-grows into
+      // memory that is already faulted in.
+      if (!warmReset_) RoadmapNode::releasePoolMemory ();
+    }
+
+    RoadmapPtr_t Roadmap::snapshot () const
+    {
+      RoadmapPtr_t copy = Roadmap::create (distance (), robot_);
+      // The graph must be set before the first insertion: addNode
+      // resolves the graph state of the new node through getState.
+      // Histogram updates are deferred - and dropped below - so the
+      // nodes of the copy are not counted in the statistics of the
+      // live graph histograms.
+      copy->graph_ = graph_;
+      copy->deferHistogramUpdates_ = true;
+      // Map each node of this roadmap to its counterpart in the copy.
+      // The init and goal nodes go through the dedicated insertion
+      // methods so that the copy answers goal queries like the
+      // original.
+      std::map <core::NodePtr_t, core::NodePtr_t> nodeMap;
+      const core::NodePtr_t init = initNode ();
+      if (init)
+        nodeMap [init] = copy->initNode (init->configuration ());
+      for (core::NodeVector_t::const_iterator _goal = goalNodes ().begin ();
+          _goal != goalNodes ().end (); ++_goal) {
+        copy->addGoalNode ((*_goal)->configuration ());
+        nodeMap [*_goal] = copy->goalNodes ().back ();
+      }
+      core::Nodes_t::const_iterator _node;
+      for (_node = nodes ().begin (); _node != nodes ().end (); ++_node) {
+        if (nodeMap.count (*_node)) continue;
+        nodeMap [*_node] = copy->addNode ((*_node)->configuration ());
+      }
+      // Paths are immutable once inserted: the copy shares them.
+      // Re-inserting the edges also rebuilds the connected and symbolic
+      // components of the copy.
+      const core::Edges_t& es = edges ();
+      for (core::Edges_t::const_iterator _edge = es.begin ();
+          _edge != es.end (); ++_edge)
+        copy->addEdge (nodeMap [(*_edge)->from ()],
+            nodeMap [(*_edge)->to ()], (*_edge)->path ());
+      // The snapshot is read concurrently without locks, so no lazy
+      // work may be left in its symbolic components: concatenate the
+      // pending node lists and compress the union-find chains now, so
+      // the accessors are pure reads afterwards.
+      for (SymbolicComponents_t::const_iterator _sc =
+          copy->symbolicCCs_.begin (); _sc != copy->symbolicCCs_.end ();
+          ++_sc)
+        (*_sc)->nodes ();
+      for (_node = copy->nodes ().begin (); _node != copy->nodes ().end ();
+          ++_node)
+        static_cast <const RoadmapNodePtr_t> (*_node)->symbolicComponent ();
+      // Drop the queued statistics instead of flushing them: the
+      // snapshot serves queries, not statistics.
+      copy->pendingStatNodes_.clear ();
+      copy->deferHistogramUpdates_ = false;
+      return copy;
+    }
+
+    void Roadmap::publish ()
+    {
+      RoadmapPtr_t copy;
+      std::size_t revision;
+      {
+        // Holding the write mutex guarantees no planner is inserting
+        // while the snapshot walks the structure.
+        boost::mutex::scoped_lock lock (writeMutex_);
+        copy = snapshot ();
+        revision = revision_;
+      }
+      boost::mutex::scoped_lock lock (publishMutex_);
+      published_ = copy;
+      publishedRevision_ = revision;
+    }
+
+    RoadmapPtr_t Roadmap::publishedSnapshot () const
+    {
+      boost::mutex::scoped_lock lock (publishMutex_);
+      return published_;
+    }
+
+    std::size_t Roadmap::publishedRevision () const
+    {
+      boost::mutex::scoped_lock lock (publishMutex_);
+      return publishedRevision_;
+    }
+
+    void Roadmap::delta (const std::size_t nodeCount,
+        const std::size_t edgeCount, Delta& delta) const
+    {
+      delta.nodes.clear ();
+      delta.edges.clear ();
+      const core::Nodes_t& ns = nodes ();
+      std::size_t i = 0;
+      for (core::Nodes_t::const_iterator _n = ns.begin (); _n != ns.end ();
+          ++_n, ++i)
+        if (i >= nodeCount)
+          delta.nodes.push_back (static_cast <const RoadmapNodePtr_t> (*_n));
+      const core::Edges_t& es = edges ();
+      i = 0;
+      for (core::Edges_t::const_iterator _e = es.begin (); _e != es.end ();
+          ++_e, ++i)
+        if (i >= edgeCount) delta.edges.push_back (*_e);
+      delta.nodeCount = nodeCount + delta.nodes.size ();
+      delta.edgeCount = edgeCount + delta.edges.size ();
+    }
+
+    void Roadmap::merge (const Delta& delta, RoadmapNodes_t& imported)
+    {
+      imported.clear ();
+      // Defer the leaf classification until the caches of the source
+      // nodes are copied, so that the histograms reuse the foliation
+      // parameters the source roadmap already computed.
+      const bool defer = deferHistogramUpdates_;
+      deferHistogramUpdates_ = true;
+      for (std::size_t i = 0; i < delta.nodes.size (); ++i) {
+        const RoadmapNodePtr_t& src = delta.nodes[i];
+        if (nodeWithConfiguration (*src->configuration ())) continue;
+        // The configuration payload is shared with the source node.
+        RoadmapNodePtr_t local = static_cast <const RoadmapNodePtr_t>
+          (addNode (src->configuration ()));
+        local->copyCachesFrom (src);
+        imported.push_back (local);
+      }
+      for (std::size_t i = 0; i < delta.edges.size (); ++i) {
+        const core::EdgePtr_t& edge = delta.edges[i];
+        const RoadmapNodePtr_t from = nodeWithConfiguration
+          (*edge->from ()->configuration ());
+        const RoadmapNodePtr_t to = nodeWithConfiguration
+          (*edge->to ()->configuration ());
+        if (!from || !to) {
+          // The endpoint came in a delta that was never merged here.
+          hppDout (warning, "Dropping an edge with an unknown endpoint. "
+              "Was an earlier delta skipped ?");
+          continue;
+        }
+        // The validated path is immutable: the edge shares it.
+        addEdge (from, to, edge->path ());
+      }
+      deferHistogramUpdates_ = defer;
+      flushStatistics ();
+    }
+
+    void Roadmap::merge (const RoadmapPtr_t& other, RoadmapNodes_t& imported)
+    {
+      Delta d;
+      other->delta (0, 0, d);
+      merge (d, imported);
     }
 
     void Roadmap::push_node (const core::NodePtr_t& n)
     {
       Parent::push_node (n);
-      const RoadmapNodePtr_t& node = 
+      ++revision_;
+      const RoadmapNodePtr_t& node =
         static_cast <const RoadmapNodePtr_t> (n);
-      statInsert (node);
+      if (deferHistogramUpdates_) pendingStatNodes_.push_back (node);
+      else statInsert (node);
+      configIndex_.insert (std::make_pair (node->configurationHash (), node));
       symbolicCCs_.insert(node->symbolicComponent());
+      indexSymbolicComponent (node->symbolicComponent());
+    }
+
+    void Roadmap::indexSymbolicComponent (const SymbolicComponentPtr_t& sc)
+    {
+      WeighedSymbolicComponentPtr_t wsc = weighedComponent (sc);
+      if (!wsc || wsc->indexed_) return;
+      wsc->weightPosition_ = weighedSymbolicCCs_.insert
+        (std::make_pair (wsc->weight_, wsc));
+      wsc->indexed_ = true;
+    }
+
+    void Roadmap::unindexSymbolicComponent (const SymbolicComponentPtr_t& sc)
+    {
+      WeighedSymbolicComponentPtr_t wsc = weighedComponent (sc);
+      if (!wsc || !wsc->indexed_) return;
+      weighedSymbolicCCs_.erase (wsc->weightPosition_);
+      wsc->indexed_ = false;
+    }
+
+    void Roadmap::updateSymbolicComponent (const SymbolicComponentPtr_t& sc)
+    {
+      unindexSymbolicComponent (sc);
+      indexSymbolicComponent (sc);
     }
 
     void Roadmap::statInsert (const RoadmapNodePtr_t& n)
@@ -75,8 +267,19 @@ namespace hpp {
       }
     }
 
+    void Roadmap::flushStatistics ()
+    {
+      if (pendingStatNodes_.empty ()) return;
+      for (std::size_t i = 0; i < pendingStatNodes_.size (); ++i)
+        statInsert (pendingStatNodes_[i]);
+      pendingStatNodes_.clear ();
+    }
+
     void Roadmap::insertHistogram (const graph::HistogramPtr_t hist)
     {
+      // Feed the queued nodes first: the loop below walks all the nodes
+      // of the roadmap and would otherwise count them twice.
+      flushStatistics ();
       histograms_.push_back (hist);
       core::Nodes_t::const_iterator _node;
       for (_node = nodes().begin(); _node != nodes().end(); ++_node)
@@ -96,22 +299,32 @@ namespace hpp {
         const graph::StatePtr_t& state,
         value_type& minDistance) const
     {
-      core::NodePtr_t result = NULL;
-      minDistance = std::numeric_limits <value_type>::infinity ();
-      const RoadmapNodes_t& roadmapNodes = connectedComponent->getRoadmapNodes (state);
-      // std::cout << "State: "  << state->name () << std::endl;
-      // std::cout << "roadmapNodes.size () = " << roadmapNodes.size ()
-      // 		<< std::endl;
-      for (RoadmapNodes_t::const_iterator itNode = roadmapNodes.begin ();
-          itNode != roadmapNodes.end (); ++itNode) {
-        value_type d = (*distance()) (*(*itNode)->configuration (),
-            *configuration);
-        if (d < minDistance) {
-          minDistance = d;
-          result = *itNode;
-        }
-      }
-      return static_cast <RoadmapNode*> (result);
+      // The query is answered by the nearest-neighbor index that the
+      // connected component maintains for each graph state, in time
+      // sub-linear in the number of nodes.
+      return connectedComponent->nearestRoadmapNode (state, *configuration,
+          minDistance);
+    }
+
+    void Roadmap::nearestNodes (const ConfigurationPtr_t& configuration,
+        const ConnectedComponentPtr_t& connectedComponent,
+        NodesAndDistances_t& nearest) const
+    {
+      // Single pass over the per-state indexes of the component: one
+      // query per state that actually contains nodes, instead of one
+      // nearestNode call per state of the graph.
+      connectedComponent->nearestRoadmapNodes (*configuration, nearest);
+    }
+
+    RoadmapNodePtr_t Roadmap::nodeWithConfiguration (ConfigurationIn_t q) const
+    {
+      typedef ConfigurationIndex_t::const_iterator It_t;
+      const std::pair <It_t, It_t> range =
+        configIndex_.equal_range (RoadmapNode::hash (q));
+      // Full configuration comparison only on hash collisions.
+      for (It_t it = range.first; it != range.second; ++it)
+        if (*(it->second->configuration ()) == q) return it->second;
+      return NULL;
     }
 
     core::NodePtr_t Roadmap::createNode (const ConfigurationPtr_t& q) const
@@ -132,18 +345,24 @@ namespace hpp {
     void Roadmap::addEdge (const core::EdgePtr_t& edge)
     {
       Parent::addEdge(edge);
+      ++revision_;
       const RoadmapNodePtr_t& f = static_cast <const RoadmapNodePtr_t> (edge->from());
       const RoadmapNodePtr_t& t = static_cast <const RoadmapNodePtr_t> (edge->to());
       SymbolicComponentPtr_t scf = f->symbolicComponent();
       SymbolicComponentPtr_t sct = t->symbolicComponent();
       scf->canReach(sct);
       if (scf->canMerge(sct)) {
-        if (scf->nodes().size() > sct->nodes().size()) {
+        if (scf->size() > sct->size()) {
           scf->merge(sct);
           symbolicCCs_.erase(sct);
+          unindexSymbolicComponent(sct);
+          // The merge changed the weight of the survivor.
+          updateSymbolicComponent(scf);
         } else {
           sct->merge(scf);
           symbolicCCs_.erase(scf);
+          unindexSymbolicComponent(scf);
+          updateSymbolicComponent(sct);
         }
       }
     }
@@ -39,6 +39,7 @@ namespace hpp {
         throw std::runtime_error ("RoadmapNode of SymbolicComponent must be in"
             " the same state");
       nodes_.push_back(node);
+      ++nbNodes_;
     }
 
     void SymbolicComponent::setFirstNode (const RoadmapNodePtr_t& node)
@@ -46,6 +47,35 @@ namespace hpp {
       assert(!state_);
       state_ = roadmap_.lock()->getState(node);
       nodes_.push_back(node);
+      ++nbNodes_;
+    }
+
+    SymbolicComponentPtr_t SymbolicComponent::representative () const
+    {
+      if (!parent_) return weak_.lock();
+      // Path compression: point directly at the root so the next lookup
+      // is O(1). The store only happens when the resolution moved, so
+      // on a compacted structure - e.g. a published snapshot - the
+      // lookup is a pure read and concurrent readers do not race.
+      SymbolicComponentPtr_t root = parent_->representative();
+      if (root != parent_) parent_ = root;
+      return root;
+    }
+
+    const RoadmapNodes_t& SymbolicComponent::nodes () const
+    {
+      if (!absorbed_.empty()) {
+        // Concatenate the node lists left pending by merge.
+        std::vector<SymbolicComponentPtr_t> pending;
+        pending.swap(absorbed_);
+        for (std::vector<SymbolicComponentPtr_t>::const_iterator it =
+            pending.begin(); it != pending.end(); ++it) {
+          const RoadmapNodes_t& ns = (*it)->nodes();
+          nodes_.insert (nodes_.end(), ns.begin(), ns.end());
+          (*it)->nodes_.clear();
+        }
+      }
+      return nodes_;
     }
 
     bool SymbolicComponent::canMerge (const SymbolicComponentPtr_t& otherCC) const
@@ -71,13 +101,13 @@ namespace hpp {
       assert (canMerge(other));
       if (other == weak_.lock()) return;
 
-      // Tell other's nodes that they now belong to this connected component
-      for (RoadmapNodes_t::iterator itNode = other->nodes_.begin ();
-	   itNode != other->nodes_.end (); ++itNode) {
-	(*itNode)->symbolicComponent (weak_.lock ());
-      }
-      // Add other's nodes to this list.
-      nodes_.insert (nodes_.end (), other->nodes_.begin(), other->nodes_.end());
+      // Union-find union: other forwards to this component, its nodes
+      // resolve their component lazily through representative() and the
+      // node lists are concatenated on the next call to nodes().
+      other->parent_ = weak_.lock();
+      absorbed_.push_back (other);
+      nbNodes_ += other->nbNodes_;
+      other->nbNodes_ = 0;
 
       from_.erase (other.get());
       other->from_.erase (this);
@@ -97,9 +127,8 @@ namespace hpp {
 
     void WeighedSymbolicComponent::merge (SymbolicComponentPtr_t otherCC)
     {
-      WeighedSymbolicComponentPtr_t other =
-        HPP_DYNAMIC_PTR_CAST(WeighedSymbolicComponent, otherCC);
-      value_type r = ((value_type)nodes_.size()) / (value_type)(nodes_.size() + other->nodes_.size());
+      WeighedSymbolicComponentPtr_t other = weighedComponent (otherCC);
+      value_type r = ((value_type)size()) / (value_type)(size() + other->size());
 
       SymbolicComponent::merge(otherCC);
       weight_ *= other->weight_; // TODO a geometric mean would be more natural.
@@ -49,8 +49,7 @@
 #include "hpp/manipulation/graph/state-selector.hh"
 
 #define CastToWSC_ptr(var, scPtr) \
-  WeighedSymbolicComponentPtr_t var = \
-  HPP_DYNAMIC_PTR_CAST(WeighedSymbolicComponent,scPtr)
+  WeighedSymbolicComponentPtr_t var = weighedComponent (scPtr)
 
 namespace hpp {
   namespace manipulation {
@@ -74,25 +73,6 @@ namespace hpp {
       HPP_DEFINE_TIMECOUNTER(projectPath);
       HPP_DEFINE_TIMECOUNTER(validatePath);
 
-      struct WeighedSymbolicComponentComp {
-        bool operator() (const SymbolicComponentPtr_t& lhs, const SymbolicComponentPtr_t& rhs)
-        {
-          return HPP_DYNAMIC_PTR_CAST(WeighedSymbolicComponent, lhs)->weight_
-            > HPP_DYNAMIC_PTR_CAST(WeighedSymbolicComponent, rhs)->weight_;
-        }
-      };
-      typedef std::list<WeighedSymbolicComponentPtr_t> SymbolicComponentList_t;
-      SymbolicComponentList_t sorted_list (const SymbolicComponents_t& sc)
-      {
-        SymbolicComponentList_t l;
-        WeighedSymbolicComponentComp comp;
-        for (SymbolicComponents_t::const_iterator _sc = sc.begin();
-            _sc != sc.end(); ++_sc)
-          l.insert (std::upper_bound(l.begin(), l.end(), *_sc, comp),
-              HPP_DYNAMIC_PTR_CAST(WeighedSymbolicComponent, *_sc));
-        return l;
-      }
-
       struct DistanceToConfiguration {
         const Configuration_t& q_;
         core::Distance& d_;
@@ -110,14 +90,6 @@ namespace hpp {
         }
       };
 
-      bool belongs (const ConfigurationPtr_t& q, const core::Nodes_t& nodes)
-      {
-        for (core::Nodes_t::const_iterator itNode = nodes.begin ();
-            itNode != nodes.end (); ++itNode) {
-          if (*((*itNode)->configuration ()) == *q) return true;
-        }
-        return false;
-      }
     }
 
     const std::vector<SymbolicPlanner::Reason>
@@ -181,6 +153,7 @@ namespace hpp {
     void SymbolicPlanner::oneStep ()
     {
       HPP_START_TIMECOUNTER(oneStep);
+      Telemetry::ScopedPhase telStep (telemetry_, 0, Telemetry::ONE_STEP);
 
       // Get the robot
       DevicePtr_t robot = HPP_DYNAMIC_PTR_CAST(Device, problem ().robot ());
@@ -188,7 +161,10 @@ namespace hpp {
       // Get the roadmap and the symbolic components
       RoadmapPtr_t rdm = HPP_DYNAMIC_PTR_CAST(Roadmap, roadmap());
       HPP_ASSERT(rdm);
-      SymbolicComponentList_t scs = sorted_list (rdm->symbolicComponents());
+      // The roadmap maintains the components ordered by decreasing
+      // weight, so no list is rebuilt and sorted here.
+      const WeighedSymbolicComponents_t& scs =
+        rdm->weighedSymbolicComponents();
 
       core::Nodes_t newNodes;
       core::PathPtr_t path;
@@ -209,19 +185,38 @@ namespace hpp {
         // Find the symbolic component in this connected component which has
         // the highest value.
         SymbolicComponentPtr_t sc;
-        for (SymbolicComponentList_t::iterator _sc = scs.begin();
+        for (WeighedSymbolicComponents_t::const_iterator _sc = scs.begin();
             _sc != scs.end(); ++_sc) {
-          sc = *_sc;
-          if (sc->connectedComponent() == *itcc) break;
+          if (_sc->second->connectedComponent() == *itcc) {
+            sc = _sc->second;
+            break;
+          }
         }
         if (!sc) {
           hppDout (error, "There should always be a connected component corresponding to symbolic component");
           continue;
         }
 
+        // Targeted sampling: pull the uniform sample toward the leaf of
+        // the selected component, so that sample placement agrees with
+        // the weight-driven component selection instead of fighting it.
+        ConfigurationPtr_t q_target = q_rand;
+        if (targetedSampling_ > 0 && !sc->nodes ().empty ()) {
+          // Seed from the configuration of a random member node and
+          // perturb it by moving a fraction targetedSampling_ of the
+          // way toward the uniform sample; the interpolation keeps the
+          // result on the configuration manifold.
+          const std::size_t i = (std::size_t) rand () % sc->nodes ().size ();
+          q_target = ConfigurationPtr_t (new Configuration_t
+              (robot->configSize ()));
+          pinocchio::interpolate (robot,
+              *(sc->nodes ()[i]->configuration ()), *q_rand,
+              targetedSampling_, *q_target);
+        }
+
         // Find the nearest neighbor.
         HPP_START_TIMECOUNTER(nearestNeighbor);
-        DistanceToConfiguration dtc (*q_rand, *rdm->distance());
+        DistanceToConfiguration dtc (*q_target, *rdm->distance());
         RoadmapNodePtr_t near =
           std::for_each(sc->nodes().begin(), sc->nodes().end(), dtc).node_;
         HPP_STOP_TIMECOUNTER(nearestNeighbor);
@@ -231,7 +226,7 @@ namespace hpp {
         // Extension
         HPP_START_TIMECOUNTER(extend);
         ExtendStatus status;
-        bool pathIsValid = extend (near, q_rand, path, status);
+        bool pathIsValid = extend (near, q_target, path, status);
         HPP_STOP_TIMECOUNTER(extend);
         HPP_DISPLAY_LAST_TIMECOUNTER(extend);
 
@@ -270,15 +265,19 @@ namespace hpp {
       HPP_STOP_TIMECOUNTER(delayedEdges);
 
       // Try to connect the new nodes together
-      HPP_START_TIMECOUNTER(tryConnectNewNodes);
-      const std::size_t nbConn = tryConnectNewNodes (newNodes);
-      HPP_STOP_TIMECOUNTER(tryConnectNewNodes);
-      HPP_DISPLAY_LAST_TIMECOUNTER(tryConnectNewNodes);
-      if (nbConn == 0) {
-        HPP_START_TIMECOUNTER(tryConnectToRoadmap);
-        tryConnectToRoadmap (newNodes);
-        HPP_STOP_TIMECOUNTER(tryConnectToRoadmap);
-        HPP_DISPLAY_LAST_TIMECOUNTER(tryConnectToRoadmap);
+      {
+        Telemetry::ScopedPhase telConn (telemetry_, 0,
+            Telemetry::TRY_CONNECT);
+        HPP_START_TIMECOUNTER(tryConnectNewNodes);
+        const std::size_t nbConn = tryConnectNewNodes (newNodes);
+        HPP_STOP_TIMECOUNTER(tryConnectNewNodes);
+        HPP_DISPLAY_LAST_TIMECOUNTER(tryConnectNewNodes);
+        if (nbConn == 0) {
+          HPP_START_TIMECOUNTER(tryConnectToRoadmap);
+          tryConnectToRoadmap (newNodes);
+          HPP_STOP_TIMECOUNTER(tryConnectToRoadmap);
+          HPP_DISPLAY_LAST_TIMECOUNTER(tryConnectToRoadmap);
+        }
       }
       HPP_STOP_TIMECOUNTER(oneStep);
       HPP_DISPLAY_LAST_TIMECOUNTER(oneStep);
@@ -303,6 +302,7 @@ namespace hpp {
         ExtendStatus& status)
     {
       status.info = SUCCESS;
+      Telemetry::ScopedPhase telExtend (telemetry_, 0, Telemetry::EXTEND);
       graph::GraphPtr_t graph = problem_.constraintGraph ();
       // Select next node in the constraint graph.
       const ConfigurationPtr_t q_near = n_near->configuration ();
@@ -328,7 +328,11 @@ namespace hpp {
       qProj_ = *q_rand;
       HPP_START_TIMECOUNTER (applyConstraints);
       SuccessStatistics& es = edgeStat (status.edge);
-      if (!status.edge->applyConstraints (n_near, qProj_)) {
+      const Telemetry::counter_t projStart = Telemetry::tick ();
+      const bool projOk = status.edge->applyConstraints (n_near, qProj_);
+      telemetry_.recordEdge (0, Telemetry::PROJECTION, status.edge->id (),
+          projOk, Telemetry::tick () - projStart);
+      if (!projOk) {
         HPP_STOP_TIMECOUNTER (applyConstraints);
         es.addFailure (reasons_[PROJECTION]);
         status.status = PROJECTION;
@@ -369,14 +373,18 @@ namespace hpp {
 
       HPP_START_TIMECOUNTER (validatePath);
       bool fullyValid = false;
-      try {
-        fullyValid = pathValidation->validate
-          (projPath, false, fullValidPath, status.validationReport);
-      } catch (const core::projection_error& e) {
-        hppDout (error, e.what ());
-        es.addFailure (reasons_[PATH_VALIDATION_ZERO]);
-        status.status = PATH_VALIDATION_ZERO;
-        return false;
+      {
+        Telemetry::ScopedPhase telValidate (telemetry_, 0,
+            Telemetry::PATH_VALIDATION);
+        try {
+          fullyValid = pathValidation->validate
+            (projPath, false, fullValidPath, status.validationReport);
+        } catch (const core::projection_error& e) {
+          hppDout (error, e.what ());
+          es.addFailure (reasons_[PATH_VALIDATION_ZERO]);
+          status.status = PATH_VALIDATION_ZERO;
+          return false;
+        }
       }
       HPP_STOP_TIMECOUNTER (validatePath);
 
@@ -443,11 +451,18 @@ namespace hpp {
           itn1 != nodes.end (); ++itn1) {
         ConfigurationPtr_t q1 ((*itn1)->configuration ());
         connectSucceed = false;
+        // Components already holding this exact configuration are
+        // skipped, through the hash index of the roadmap.
+        const RoadmapNodePtr_t duplicate =
+          roadmap_->nodeWithConfiguration (*q1);
         for (core::ConnectedComponents_t::const_iterator itcc =
             roadmap ()->connectedComponents ().begin ();
             itcc != roadmap ()->connectedComponents ().end (); ++itcc) {
           if (*itcc == (*itn1)->connectedComponent ())
             continue;
+          if (duplicate && duplicate != *itn1 &&
+              duplicate->connectedComponent () == *itcc)
+            continue;
           core::Nodes_t knearest = roadmap()->nearestNeighbor ()
             ->KnearestSearch (q1, *itcc, K, distance);
           for (core::Nodes_t::const_iterator itn2 = knearest.begin ();
@@ -637,6 +652,10 @@ namespace hpp {
           oldWSC->weight_ *= weightDec;
           break;
       }
+      // Reposition the updated components in the weight-ordered index of
+      // the roadmap.
+      roadmap_->updateSymbolicComponent (oldWSC);
+      if (newN) roadmap_->updateSymbolicComponent (newN->symbolicComponent ());
     }
 
     void SymbolicPlanner::updateEdgeProba (
@@ -657,6 +676,8 @@ namespace hpp {
       shooter_ (problem.configurationShooter()),
       problem_ (problem), roadmap_ (roadmap),
       extendStep_ (1),
+      targetedSampling_ (problem.getParameter<value_type>
+          ("SymbolicPlanner/TargetedSampling", 0)),
       qProj_ (problem.robot ()->configSize ())
     {}
 
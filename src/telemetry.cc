@@ -0,0 +1,168 @@
+// Copyright (c) 2017, LAAS-CNRS
+// Authors: Joseph Mirabel (joseph.mirabel@laas.fr)
+//
+// This file is part of hpp-manipulation.
+// hpp-manipulation is free software: you can redistribute it
+// and/or modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation, either version
+// 3 of the License, or (at your option) any later version.
+//
+// hpp-manipulation is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Lesser Public License for more details.  You should have
+// received a copy of the GNU Lesser General Public License along with
+// hpp-manipulation. If not, see <http://www.gnu.org/licenses/>.
+
+#include <hpp/manipulation/telemetry.hh>
+
+#include <ostream>
+
+namespace hpp {
+  namespace manipulation {
+    Telemetry::Telemetry (const std::size_t nbWorkers) :
+      shards_ (nbWorkers < 1 ? 1 : nbWorkers)
+    {}
+
+    void Telemetry::nbWorkers (const std::size_t nbWorkers)
+    {
+      if (shards_.size () < nbWorkers) shards_.resize (nbWorkers);
+    }
+
+    void Telemetry::record (const std::size_t rank, const Phase phase,
+        const counter_t cycles)
+    {
+      PhaseCounter& c = shards_[rank].phases[phase];
+      ++c.events;
+      c.cycles += cycles;
+    }
+
+    void Telemetry::recordEdge (const std::size_t rank, const Phase phase,
+        const std::size_t edgeId, const bool success, const counter_t cycles)
+    {
+      Shard& shard = shards_[rank];
+      PhaseCounter& c = shard.phases[phase];
+      ++c.events;
+      c.cycles += cycles;
+      if (shard.edges.size () <= edgeId) shard.edges.resize (edgeId + 1);
+      EdgeCounter& e = shard.edges[edgeId];
+      if (success) ++e.successes; else ++e.failures;
+      e.cycles += cycles;
+      Event& ev = shard.ring[shard.ringHead];
+      ev.phase = phase;
+      ev.edgeId = edgeId;
+      ev.success = success;
+      ev.cycles = cycles;
+      shard.ringHead = (shard.ringHead + 1) % ringCapacity;
+      if (shard.ringSize < ringCapacity) ++shard.ringSize;
+    }
+
+    Telemetry::PhaseCounter Telemetry::phase (const Phase phase) const
+    {
+      PhaseCounter sum;
+      for (Shards_t::const_iterator it = shards_.begin ();
+          it != shards_.end (); ++it) {
+        sum.events += it->phases[phase].events;
+        sum.cycles += it->phases[phase].cycles;
+      }
+      return sum;
+    }
+
+    Telemetry::EdgeCounter Telemetry::edge (const std::size_t edgeId) const
+    {
+      EdgeCounter sum;
+      for (Shards_t::const_iterator it = shards_.begin ();
+          it != shards_.end (); ++it) {
+        if (it->edges.size () <= edgeId) continue;
+        sum.successes += it->edges[edgeId].successes;
+        sum.failures += it->edges[edgeId].failures;
+        sum.cycles += it->edges[edgeId].cycles;
+      }
+      return sum;
+    }
+
+    std::size_t Telemetry::nbEdges () const
+    {
+      std::size_t n = 0;
+      for (Shards_t::const_iterator it = shards_.begin ();
+          it != shards_.end (); ++it)
+        if (n < it->edges.size ()) n = it->edges.size ();
+      return n;
+    }
+
+    void Telemetry::recentEvents (std::vector <Event>& events) const
+    {
+      events.clear ();
+      for (Shards_t::const_iterator it = shards_.begin ();
+          it != shards_.end (); ++it) {
+        const std::size_t first = (it->ringSize < ringCapacity) ? 0
+          : it->ringHead;
+        for (std::size_t i = 0; i < it->ringSize; ++i)
+          events.push_back (it->ring[(first + i) % ringCapacity]);
+      }
+    }
+
+    void Telemetry::clear ()
+    {
+      const std::size_t n = shards_.size ();
+      shards_.clear ();
+      shards_.resize (n);
+    }
+
+    const char* Telemetry::phaseName (const Phase phase)
+    {
+      switch (phase) {
+        case ONE_STEP:        return "oneStep";
+        case EXTEND:          return "extend";
+        case PROJECTION:      return "projection";
+        case PATH_VALIDATION: return "pathValidation";
+        case TRY_CONNECT:     return "tryConnect";
+        default:              return "unknown";
+      }
+    }
+
+    std::ostream& Telemetry::writeJSON (std::ostream& os) const
+    {
+      os << "{\"phases\":[";
+      for (std::size_t p = 0; p < (std::size_t) NB_PHASES; ++p) {
+        const PhaseCounter c = phase ((Phase) p);
+        if (p > 0) os << ',';
+        os << "{\"name\":\"" << phaseName ((Phase) p)
+           << "\",\"events\":" << c.events
+           << ",\"cycles\":" << c.cycles << '}';
+      }
+      os << "],\"edges\":[";
+      bool firstEdge = true;
+      const std::size_t ne = nbEdges ();
+      for (std::size_t id = 0; id < ne; ++id) {
+        const EdgeCounter e = edge (id);
+        if (e.successes == 0 && e.failures == 0) continue;
+        if (!firstEdge) os << ',';
+        firstEdge = false;
+        os << "{\"id\":" << id
+           << ",\"successes\":" << e.successes
+           << ",\"failures\":" << e.failures
+           << ",\"cycles\":" << e.cycles << '}';
+      }
+      os << "]}";
+      return os;
+    }
+
+    std::ostream& Telemetry::writeCSV (std::ostream& os) const
+    {
+      for (std::size_t p = 0; p < (std::size_t) NB_PHASES; ++p) {
+        const PhaseCounter c = phase ((Phase) p);
+        os << "phase," << phaseName ((Phase) p) << ',' << c.events << ','
+           << c.cycles << '\n';
+      }
+      const std::size_t ne = nbEdges ();
+      for (std::size_t id = 0; id < ne; ++id) {
+        const EdgeCounter e = edge (id);
+        if (e.successes == 0 && e.failures == 0) continue;
+        os << "edge," << id << ',' << e.successes << ',' << e.failures
+           << ',' << e.cycles << '\n';
+      }
+      return os;
+    }
+  } // namespace manipulation
+} // namespace hpp
@@ -64,6 +64,16 @@ namespace hpp {
       weak_ = self;
     }
 
+    void WeighedDistance::distances (matrixIn_t qs,
+        const std::size_t nbCols, ConfigurationIn_t q, vectorOut_t ds) const
+    {
+      assert ((std::size_t) qs.cols () >= nbCols);
+      assert ((std::size_t) ds.size () >= nbCols);
+      for (std::size_t i = 0; i < nbCols; ++i)
+        ds[(size_type) i] =
+          core::WeighedDistance::impl_distance (qs.col ((size_type) i), q);
+    }
+
     value_type WeighedDistance::impl_distance (ConfigurationIn_t q1,
 					       ConfigurationIn_t q2) const
     {